@@ -96,6 +96,9 @@ public:
    SQL_FIELD *m_fields;               /* defined fields */
    bool m_allow_transactions;         /* transactions allowed */
    bool m_transaction;                /* transaction started */
+   uint64_t m_lock_wait;              /* time spent to get the lock (usec) */
+   uint64_t m_lock_max_wait;          /* longest time to get the lock (usec) */
+   uint32_t m_lock_waits;             /* locks that had to wait for another user */
 
    POOLMEM *cached_path;              /* cached path name */
    POOLMEM *cmd;                      /* SQL command string */
@@ -227,6 +230,7 @@ public:
    bool bdb_get_job_record(JCR *jcr, JOB_DBR *jr);
    int bdb_get_job_volume_names(JCR *jcr, JobId_t JobId, POOLMEM **VolumeNames);
    bool bdb_get_file_attributes_record(JCR *jcr, char *fname, JOB_DBR *jr, FILE_DBR *fdbr);
+   bool bdb_get_verify_file_list(JCR *jcr, JobId_t JobId, DB_RESULT_HANDLER *result_handler, void *ctx);
    int bdb_get_fileset_record(JCR *jcr, FILESET_DBR *fsr);
    bool bdb_get_media_record(JCR *jcr, MEDIA_DBR *mr);
    int bdb_get_num_media_records(JCR *jcr);
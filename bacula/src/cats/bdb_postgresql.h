@@ -21,11 +21,21 @@
 
 #ifdef __BDB_POSTGRESQL_H_
 
+/*
+ * In batch mode, the COPY rows are collected and sent to the
+ * server when we have this amount of data.
+ */
+#define PGSQL_BATCH_BUFFER_SIZE (256 * 1024)
+
 class BDB_POSTGRESQL: public BDB {
 private:
    PGconn *m_db_handle;
    PGresult *m_result;
    POOLMEM *m_buf;                /* Buffer to manipulate queries */
+   POOLMEM *m_batch_buf;          /* COPY rows not yet sent in batch mode */
+   int32_t m_batch_len;           /* length of the rows in m_batch_buf */
+
+   bool sql_batch_flush(void);
 
 public:
    BDB_POSTGRESQL();
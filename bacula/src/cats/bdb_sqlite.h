@@ -21,6 +21,15 @@
 
 #ifdef __BDB_SQLITE_H_
 
+/*
+ * Number of rows to batch-up in a single insert in batch
+ * insert mode, as done with MySQL. The query is also sent
+ * when it is bigger than SQLITE_BATCH_INSERT_SIZE to stay
+ * under the SQLite maximum statement length.
+ */
+#define SQLITE_CHANGES_PER_BATCH_INSERT 100
+#define SQLITE_BATCH_INSERT_SIZE (256 * 1024)
+
 class BDB_SQLITE: public BDB {
 private:
    struct sqlite3 *m_db_handle;
@@ -239,12 +239,6 @@ int Bvfs::set_jobids(char *ids)
 #define NITEMS 50000
 class pathid_cache {
 private:
-   hlink *nodes;
-   int nb_node;
-   int max_node;
-
-   alist *table_node;
-
    htable *cache_ppathid;
 
 public:
@@ -252,36 +246,24 @@ public:
       hlink link;
       cache_ppathid = (htable *)malloc(sizeof(htable));
       cache_ppathid->init(&link, &link, NITEMS);
-      max_node = NITEMS;
-      nodes = (hlink *) malloc(max_node * sizeof (hlink));
-      nb_node = 0;
-      table_node = New(alist(5, owned_by_alist));
-      table_node->append(nodes);
    };
 
-   hlink *get_hlink() {
-      if (++nb_node >= max_node) {
-         nb_node = 0;
-         nodes = (hlink *)malloc(max_node * sizeof(hlink));
-         table_node->append(nodes);
-      }
-      return nodes + nb_node;
-   };
-
-   bool lookup(char *pathid) {
-      bool ret = cache_ppathid->lookup(pathid) != NULL;
+   bool lookup(int64_t pathid) {
+      bool ret = cache_ppathid->lookup((uint64_t)pathid) != NULL;
       return ret;
    };
 
-   void insert(char *pathid) {
-      hlink *h = get_hlink();
-      cache_ppathid->insert(pathid, h);
+   /* The hlink is released with the table */
+   void insert(int64_t pathid) {
+      if (!lookup(pathid)) {
+         hlink *h = (hlink *)cache_ppathid->hash_malloc(sizeof(hlink));
+         cache_ppathid->insert((uint64_t)pathid, h);
+      }
    };
 
    ~pathid_cache() {
       cache_ppathid->destroy();
       free(cache_ppathid);
-      delete table_node;
    };
 private:
    pathid_cache(const pathid_cache &); /* prohibit pass by value */
@@ -348,73 +330,225 @@ char *bvfs_basename_dir(char *path)
    return p;
 }
 
-static void build_path_hierarchy(JCR *jcr, BDB *mdb,
+/* Number of items sent in a single statement by build_path_hierarchy() */
+#define BVFS_BATCH_NB 500
+
+/*
+ * Accumulate items in statements like "<head> item,item,...<tail>"
+ * and send them to the catalog every BVFS_BATCH_NB items
+ */
+class bvfs_batch {
+private:
+   JCR *jcr;
+   BDB *mdb;
+   POOL_MEM query;
+   const char *head;
+   const char *tail;
+   DB_RESULT_HANDLER *handler;
+   void *ctx;
+   int nb;
+
+public:
+   bvfs_batch(JCR *ajcr, BDB *amdb, const char *h, const char *t,
+              DB_RESULT_HANDLER *hdl = NULL, void *actx = NULL) {
+      jcr = ajcr;
+      mdb = amdb;
+      head = h;
+      tail = t;
+      handler = hdl;
+      ctx = actx;
+      nb = 0;
+   };
+
+   bool add(const char *item) {
+      if (nb == 0) {
+         pm_strcpy(query, head);
+      } else {
+         pm_strcat(query, ",");
+      }
+      pm_strcat(query, item);
+      if (++nb >= BVFS_BATCH_NB) {
+         return flush();
+      }
+      return true;
+   };
+
+   bool flush() {
+      if (nb == 0) {
+         return true;
+      }
+      nb = 0;
+      pm_strcat(query, tail);
+      Dmsg1(dbglevel_sql, "q=%s\n", query.c_str());
+      if (handler) {
+         return mdb->bdb_sql_query(query.c_str(), handler, ctx);
+      }
+      return mdb->QueryDB(jcr, query.c_str());
+   };
+};
+
+/* A directory and its parent in build_path_hierarchy() */
+struct bvfs_hdir {
+   hlink link;                  /* keyed by path */
+   int64_t pathid;              /* 0 if not yet known */
+   bvfs_hdir *parent;
+   bool queued;                 /* already in the next level */
+   char path[1];
+};
+
+static bvfs_hdir *bvfs_new_hdir(htable *dirs, char *path, int64_t pathid)
+{
+   int len = strlen(path);
+   bvfs_hdir *d = (bvfs_hdir *)dirs->hash_malloc(sizeof(bvfs_hdir) + len);
+   memset(d, 0, sizeof(bvfs_hdir));
+   memcpy(d->path, path, len + 1);
+   d->pathid = pathid;
+   dirs->insert(d->path, d);
+   return d;
+}
+
+/* Set the PathId of the directories returned by SELECT PathId, Path */
+static int bvfs_hdir_pathid_handler(void *ctx, int fields, char **row)
+{
+   htable *dirs = (htable *)ctx;
+   bvfs_hdir *d = (bvfs_hdir *)dirs->lookup(row[1]);
+   if (d) {
+      d->pathid = str_to_int64(row[0]);
+   }
+   return 0;
+}
+
+/* Cache the PathId returned by SELECT PathId FROM PathHierarchy */
+static int bvfs_hdir_cache_handler(void *ctx, int fields, char **row)
+{
+   pathid_cache *cache = (pathid_cache *)ctx;
+   cache->insert(str_to_int64(row[0]));
+   return 0;
+}
+
+/*
+ * Insert the PathHierarchy records of the directories in the todo list,
+ * and of their parents up to the first directory that is already
+ * in the PathHierarchy table.
+ *
+ * Instead of a few queries per directory, the work is done one level of
+ * the tree at a time with batched statements: one query to get the
+ * PathId of all the parents, one multi-row INSERT for the PathHierarchy
+ * records and one query to find the parents that are already known.
+ *
+ * The todo list is deleted.
+ */
+static bool build_path_hierarchy(JCR *jcr, BDB *mdb,
                                  pathid_cache &ppathid_cache,
-                                 char *org_pathid, char *path)
+                                 htable *dirs, alist *todo)
 {
-   Dmsg1(dbglevel, "build_path_hierarchy(%s)\n", path);
-   char pathid[50];
+   POOL_MEM tmp, esc;
    ATTR_DBR parent;
+   bvfs_hdir *d, *p;
+   alist *next = NULL;
    char *bkp = mdb->path;
-   bstrncpy(pathid, org_pathid, sizeof(pathid));
+   char ed1[50];
+   bool ret = false;
+   int len;
 
-   /* Does the ppathid exist for this ? we use a memory cache...  In order to
-    * avoid the full loop, we consider that if a dir is allready in the
-    * PathHierarchy table, then there is no need to calculate all the
-    * hierarchy
-    */
-   while (path && *path)
-   {
-      if (!ppathid_cache.lookup(pathid))
-      {
-         Mmsg(mdb->cmd,
-              "SELECT PPathId FROM PathHierarchy WHERE PathId = %s",
-              pathid);
-
-         if (!mdb->QueryDB(jcr, mdb->cmd)) {
-            goto bail_out;      /* Query failed, just leave */
+   bvfs_batch get_pathid(jcr, mdb, "SELECT PathId, Path FROM Path WHERE Path IN (",
+                         ")", bvfs_hdir_pathid_handler, dirs);
+   bvfs_batch ins_hierarchy(jcr, mdb,
+                            "INSERT INTO PathHierarchy (PathId, PPathId) VALUES ",
+                            "");
+   bvfs_batch get_hierarchy(jcr, mdb,
+                            "SELECT PathId FROM PathHierarchy WHERE PathId IN (",
+                            ")", bvfs_hdir_cache_handler, &ppathid_cache);
+
+   while (todo->size() > 0) {
+      Dmsg1(dbglevel, "build_path_hierarchy() %d dirs\n", todo->size());
+      alist unknown(100, not_owned_by_alist);
+      next = New(alist(100, not_owned_by_alist));
+
+      /* Find the parent of each directory of this level */
+      foreach_alist(d, todo) {
+         pm_strcpy(tmp, d->path);
+         bvfs_parent_dir(tmp.c_str());
+         p = (bvfs_hdir *)dirs->lookup(tmp.c_str());
+         if (!p) {
+            p = bvfs_new_hdir(dirs, tmp.c_str(), 0);
+            len = strlen(p->path);
+            esc.check_size(2 * len + 3);
+            esc.c_str()[0] = '\'';
+            mdb->bdb_escape_string(jcr, esc.c_str() + 1, p->path, len);
+            pm_strcat(esc, "'");
+            if (!get_pathid.add(esc.c_str())) {
+               goto bail_out;
+            }
+            unknown.append(p);
          }
+         d->parent = p;
+      }
+      if (!get_pathid.flush()) {
+         goto bail_out;
+      }
 
-         /* Do we have a result ? */
-         if (mdb->sql_num_rows() > 0) {
-            ppathid_cache.insert(pathid);
-            /* This dir was in the db ...
-             * It means we can leave, the tree has allready been built for
-             * this dir
-             */
-            goto bail_out;
-         } else {
-            /* search or create parent PathId in Path table */
-            mdb->path = bvfs_parent_dir(path);
-            mdb->pnl = strlen(mdb->path);
+      /* Create the parents that are not yet in the Path table */
+      foreach_alist(p, &unknown) {
+         if (p->pathid == 0) {
+            mdb->path = p->path;
+            mdb->pnl = strlen(p->path);
             if (!mdb->bdb_create_path_record(jcr, &parent)) {
                goto bail_out;
             }
-            ppathid_cache.insert(pathid);
+            p->pathid = parent.PathId;
+         }
+      }
 
-            Mmsg(mdb->cmd,
-                 "INSERT INTO PathHierarchy (PathId, PPathId) "
-                 "VALUES (%s,%lld)",
-                 pathid, (uint64_t) parent.PathId);
+      foreach_alist(d, todo) {
+         Mmsg(tmp, "(%lld,%lld)", d->pathid, d->parent->pathid);
+         if (!ins_hierarchy.add(tmp.c_str())) {
+            goto bail_out;
+         }
+         ppathid_cache.insert(d->pathid);
+      }
+      if (!ins_hierarchy.flush()) {
+         goto bail_out;
+      }
 
-            if (!mdb->InsertDB(jcr, mdb->cmd)) {
-               goto bail_out;   /* Can't insert the record, just leave */
+      /* If a parent is already in the PathHierarchy table, the tree
+       * has already been built for this directory
+       */
+      foreach_alist(d, todo) {
+         p = d->parent;
+         if (*p->path && !p->queued && !ppathid_cache.lookup(p->pathid)) {
+            p->queued = true;
+            if (!get_hierarchy.add(edit_int64(p->pathid, ed1))) {
+               goto bail_out;
             }
-
-            edit_uint64(parent.PathId, pathid);
-            path = mdb->path;   /* already done */
+            next->append(p);
          }
-      } else {
-         /* It's already in the cache.  We can leave, no time to waste here,
-          * all the parent dirs have allready been done
-          */
+      }
+      if (!get_hierarchy.flush()) {
          goto bail_out;
       }
+
+      /* The parents that are still unknown are the next level */
+      delete todo;
+      todo = New(alist(100, not_owned_by_alist));
+      foreach_alist(p, next) {
+         if (!ppathid_cache.lookup(p->pathid)) {
+            todo->append(p);
+         }
+      }
+      delete next;
+      next = NULL;
    }
+   ret = true;
 
 bail_out:
+   if (next) {
+      delete next;
+   }
+   delete todo;
    mdb->path = bkp;
    mdb->fnl = 0;
+   return ret;
 }
 
 /*
@@ -485,29 +619,31 @@ static int update_path_hierarchy_cache(JCR *jcr,
       goto bail_out;
    }
 
-   /* TODO: I need to reuse the DB connection without emptying the result
-    * So, now i'm copying the result in memory to be able to query the
-    * catalog descriptor again.
+   /* The rows are copied in memory to be able to query the catalog
+    * descriptor again.
     */
    num = mdb->sql_num_rows();
    if (num > 0) {
-      char **result = (char **)malloc (num * 2 * sizeof(char *));
-
+      bvfs_hdir *d = NULL;
+      htable *dirs = (htable *)malloc(sizeof(htable));
+      alist *todo = New(alist(1000, not_owned_by_alist));
       SQL_ROW row;
-      int i=0;
+      bool ok;
+
+      dirs->init(d, &d->link, num * 2);
       while((row = mdb->sql_fetch_row())) {
-         result[i++] = bstrdup(row[0]);
-         result[i++] = bstrdup(row[1]);
+         int64_t pathid = str_to_int64(row[0]);
+         if (*row[1] && !ppathid_cache.lookup(pathid)) {
+            todo->append(bvfs_new_hdir(dirs, row[1], pathid));
+         }
       }
-
-      i=0;
-      while (num > 0) {
-         build_path_hierarchy(jcr, mdb, ppathid_cache, result[i], result[i+1]);
-         free(result[i++]);
-         free(result[i++]);
-         num--;
+      ok = build_path_hierarchy(jcr, mdb, ppathid_cache, dirs, todo);
+      dirs->destroy();
+      free(dirs);
+      if (!ok) {
+         Dmsg1(dbglevel, "Can't build PathHierarchy %d\n", (uint32_t)JobId);
+         goto bail_out;
       }
-      free(result);
    }
 
    if (mdb->bdb_get_type_index() == SQL_TYPE_SQLITE3) {
@@ -600,20 +736,20 @@ void Bvfs::fv_update_cache()
    db->bdb_unlock();
 }
 
-/* Not yet working */
+/* Not yet working
+ *
+ * The size cannot be filtered with SQL, the LStat field may be in
+ * the compact form (CompactLStat), that base64_decode_lstat() does
+ * not know. The rows must be decoded with decode_stat() and filtered
+ * with min_size and limit by the caller.
+ */
 void Bvfs::fv_get_big_files(int64_t pathid, int64_t min_size, int32_t limit)
 {
    Mmsg(db->cmd,
-        "SELECT S.Filename AS filename, S.size "
-          "FROM ( "
-         "SELECT Filename, base64_decode_lstat(8,LStat) AS size "
-           "FROM File "
-          "WHERE PathId  = %lld "
-            "AND JobId = %s "
-        ") AS S "
-     "WHERE S.size > %lld "
-     "ORDER BY S.size DESC "
-     "LIMIT %d ", pathid, jobids, min_size, limit);
+        "SELECT Filename AS filename, LStat AS lstat "
+          "FROM File "
+         "WHERE PathId  = %lld "
+           "AND JobId = %s ", pathid, jobids);
 }
 
 /* Get the current path size and files count */
@@ -639,27 +775,50 @@ void Bvfs::fv_get_current_size_and_count(int64_t pathid, int64_t *size, int64_t
    }
 }
 
-/* Compute for the current path the size and files count */
+struct size_and_count {
+   int64_t size;
+   int64_t count;
+};
+
+/* Add the st_size of each LStat field */
+static int size_and_count_handler(void *ctx, int fields, char **row)
+{
+   size_and_count *sc = (size_and_count *)ctx;
+   struct stat statp;
+   int32_t LinkFI;
+
+   if (row[0] && row[0][0]) {
+      memset(&statp, 0, sizeof(statp));
+      decode_stat(row[0], &statp, sizeof(statp), &LinkFI);
+      sc->size += statp.st_size;
+   }
+   sc->count++;
+   return 0;
+}
+
+/* Compute for the current path the size and files count
+ *
+ * The size is decoded here and not with the base64_decode_lstat()
+ * SQL function, because LStat may be in the compact form.
+ */
 void Bvfs::fv_get_size_and_count(int64_t pathid, int64_t *size, int64_t *count)
 {
-   SQL_ROW row;
+   size_and_count sc = {0, 0};
 
    *size = *count = 0;
 
    Mmsg(db->cmd,
- "SELECT sum(base64_decode_lstat(8,LStat)) AS size, count(1) AS files "
+ "SELECT LStat "
   " FROM File "
  " WHERE PathId = %lld "
    " AND JobId = %s ", pathid, jobids);
 
-   if (!db->QueryDB(jcr, db->cmd)) {
+   if (!db->bdb_sql_query(db->cmd, size_and_count_handler, &sc)) {
       return;
    }
 
-   if ((row = db->sql_fetch_row())) {
-      *size = str_to_int64(row[0]);
-      *count =  str_to_int64(row[1]);
-   }
+   *size = sc.size;
+   *count = sc.count;
 }
 
 void Bvfs::fv_compute_size_and_count(int64_t pathid, int64_t *size, int64_t *count)
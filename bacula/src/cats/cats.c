@@ -101,12 +101,23 @@ void BDB::bdb_lock(const char *file, int line)
 { 
    int errstat; 
    BDB *mdb = this; 
+   btime_t start = get_current_btime();
+   uint64_t wait;
  
    if ((errstat = rwl_writelock_p(&mdb->m_lock, file, line)) != 0) { 
       berrno be; 
       e_msg(file, line, M_FATAL, 0, "rwl_writelock failure. stat=%d: ERR=%s\n", 
             errstat, be.bstrerror(errstat)); 
    } 
+   /* Time spent behind the other users of a shared connection */
+   wait = get_current_btime() - start;
+   mdb->m_lock_wait += wait;
+   if (wait > mdb->m_lock_max_wait) {
+      mdb->m_lock_max_wait = wait;
+   }
+   if (wait >= 1000) {
+      mdb->m_lock_waits++;
+   }
 } 
  
 /* 
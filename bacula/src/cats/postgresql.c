@@ -95,6 +95,8 @@ BDB_POSTGRESQL::BDB_POSTGRESQL(): BDB()
    mdb->m_db_handle = NULL;
    mdb->m_result = NULL;
    mdb->m_buf =  get_pool_memory(PM_FNAME);
+   mdb->m_batch_buf = get_pool_memory(PM_MESSAGE);
+   mdb->m_batch_len = 0;
 
    db_list->append(this);
 }
@@ -390,6 +392,7 @@ void BDB_POSTGRESQL::bdb_close_database(JCR *jcr)
       free_pool_memory(mdb->esc_path);
       free_pool_memory(mdb->esc_obj);
       free_pool_memory(mdb->m_buf);
+      free_pool_memory(mdb->m_batch_buf);
       if (mdb->m_db_driver) {
          free(mdb->m_db_driver);
       } 
@@ -1050,6 +1053,7 @@ bool BDB_POSTGRESQL::sql_batch_start(JCR *jcr)
    mdb->m_num_rows     = -1;
    mdb->m_row_number   = -1;
    mdb->m_field_number = -1;
+   mdb->m_batch_len    = 0;
 
    sql_free_result(); 
 
@@ -1096,10 +1100,20 @@ bool BDB_POSTGRESQL::sql_batch_end(JCR *jcr, const char *error)
    int res;
    int count=30;
    PGresult *p_result;
+   POOL_MEM flush_error;
    BDB_POSTGRESQL *mdb = this;
 
    Dmsg0(dbglvl_info, "sql_batch_end started\n");
 
+   /* Send the rows that are still in our buffer, abort the COPY
+    *  if they cannot be sent.
+    */
+   if (!error && !sql_batch_flush()) {
+      pm_strcpy(flush_error, mdb->errmsg);
+      error = flush_error.c_str();
+   }
+   mdb->m_batch_len = 0;
+
    do {
       res = PQputCopyEnd(mdb->m_db_handle, error);
    } while (res == 0 && --count > 0);
@@ -1127,14 +1141,18 @@ bool BDB_POSTGRESQL::sql_batch_end(JCR *jcr, const char *error)
 
    PQclear(p_result);
 
+   /* Some rows were not sent, the batch table is not complete */
+   if (*flush_error.c_str()) {
+      pm_strcpy(mdb->errmsg, flush_error);
+      return false;
+   }
+
    Dmsg0(dbglvl_info, "sql_batch_end finishing\n");
    return true; 
 }
 
 bool BDB_POSTGRESQL::sql_batch_insert(JCR *jcr, ATTR_DBR *ar)
 {
-   int res;
-   int count=30;
    size_t len;
    const char *digest;
    char ed1[50];
@@ -1156,13 +1174,46 @@ bool BDB_POSTGRESQL::sql_batch_insert(JCR *jcr, ATTR_DBR *ar)
               ar->FileIndex, edit_int64(ar->JobId, ed1), mdb->esc_path,
               mdb->esc_name, ar->attr, digest, ar->DeltaSeq);
 
+   /*
+    * Keep the row with the previous ones, sending each row with
+    *  PQputCopyData() costs more than the COPY itself.
+    */
+   mdb->m_batch_buf = check_pool_memory_size(mdb->m_batch_buf, mdb->m_batch_len + len + 1);
+   memcpy(mdb->m_batch_buf + mdb->m_batch_len, mdb->cmd, len);
+   mdb->m_batch_len += len;
+   mdb->changes++;
+
+   if (mdb->m_batch_len >= PGSQL_BATCH_BUFFER_SIZE && !sql_batch_flush()) {
+      return false;
+   }
+
+   Dmsg0(dbglvl_info, "sql_batch_insert finishing\n");
+
+   return true; 
+}
+
+/*
+ * Send the COPY rows collected by sql_batch_insert()
+ */
+bool BDB_POSTGRESQL::sql_batch_flush(void)
+{
+   int res = 1;
+   int count=30;
+   BDB_POSTGRESQL *mdb = this;
+
+   if (mdb->m_batch_len == 0) {
+      return true;
+   }
+
    do {
-      res = PQputCopyData(mdb->m_db_handle, mdb->cmd, len);
+      res = PQputCopyData(mdb->m_db_handle, mdb->m_batch_buf, mdb->m_batch_len);
    } while (res == 0 && --count > 0);
 
+   Dmsg1(dbglvl_dbg, "sent %d bytes\n", mdb->m_batch_len);
+   mdb->m_batch_len = 0;
+
    if (res == 1) {
       Dmsg0(dbglvl_dbg, "ok\n");
-      mdb->changes++;
       mdb->m_status = 1;
    }
 
@@ -1170,11 +1221,9 @@ bool BDB_POSTGRESQL::sql_batch_insert(JCR *jcr, ATTR_DBR *ar)
       mdb->m_status = 0;
       Mmsg1(&mdb->errmsg, _("error copying in batch mode: %s"), PQerrorMessage(mdb->m_db_handle));
       Dmsg1(dbglvl_err, "failure %s\n", mdb->errmsg);
+      return false;
    }
-
-   Dmsg0(dbglvl_info, "sql_batch_insert finishing\n");
-
-   return true; 
+   return true;
 }
 
 
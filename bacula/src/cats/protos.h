@@ -89,6 +89,10 @@ int db_int_handler(void *ctx, int num_fields, char **row);
 void bdb_debug_print(JCR *jcr, FILE *fp);
 void db_free_restoreobject_record(JCR *jcr, ROBJECT_DBR *rr);
 
+/* Set by the Director to take the batch connection from a pool */
+typedef void (*db_batch_connection_handler)(JCR *jcr);
+extern db_batch_connection_handler p_db_batch_connection;
+
 #define db_open_batch_connexion(jcr, mdb) \
            mdb->bdb_open_batch_connexion(jcr)
 #define db_strerror(mdb) \
@@ -208,6 +212,8 @@ void bdb_free_restoreobject_record(JCR *jcr, ROBJECT_DBR *rr);
            mdb->bdb_get_job_volume_names(jcr, JobId, VolumeNames)
 #define db_get_file_attributes_record(jcr, mdb, fname, jr, fdbr) \
            mdb->bdb_get_file_attributes_record(jcr, fname, jr, fdbr)
+#define db_get_verify_file_list(jcr, mdb, JobId, result_handler, ctx) \
+           mdb->bdb_get_verify_file_list(jcr, JobId, result_handler, ctx)
 #define db_get_fileset_record(jcr, mdb, fsr) \
            mdb->bdb_get_fileset_record(jcr, fsr)
 #define db_get_media_record(jcr, mdb, mr) \
@@ -42,6 +42,9 @@
 /* Forward referenced subroutines */ 
 void print_dashes(BDB *mdb); 
 void print_result(BDB *mdb); 
+
+/* Gives jcr->db_batch from a pool of connections, if any */
+db_batch_connection_handler p_db_batch_connection = NULL;
  
 dbid_list::dbid_list() 
 { 
@@ -169,6 +172,8 @@ static int db_max_connections_handler(void *ctx, int num_fields, char **row)
 
 BDB::BDB()
 {
+   m_lock_wait = m_lock_max_wait = 0;
+   m_lock_waits = 0;
    init_acl();
    acl_join = get_pool_memory(PM_MESSAGE);
    acl_where = get_pool_memory(PM_MESSAGE);
@@ -1023,6 +1028,9 @@ bool BDB::bdb_open_batch_connexion(JCR *jcr)
  
    multi_db = batch_insert_available(); 
  
+   if (!jcr->db_batch && p_db_batch_connection) { 
+      p_db_batch_connection(jcr); 
+   } 
    if (!jcr->db_batch) { 
       jcr->db_batch = bdb_clone_database_connection(jcr, multi_db); 
       if (!jcr->db_batch) { 
@@ -179,6 +179,33 @@ bool BDB::bdb_get_file_record(JCR *jcr, JOB_DBR *jr, FILE_DBR *fdbr)
 
 }
 
+/*
+ * Send all the File records of a Job to the result_handler with
+ *  a single query, so that a Verify can compare them in memory
+ *  instead of looking up each file.
+ *
+ * The fields are Path, Filename, FileIndex, LStat, MD5
+ *
+ *  Returns: false on failure
+ *           true on success
+ */
+bool BDB::bdb_get_verify_file_list(JCR *jcr, JobId_t JobId,
+                                   DB_RESULT_HANDLER *result_handler, void *ctx)
+{
+   char ed1[50];
+   POOL_MEM buf(PM_MESSAGE);
+
+   Mmsg(buf,
+"SELECT Path.Path, File.Filename, File.FileIndex, File.LStat, File.MD5 "
+  "FROM File JOIN Path ON (Path.PathId = File.PathId) "
+ "WHERE File.JobId=%s AND File.FileIndex > 0",
+        edit_int64(JobId, ed1));
+
+   Dmsg1(100, "q=%s\n", buf.c_str());
+
+   return bdb_big_sql_query(buf.c_str(), result_handler, ctx);
+}
+
 /**
  * Get path record
  * Returns: 0 on failure
@@ -701,6 +701,11 @@ bool BDB_SQLITE::sql_batch_start(JCR *jcr)
                    "MD5 tinyblob,"
                    "DeltaSeq integer)"); 
    bdb_unlock(); 
+
+   /*
+    * Keep track of the number of rows in the pending insert.
+    */
+   changes = 0;
  
    return ret; 
 }  
@@ -713,6 +718,16 @@ bool BDB_SQLITE::sql_batch_start(JCR *jcr)
 bool BDB_SQLITE::sql_batch_end(JCR *jcr, const char *error) 
 {  
    m_status = 0; 
+
+   /*
+    * Flush any pending inserts.
+    */
+   if (changes) {
+      changes = 0;
+      if (!error) {
+         return sql_query(cmd);
+      }
+   }
    return true; 
 }  
  
@@ -724,6 +739,7 @@ bool BDB_SQLITE::sql_batch_insert(JCR *jcr, ATTR_DBR *ar)
 {  
    BDB_SQLITE *mdb = this; 
    const char *digest; 
+   int len;
    char ed1[50]; 
  
    mdb->esc_name = check_pool_memory_size(mdb->esc_name, mdb->fnl*2+1); 
@@ -738,12 +754,36 @@ bool BDB_SQLITE::sql_batch_insert(JCR *jcr, ATTR_DBR *ar)
       digest = ar->Digest; 
    } 
  
-   Mmsg(mdb->cmd, "INSERT INTO batch VALUES " 
-        "(%d,%s,'%s','%s','%s','%s',%u)", 
-        ar->FileIndex, edit_int64(ar->JobId,ed1), mdb->esc_path, 
-        mdb->esc_name, ar->attr, digest, ar->DeltaSeq); 
- 
-   return sql_query(mdb->cmd); 
+   /*
+    * Batch up the rows using multi-row inserts.
+    */
+   if (mdb->changes == 0) {
+      len = Mmsg(mdb->cmd, "INSERT INTO batch VALUES " 
+           "(%d,%s,'%s','%s','%s','%s',%u)", 
+           ar->FileIndex, edit_int64(ar->JobId,ed1), mdb->esc_path, 
+           mdb->esc_name, ar->attr, digest, ar->DeltaSeq); 
+   } else {
+      /*
+       * We use the esc_obj for temporary storage otherwise
+       * we keep on copying data.
+       */
+      Mmsg(mdb->esc_obj, ",(%d,%s,'%s','%s','%s','%s',%u)",
+           ar->FileIndex, edit_int64(ar->JobId,ed1), mdb->esc_path,
+           mdb->esc_name, ar->attr, digest, ar->DeltaSeq);
+      len = pm_strcat(mdb->cmd, mdb->esc_obj);
+   }
+   mdb->changes++;
+
+   /*
+    * See if we need to flush the query buffer filled
+    * with multi-row inserts.
+    */
+   if (mdb->changes >= SQLITE_CHANGES_PER_BATCH_INSERT ||
+       len >= SQLITE_BATCH_INSERT_SIZE) {
+      mdb->changes = 0;
+      return sql_query(mdb->cmd);
+   }
+   return true;
 }  
 
 /* Implementation of the REGEXP function for SQLite3 */
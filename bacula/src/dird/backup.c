@@ -34,6 +34,7 @@
 #include "bacula.h"
 #include "dird.h"
 #include "ua.h"
+#include "findlib/find.h"
 
 
 /* Commands sent to File daemon */
@@ -163,6 +164,8 @@ static bool get_base_jobids(JCR *jcr, db_list_ctx *jobids)
 static int accurate_list_handler(void *ctx, int num_fields, char **row)
 {
    JCR *jcr = (JCR *)ctx;
+   char buf[MAXSTRING];
+   char *lstat;
 
    if (job_canceled(jcr)) {
       return 1;
@@ -172,6 +175,9 @@ static int accurate_list_handler(void *ctx, int num_fields, char **row)
       return 0;
    }
 
+   /* The File daemon knows only the space separated format */
+   lstat = uncompact_stat(row[4], buf);
+
    /* sending with checksum */
    if (jcr->use_accurate_chksum
        && num_fields == 7
@@ -179,10 +185,10 @@ static int accurate_list_handler(void *ctx, int num_fields, char **row)
        && row[6][1])
    {
       jcr->file_bsock->fsend("%s%s%c%s%c%s%c%s",
-                             row[0], row[1], 0, row[4], 0, row[6], 0, row[5]);
+                             row[0], row[1], 0, lstat, 0, row[6], 0, row[5]);
    } else {
       jcr->file_bsock->fsend("%s%s%c%s%c%c%s",
-                             row[0], row[1], 0, row[4], 0, 0, row[5]);
+                             row[0], row[1], 0, lstat, 0, 0, row[5]);
    }
    return 0;
 }
@@ -340,7 +346,8 @@ bool send_accurate_current_files(JCR *jcr)
       }
    }
 
-   /* TODO: close the batch connection ? (can be used very soon) */
+   /* The attributes will take it again when they come */
+   release_batch_connection(jcr);
    jcr->file_bsock->signal(BNET_EOD);
    return true;
 }
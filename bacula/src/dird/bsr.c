@@ -29,6 +29,7 @@
 
 #include "bacula.h"
 #include "dird.h"
+#include "findlib/find.h"
 
 /* Forward referenced functions */
 static uint32_t write_bsr(UAContext *ua, RESTORE_CTX &rx, FILE *fd);
@@ -611,6 +612,8 @@ void add_findex_all(rblist *bsr_list, uint32_t JobId, const char *fileregex)
 static int sendit(void *arg, int num_fields, char **row)
 {
    JCR *jcr = (JCR *)arg;
+   char buf[MAXSTRING];
+   char *lstat;
 
    if (job_canceled(jcr)) {
       return 1;
@@ -620,16 +623,19 @@ static int sendit(void *arg, int num_fields, char **row)
       return 0;
    }
 
+   /* The File daemon knows only the space separated format */
+   lstat = uncompact_stat(row[4], buf);
+
    /* sending with checksum */
    if (num_fields == 7
        && row[6][0] /* skip checksum = '0' */
        && row[6][1])
    {
       jcr->file_bsock->fsend("%s%s%c%s%c%s%c%s",
-                             row[0], row[1], 0, row[4], 0, row[6], 0, row[5]);
+                             row[0], row[1], 0, lstat, 0, row[6], 0, row[5]);
    } else {
       jcr->file_bsock->fsend("%s%s%c%s%c%c%s",
-                             row[0], row[1], 0, row[4], 0, 0, row[5]);
+                             row[0], row[1], 0, lstat, 0, 0, row[5]);
    }
    return 0;
 }
@@ -0,0 +1,374 @@
+/*
+   Bacula(R) - The Network Backup Solution
+
+   Copyright (C) 2000-2020 Kern Sibbald
+
+   The original author of Bacula is Kern Sibbald, with contributions
+   from many others, a complete list can be found in the file AUTHORS.
+
+   You may use this file and others of this release according to the
+   license defined in the LICENSE file, which includes the Affero General
+   Public License, v3.0 ("AGPLv3") and some additional permissions and
+   terms pursuant to its AGPLv3 Section 7.
+
+   This notice must be preserved when any source code is
+   conveyed and/or propagated.
+
+   Bacula(R) is a registered trademark of Kern Sibbald.
+*/
+/*
+ *   Bacula Director -- Pools of catalog connections
+ *
+ *     The connections to a Catalog can be split by purpose, so the
+ *     consoles browsing the catalog and the attribute inserts do not
+ *     wait behind the job bookkeeping:
+ *
+ *      - "Job Connections": connections shared by the jobs, each
+ *        new job uses the connection that has the fewest users.
+ *      - "Console Connections": the same for the consoles.
+ *      - "Batch Connections": connections used by one job at a time
+ *        to insert the attributes or to read the accurate file list,
+ *        they stay open between the jobs and a job waits when all of
+ *        them are in use.
+ *
+ *     When a size is 0, or with "Multiple Connections", the previous
+ *     behavior is kept and the callers open the connection themselves.
+ */
+
+#include "bacula.h"
+#include "dird.h"
+
+static const int dbglvl = 100;
+
+static const char *pool_names[CAT_POOL_NUM] = { "job", "console", "batch" };
+
+struct pool_conn {
+   BDB *db;
+   int users;                         /* jobs or consoles using it */
+};
+
+struct cat_pool {
+   pool_conn *conns;
+   int nb;                            /* connections opened */
+   int size;                          /* size of conns */
+   int opening;                       /* connections being opened */
+   int max;                           /* size of the pool in the configuration */
+   uint64_t requests;                 /* connections given */
+   uint64_t waits;                    /* requests that had to wait */
+   uint64_t wait_time;                /* total time waited (usec) */
+   uint64_t max_wait;                 /* longest wait (usec) */
+};
+
+struct cat_pools {
+   dlink link;
+   char catalog[MAX_NAME_LENGTH];     /* Catalog resource name */
+   cat_pool pool[CAT_POOL_NUM];
+};
+
+static pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t pool_cond = PTHREAD_COND_INITIALIZER;
+static dlist *pools = NULL;           /* protected by pool_mutex */
+
+static int get_pool_size(CAT *catalog, int kind)
+{
+   if (catalog->mult_db_connections) {
+      return 0;                       /* one connection per user already */
+   }
+   switch (kind) {
+   case CAT_POOL_JOB:
+      return catalog->job_connections;
+   case CAT_POOL_CONSOLE:
+      return catalog->console_connections;
+   case CAT_POOL_BATCH:
+      return catalog->disable_batch_insert ? 0 : catalog->batch_connections;
+   }
+   return 0;
+}
+
+/*
+ * Find the pools of a catalog, must be called with pool_mutex locked
+ */
+static cat_pools *get_pools(const char *name)
+{
+   cat_pools *item = NULL;
+
+   if (!pools) {
+      pools = New(dlist(item, &item->link));
+   }
+   foreach_dlist(item, pools) {
+      if (strcmp(item->catalog, name) == 0) {
+         return item;
+      }
+   }
+   item = (cat_pools *)malloc(sizeof(cat_pools));
+   memset(item, 0, sizeof(cat_pools));
+   bstrncpy(item->catalog, name, sizeof(item->catalog));
+   pools->append(item);
+   return item;
+}
+
+static BDB *open_pool_connection(JCR *jcr, CAT *catalog, int kind)
+{
+   BDB *db;
+
+   db = db_init_database(jcr, catalog->db_driver, catalog->db_name,
+                         catalog->db_user, catalog->db_password,
+                         catalog->db_address, catalog->db_port,
+                         catalog->db_socket, catalog->db_ssl_mode,
+                         catalog->db_ssl_key, catalog->db_ssl_cert,
+                         catalog->db_ssl_ca, catalog->db_ssl_capath,
+                         catalog->db_ssl_cipher,
+                         true /* not shared with the other users */,
+                         catalog->disable_batch_insert);
+   if (!db || !db_open_database(jcr, db)) {
+      Jmsg(jcr, M_WARNING, 0, _("Could not open a %s connection to the catalog \"%s\". ERR=%s"),
+           pool_names[kind], catalog->db_name, db ? db_strerror(db) : "\n");
+      if (db) {
+         db_close_database(jcr, db);
+      }
+      return NULL;
+   }
+   /* The job and console connections are shared, like the default one */
+   if (kind != CAT_POOL_BATCH) {
+      db->m_allow_transactions = false;
+   }
+   Dmsg2(dbglvl, "Opened %s connection %p\n", pool_names[kind], db);
+   return db;
+}
+
+/*
+ * Get a connection of a pool
+ *
+ *  Returns: the connection to use
+ *           NULL if there is no pool for this purpose, the caller
+ *                opens a connection as usual in this case
+ */
+BDB *acquire_catalog_connection(JCR *jcr, CAT *catalog, int kind)
+{
+   struct timespec timeout;
+   cat_pool *p;
+   BDB *db = NULL;
+   btime_t start = 0;
+   uint64_t wait;
+   int max, i, best;
+
+   if (!catalog || (max = get_pool_size(catalog, kind)) == 0) {
+      return NULL;
+   }
+   P(pool_mutex);
+   p = &get_pools(catalog->name())->pool[kind];
+   p->max = max;
+   for ( ;; ) {
+      /* A free connection, or the one with the fewest users */
+      best = -1;
+      for (i = 0; i < p->nb; i++) {
+         if (best < 0 || p->conns[i].users < p->conns[best].users) {
+            best = i;
+         }
+      }
+      if (best >= 0 && (p->conns[best].users == 0 ||
+                        (kind != CAT_POOL_BATCH && p->nb + p->opening >= max))) {
+         p->conns[best].users++;
+         db = p->conns[best].db;
+         break;
+      }
+      if (p->nb + p->opening < max) {
+         p->opening++;
+         V(pool_mutex);
+         db = open_pool_connection(jcr, catalog, kind);
+         P(pool_mutex);
+         p->opening--;
+         pthread_cond_broadcast(&pool_cond);
+         if (!db) {
+            if (p->nb == 0 || kind != CAT_POOL_BATCH) {
+               break;                 /* use the usual connection */
+            }
+            max = p->nb;              /* wait for the opened ones */
+            continue;
+         }
+         if (p->nb == p->size) {
+            p->size = MAX(p->size * 2, 4);
+            p->conns = (pool_conn *)realloc(p->conns, p->size * sizeof(pool_conn));
+         }
+         p->conns[p->nb].db = db;
+         p->conns[p->nb].users = 1;
+         p->nb++;
+         break;
+      }
+      if (job_canceled(jcr)) {
+         break;
+      }
+      /* All the batch connections are in use, or being opened */
+      if (kind == CAT_POOL_BATCH && start == 0) {
+         start = get_current_btime();
+         Jmsg(jcr, M_INFO, 0, _("Waiting for a batch connection to the catalog \"%s\".\n"),
+              catalog->name());
+      }
+      timeout.tv_sec = time(NULL) + 1;
+      timeout.tv_nsec = 0;
+      pthread_cond_timedwait(&pool_cond, &pool_mutex, &timeout);
+   }
+   if (db) {
+      p->requests++;
+   }
+   if (start > 0) {
+      wait = get_current_btime() - start;
+      p->waits++;
+      p->wait_time += wait;
+      if (wait > p->max_wait) {
+         p->max_wait = wait;
+      }
+   }
+   V(pool_mutex);
+   Dmsg3(dbglvl, "JobId=%d got %s connection %p\n", (int)jcr->JobId, pool_names[kind], db);
+   return db;
+}
+
+/*
+ * Give back a connection to its pool. When reusable is false, the
+ *  connection is in an unknown state and it is closed.
+ *
+ *  Returns: true if the connection was from a pool
+ *           false if the caller must close it
+ */
+bool release_catalog_connection(JCR *jcr, BDB *db, bool reusable)
+{
+   cat_pools *item;
+   cat_pool *p;
+   bool found = false;
+
+   if (!db) {
+      return false;
+   }
+   P(pool_mutex);
+   if (pools) {
+      foreach_dlist(item, pools) {
+         for (int kind = 0; !found && kind < CAT_POOL_NUM; kind++) {
+            p = &item->pool[kind];
+            for (int i = 0; i < p->nb; i++) {
+               if (p->conns[i].db != db) {
+                  continue;
+               }
+               found = true;
+               p->conns[i].users--;
+               if (!reusable && p->conns[i].users == 0) {
+                  p->conns[i] = p->conns[--p->nb];
+               } else {
+                  reusable = true;    /* still used, nothing to close */
+               }
+               break;
+            }
+         }
+         if (found) {
+            break;
+         }
+      }
+   }
+   pthread_cond_broadcast(&pool_cond);
+   V(pool_mutex);
+   if (found && !reusable) {
+      Dmsg1(dbglvl, "Close connection %p\n", db);
+      db_close_database(jcr, db);
+   }
+   return found;
+}
+
+/*
+ * Reserve a batch connection for the attributes of a job, the
+ *  batch insert code uses jcr->db_batch when it is set. Called by
+ *  db_open_batch_connexion() when the job needs the connection.
+ */
+void acquire_batch_connection(JCR *jcr)
+{
+   if (!jcr->db_batch && jcr->db && jcr->db->batch_insert_available()) {
+      jcr->db_batch = acquire_catalog_connection(jcr, jcr->catalog, CAT_POOL_BATCH);
+   }
+}
+
+/*
+ * Give back the batch connection once the attributes are inserted
+ *  or the file list is read, so the other jobs can use it. A
+ *  connection that is not from a pool is kept until the end of
+ *  the job as before.
+ */
+void release_batch_connection(JCR *jcr)
+{
+   if (jcr->db_batch && jcr->db_batch != jcr->db &&
+       release_catalog_connection(jcr, jcr->db_batch, !jcr->batch_started)) {
+      jcr->db_batch = NULL;
+      jcr->batch_started = false;
+   }
+}
+
+/*
+ * Fill the status of the pools in use, returns the number of entries
+ */
+int get_catalog_pool_status(CAT_POOL_STATUS *st, int max)
+{
+   cat_pools *item;
+   cat_pool *p;
+   BDB *db;
+   int n = 0;
+
+   P(pool_mutex);
+   if (pools) {
+      foreach_dlist(item, pools) {
+         for (int kind = 0; kind < CAT_POOL_NUM && n < max; kind++) {
+            p = &item->pool[kind];
+            if (p->requests == 0) {
+               continue;
+            }
+            memset(&st[n], 0, sizeof(CAT_POOL_STATUS));
+            bstrncpy(st[n].catalog, item->catalog, sizeof(st[n].catalog));
+            st[n].name = pool_names[kind];
+            st[n].connections = p->nb;
+            st[n].max_connections = p->max;
+            st[n].requests = p->requests;
+            st[n].waits = p->waits;
+            st[n].wait_time = p->wait_time;
+            st[n].max_wait = p->max_wait;
+            for (int i = 0; i < p->nb; i++) {
+               st[n].users += p->conns[i].users;
+               if (kind == CAT_POOL_BATCH) {
+                  continue;
+               }
+               /* The users of a shared connection wait for each other */
+               db = p->conns[i].db;
+               st[n].waits += db->m_lock_waits;
+               st[n].wait_time += db->m_lock_wait;
+               st[n].max_wait = MAX(st[n].max_wait, db->m_lock_max_wait);
+            }
+            n++;
+         }
+      }
+   }
+   V(pool_mutex);
+   return n;
+}
+
+/*
+ * Close all the connections at the shutdown
+ */
+void term_catalog_pools()
+{
+   cat_pools *item;
+   cat_pool *p;
+
+   P(pool_mutex);
+   if (pools) {
+      foreach_dlist(item, pools) {
+         for (int kind = 0; kind < CAT_POOL_NUM; kind++) {
+            p = &item->pool[kind];
+            for (int i = 0; i < p->nb; i++) {
+               db_close_database(NULL, p->conns[i].db);
+            }
+            if (p->conns) {
+               free(p->conns);
+            }
+         }
+      }
+      delete pools;
+      pools = NULL;
+   }
+   V(pool_mutex);
+}
@@ -601,6 +601,15 @@ static void update_attribute(JCR *jcr, char *msg, int32_t msglen)
 
       Dmsg2(400, "dird<stored: stream=%d %s\n", Stream, fname);
       Dmsg1(400, "dird<stored: attr=%s\n", attr);
+      if (jcr->catalog && jcr->catalog->compact_lstat) {
+         char buf[MAXSTRING];
+         /* The link and the delta sequence are no longer used, we can
+          *  replace the stat packet in place if it is shorter.
+          */
+         if (compact_stat(attr, buf) <= (int)strlen(attr)) {
+            strcpy(attr, buf);
+         }
+      }
       ar->attr = attr;
       ar->fname = fname;
       if (ar->FileType == FT_DELETED) {
@@ -695,6 +704,10 @@ static void update_attribute(JCR *jcr, char *msg, int32_t msglen)
          len = CRYPTO_DIGEST_SHA512_SIZE;
          type = CRYPTO_DIGEST_SHA512;
          break;
+      case STREAM_XXH128_DIGEST:
+         len = CRYPTO_DIGEST_XXH128_SIZE;
+         type = CRYPTO_DIGEST_XXH128;
+         break;
       default:
          /* Never reached ... */
          Jmsg(jcr, M_ERROR, 0, _("Catalog error updating file digest. Unsupported digest stream type: %d"),
@@ -797,6 +810,8 @@ bool despool_attributes_from_file(JCR *jcr, const char *file)
 #if defined(HAVE_POSIX_FADVISE) && defined(POSIX_FADV_WILLNEED)
    posix_fadvise(fileno(spool_fd), 0, 0, POSIX_FADV_WILLNEED);
 #endif
+   /* The records are small, read the file by large chunks */
+   setvbuf(spool_fd, NULL, _IOFBF, 256 * 1024);
 
    /*
     * We read the attributes file or stream from the SD.  It should
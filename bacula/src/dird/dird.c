@@ -426,6 +426,7 @@ int main (int argc, char *argv[])
       /* Plug database interface for library routines */
       p_sql_log = (sql_insert_log)dir_sql_log;
       p_sql_event = (sql_insert_event)dir_sql_event;
+      p_db_batch_connection = acquire_batch_connection;
    }
 
    /* If we are in testing mode, we don't try to fix the catalog */
@@ -471,6 +472,8 @@ int main (int argc, char *argv[])
 
    start_collector_threads();    /* start collector thread for every Collector resource */
 
+   start_prune_service();        /* delete the pruned File records in background */
+
    events_send_msg(NULL,
                    "DD0001",
                    EVENTS_TYPE_DAEMON,
@@ -825,6 +828,8 @@ void terminate_dird(int sig)
    }
    stop_watchdog();
    terminate_collector_threads();
+   stop_prune_service();
+   term_catalog_pools();
    generate_daemon_event(NULL, "Exit");
    unload_plugins();
    if (!test_config) {
@@ -59,6 +59,34 @@ struct del_ctx {
    int tot_ids;                       /* total to process */
 };
 
+/* Status of the background pruning, see prune_service.c */
+struct PRUNE_STATUS {
+   int pending;                       /* JobIds to do */
+   JobId_t JobId;                     /* JobId in progress */
+   uint64_t deleted;                  /* File records deleted since the startup */
+   uint64_t rate;                     /* Records per second */
+};
+
+/* Pools of catalog connections, see catalog_pool.c */
+enum {
+   CAT_POOL_JOB = 0,                  /* shared by the jobs */
+   CAT_POOL_CONSOLE,                  /* shared by the consoles */
+   CAT_POOL_BATCH,                    /* attribute inserts, one job at a time */
+   CAT_POOL_NUM
+};
+
+struct CAT_POOL_STATUS {
+   char catalog[MAX_NAME_LENGTH];     /* Catalog resource name */
+   const char *name;                  /* job, console or batch */
+   int connections;                   /* connections opened */
+   int max_connections;               /* size of the pool */
+   int users;                         /* jobs or consoles using the pool */
+   uint64_t requests;                 /* connections given */
+   uint64_t waits;                    /* requests or queries that had to wait */
+   uint64_t wait_time;                /* total time waited (usec) */
+   uint64_t max_wait;                 /* longest wait (usec) */
+};
+
 /* Flags for find_next_volume_for_append() */
 enum {
   fnv_create_vol    = true,
@@ -382,6 +382,8 @@ static RES_ITEM dir_items[] = {
    {"SdConnectTimeout", store_time,ITEM(res_dir.SDConnectTimeout), 0, ITEM_DEFAULT, 30 * 60},
    {"HeartbeatInterval", store_time, ITEM(res_dir.heartbeat_interval), 0, ITEM_DEFAULT, 5 * 60},
    {"AutoPrune", store_bool, ITEM(res_dir.AutoPrune), 0, ITEM_DEFAULT, true},
+   {"BackgroundPruning", store_bool, ITEM(res_dir.BackgroundPruning), 0, ITEM_DEFAULT, false},
+   {"MaximumPruneRate", store_pint32, ITEM(res_dir.MaxPruneRate), 0, ITEM_DEFAULT, 0},
 #if BEEF
    {"FipsRequire", store_bool, ITEM(res_dir.require_fips), 0, 0, 0},
 #endif
@@ -562,7 +564,13 @@ static RES_ITEM cat_items[] = {
 
    /* Turned off for the moment */
    {"MultipleConnections", store_bit, ITEM(res_cat.mult_db_connections), 0, 0, 0},
+   {"JobConnections", store_pint32, ITEM(res_cat.job_connections), 0, ITEM_DEFAULT, 0},
+   {"ConsoleConnections", store_pint32, ITEM(res_cat.console_connections), 0, ITEM_DEFAULT, 0},
+   {"BatchConnections", store_pint32, ITEM(res_cat.batch_connections), 0, ITEM_DEFAULT, 0},
+   {"ReplicaAddress", store_str, ITEM(res_cat.db_replica_address), 0, 0, 0},
+   {"ReplicaPort", store_pint32, ITEM(res_cat.db_replica_port), 0, 0, 0},
    {"DisableBatchInsert", store_bool, ITEM(res_cat.disable_batch_insert), 0, ITEM_DEFAULT, false},
+   {"CompactLStat", store_bool, ITEM(res_cat.compact_lstat), 0, ITEM_DEFAULT, false},
    {NULL, NULL, {0}, 0, 0, 0}
 };
 
@@ -1067,11 +1075,11 @@ void dump_resource(int type, RES *ares, void sendit(void *sock, const char *fmt,
          break;
       }
       sendit(sock, _("Catalog: name=%s address=%s DBport=%d db_name=%s\n"
-"      db_driver=%s db_user=%s MutliDBConn=%d\n"),
+"      db_driver=%s db_user=%s MutliDBConn=%d CompactLStat=%d\n"),
          res->res_cat.hdr.name, NPRT(res->res_cat.db_address),
          res->res_cat.db_port, res->res_cat.db_name,
          NPRT(res->res_cat.db_driver), NPRT(res->res_cat.db_user),
-         res->res_cat.mult_db_connections);
+         res->res_cat.mult_db_connections, res->res_cat.compact_lstat);
       break;
 
    case R_JOB:
@@ -1767,6 +1775,9 @@ void free_resource(RES *rres, int type)
       if (res->res_cat.db_ssl_cipher) {
          free(res->res_cat.db_ssl_cipher);
       }
+      if (res->res_cat.db_replica_address) {
+         free(res->res_cat.db_replica_address);
+      }
       break;
    case R_FILESET:
       if ((num=res->res_fs.num_includes)) {
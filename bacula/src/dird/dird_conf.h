@@ -122,6 +122,8 @@ public:
    utime_t stats_retention;           /* Stats retention period in seconds */
    bool comm_compression;             /* Enable comm line compression */
    bool AutoPrune;                    /* Global autoprune flag */
+   bool BackgroundPruning;            /* Delete the pruned File records in background */
+   uint32_t MaxPruneRate;             /* File records deleted per second in background */
    bool require_fips;                  /* Check for FIPS module */
    bool tls_authenticate;             /* Authenticated with TLS */
    bool tls_enable;                   /* Enable TLS */
@@ -243,7 +245,13 @@ public:
    char *db_ssl_capath;               /* the path name to a directory that contains trusted SSL CA certificates in PEM format */
    char *db_ssl_cipher;               /* a list of permissible ciphers to use for SSL encryption */
    uint32_t mult_db_connections;      /* set for multiple db connections */
+   uint32_t job_connections;          /* connections shared by the jobs */
+   uint32_t console_connections;      /* connections shared by the consoles */
+   uint32_t batch_connections;        /* connections kept for the attribute inserts */
+   char *db_replica_address;          /* read-only replica used by list/llist only */
+   uint32_t db_replica_port;          /* port of the replica */
    bool disable_batch_insert;         /* set to disable batch inserts */
+   bool compact_lstat;                /* store LStat in the compact form */
 
    /* Methods */
    char *name() const;
@@ -557,6 +565,7 @@ enum {
    INC_KW_HONOR_NODUMP,
    INC_KW_XATTR,
    INC_KW_DEDUP,
+   INC_KW_CHANGEDBLOCKS,
    INC_KW_MAX                   /* Keep this last */
 };
 
@@ -114,6 +114,7 @@ RES_ITEM options_items[] = {
    {"HonorNoDumpFlag", store_opts,    {0},   0, INC_KW_HONOR_NODUMP, 0},
    {"XattrSupport",    store_opts,    {0},   0, INC_KW_XATTR,        0},
    {"ReadFifo",        store_opts,    {0},   0, INC_KW_READFIFO,     0},
+   {"ChangedBlocks",   store_opts,    {0},   0, INC_KW_CHANGEDBLOCKS, 0},
    {"BaseJob",         store_lopts,   {0}, 'J', INC_KW_BASEJOB,      0},
    {"Accurate",        store_lopts,   {0}, 'C', INC_KW_ACCURATE,     0},
    {"Verify",          store_lopts,   {0}, 'V', INC_KW_VERIFY,       0},
@@ -166,6 +167,7 @@ s_kw FS_option_kw[] = {
    {"StripPath",   INC_KW_STRIPPATH},
    {"HonorNoDumpFlag", INC_KW_HONOR_NODUMP},
    {"XattrSupport", INC_KW_XATTR},
+   {"ChangedBlocks", INC_KW_CHANGEDBLOCKS},
    {NULL,          0}
 };
 
@@ -190,6 +192,7 @@ struct s_fs_opt FS_options[] = {
    {"Md5",      INC_KW_DIGEST,        "M"},
    {"Sha256",   INC_KW_DIGEST,       "S2"},
    {"Sha512",   INC_KW_DIGEST,       "S3"},
+   {"Xxh128",   INC_KW_DIGEST,       "S4"},
    {"Sha1",     INC_KW_DIGEST,        "S"},
    {"Gzip",     INC_KW_COMPRESSION,  "Z6"},
    {"Gzip1",    INC_KW_COMPRESSION,  "Z1"},
@@ -244,6 +247,8 @@ struct s_fs_opt FS_options[] = {
    {"No",       INC_KW_HONOR_NODUMP,  "0"},
    {"Yes",      INC_KW_XATTR,         "X"},
    {"No",       INC_KW_XATTR,         "0"},
+   {"Yes",      INC_KW_CHANGEDBLOCKS, "T"},
+   {"No",       INC_KW_CHANGEDBLOCKS, "0"},
    {NULL,       0,                      0}
 };
 
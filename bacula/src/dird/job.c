@@ -115,16 +115,19 @@ bool setup_job(JCR *jcr)
     * Open database
     */
    Dmsg0(100, "Open database\n");
-   jcr->db = db_init_database(jcr, jcr->catalog->db_driver, jcr->catalog->db_name,
-                              jcr->catalog->db_user, jcr->catalog->db_password,
-                              jcr->catalog->db_address, jcr->catalog->db_port,
-                              jcr->catalog->db_socket,
-                              jcr->catalog->db_ssl_mode,
-                              jcr->catalog->db_ssl_key, jcr->catalog->db_ssl_cert,
-                              jcr->catalog->db_ssl_ca, jcr->catalog->db_ssl_capath, 
-                              jcr->catalog->db_ssl_cipher,
-                              jcr->catalog->mult_db_connections,
-                              jcr->catalog->disable_batch_insert);
+   jcr->db = acquire_catalog_connection(jcr, jcr->catalog, CAT_POOL_JOB);
+   if (!jcr->db) {
+      jcr->db = db_init_database(jcr, jcr->catalog->db_driver, jcr->catalog->db_name,
+                                 jcr->catalog->db_user, jcr->catalog->db_password,
+                                 jcr->catalog->db_address, jcr->catalog->db_port,
+                                 jcr->catalog->db_socket,
+                                 jcr->catalog->db_ssl_mode,
+                                 jcr->catalog->db_ssl_key, jcr->catalog->db_ssl_cert,
+                                 jcr->catalog->db_ssl_ca, jcr->catalog->db_ssl_capath, 
+                                 jcr->catalog->db_ssl_cipher,
+                                 jcr->catalog->mult_db_connections,
+                                 jcr->catalog->disable_batch_insert);
+   }
 
    if (!jcr->db || !db_open_database(jcr, jcr->db)) {
       Jmsg(jcr, M_FATAL, 0, _("Could not open database \"%s\".\n"),
@@ -276,16 +279,19 @@ static bool setup_resume_job(JCR *jcr, JOB_DBR *jr)
     * Open database
     */
    Dmsg0(100, "Open database\n");
-   jcr->db = db_init_database(jcr, jcr->catalog->db_driver, jcr->catalog->db_name,
-                              jcr->catalog->db_user, jcr->catalog->db_password,
-                              jcr->catalog->db_address, jcr->catalog->db_port,
-                              jcr->catalog->db_socket,
-                              jcr->catalog->db_ssl_mode,
-                              jcr->catalog->db_ssl_key, jcr->catalog->db_ssl_cert,
-                              jcr->catalog->db_ssl_ca, jcr->catalog->db_ssl_capath, 
-                              jcr->catalog->db_ssl_cipher,
-                              jcr->catalog->mult_db_connections,
-                              jcr->catalog->disable_batch_insert);
+   jcr->db = acquire_catalog_connection(jcr, jcr->catalog, CAT_POOL_JOB);
+   if (!jcr->db) {
+      jcr->db = db_init_database(jcr, jcr->catalog->db_driver, jcr->catalog->db_name,
+                                 jcr->catalog->db_user, jcr->catalog->db_password,
+                                 jcr->catalog->db_address, jcr->catalog->db_port,
+                                 jcr->catalog->db_socket,
+                                 jcr->catalog->db_ssl_mode,
+                                 jcr->catalog->db_ssl_key, jcr->catalog->db_ssl_cert,
+                                 jcr->catalog->db_ssl_ca, jcr->catalog->db_ssl_capath, 
+                                 jcr->catalog->db_ssl_cipher,
+                                 jcr->catalog->mult_db_connections,
+                                 jcr->catalog->disable_batch_insert);
+   }
    if (!jcr->db || !db_open_database(jcr, jcr->db)) {
       Jmsg(jcr, M_FATAL, 0, _("Could not open database \"%s\".\n"),
                  jcr->catalog->db_name);
@@ -1538,12 +1544,18 @@ void dird_free_jcr(JCR *jcr)
       jcr->term_wait_inited = false;
    }
    if (jcr->db_batch) {
-      db_close_database(jcr, jcr->db_batch);
+      /* A batch interrupted by an error cannot be reused */
+      if (jcr->db_batch == jcr->db ||
+          !release_catalog_connection(jcr, jcr->db_batch, !jcr->batch_started)) {
+         db_close_database(jcr, jcr->db_batch);
+      }
       jcr->db_batch = NULL;
       jcr->batch_started = false;
    }
    if (jcr->db) {
-      db_close_database(jcr, jcr->db);
+      if (!release_catalog_connection(jcr, jcr->db)) {
+         db_close_database(jcr, jcr->db);
+      }
       jcr->db = NULL;
    }
 
@@ -1980,6 +1992,8 @@ bool run_console_command(JCR *jcr, const char *cmd)
 
 bool flush_file_records(JCR *jcr)
 {
+   bool ok;
+
    if (jcr->cached_attribute) {
       Dmsg0(400, "Flush last cached attribute.\n");
       if (!db_create_attributes_record(jcr, jcr->db, jcr->ar)) {
@@ -1988,5 +2002,7 @@ bool flush_file_records(JCR *jcr)
       jcr->cached_attribute = false;
    }
 
-   return db_write_batch_file_records(jcr);    /* used by bulk batch file insert */
+   ok = db_write_batch_file_records(jcr);    /* used by bulk batch file insert */
+   release_batch_connection(jcr);
+   return ok;
 }
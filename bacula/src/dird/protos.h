@@ -220,6 +220,7 @@ bool do_a_command(UAContext *ua);
 bool do_a_dot_command(UAContext *ua);
 int qmessagescmd(UAContext *ua, const char *cmd);
 bool open_new_client_db(UAContext *ua);
+bool open_replica_client_db(UAContext *ua);
 bool open_client_db(UAContext *ua);
 bool open_db(UAContext *ua);
 void close_db(UAContext *ua);
@@ -328,6 +329,8 @@ void list_dir_status_header(UAContext *ua);
 /* ua_tree.c */
 bool user_select_files_from_tree(TREE_CTX *tree);
 int insert_tree_handler(void *ctx, int num_fields, char **row);
+bool load_tree_from_catalog(TREE_CTX *tree, char *jobids, bool wait);
+bool wait_tree_loaded(TREE_CTX *tree);
 bool check_directory_acl(char **last_dir, alist *dir_acl, const char *path);
 
 /* ua_prune.c */
@@ -341,12 +344,27 @@ int file_delete_handler(void *ctx, int num_fields, char **row);
 int get_prune_list_for_volume(UAContext *ua, MEDIA_DBR *mr, del_ctx *del);
 int exclude_running_jobs_from_list(del_ctx *prune_list);
 
+/* catalog_pool.c */
+BDB *acquire_catalog_connection(JCR *jcr, CAT *catalog, int kind);
+bool release_catalog_connection(JCR *jcr, BDB *db, bool reusable=true);
+void acquire_batch_connection(JCR *jcr);
+void release_batch_connection(JCR *jcr);
+int get_catalog_pool_status(CAT_POOL_STATUS *st, int max);
+void term_catalog_pools();
+
+/* prune_service.c */
+void start_prune_service();
+void stop_prune_service();
+bool prune_service_enabled();
+void prune_service_add_jobids(CAT *catalog, char *jobids);
+void get_prune_service_status(PRUNE_STATUS *st);
+
 /* ua_purge.c */
 bool is_volume_purged(UAContext *ua, MEDIA_DBR *mr, bool force=false);
 bool mark_media_purged(UAContext *ua, MEDIA_DBR *mr);
 void purge_files_from_volume(UAContext *ua, MEDIA_DBR *mr);
 bool purge_jobs_from_volume(UAContext *ua, MEDIA_DBR *mr, bool force=false);
-void purge_files_from_jobs(UAContext *ua, char *jobs);
+void purge_files_from_jobs(UAContext *ua, char *jobs, bool background=true);
 void purge_jobs_from_catalog(UAContext *ua, char *jobs);
 void purge_job_list_from_catalog(UAContext *ua, del_ctx &del);
 void purge_files_from_job_list(UAContext *ua, del_ctx &del);
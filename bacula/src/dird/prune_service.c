@@ -0,0 +1,426 @@
+/*
+   Bacula(R) - The Network Backup Solution
+
+   Copyright (C) 2000-2020 Kern Sibbald
+
+   The original author of Bacula is Kern Sibbald, with contributions
+   from many others, a complete list can be found in the file AUTHORS.
+
+   You may use this file and others of this release according to the
+   license defined in the LICENSE file, which includes the Affero General
+   Public License, v3.0 ("AGPLv3") and some additional permissions and
+   terms pursuant to its AGPLv3 Section 7.
+
+   This notice must be preserved when any source code is
+   conveyed and/or propagated.
+
+   Bacula(R) is a registered trademark of Kern Sibbald.
+*/
+/*
+ *   Bacula Director -- Background deletion of the pruned File records
+ *
+ *     With "Background Pruning = yes" in the Director resource, the
+ *     prune and purge of the Files of a Job only mark the Job with
+ *     PurgedFiles=1. The JobId is then given to the thread below that
+ *     deletes the File records by small chunks with its own catalog
+ *     connection, and at most "Maximum Prune Rate" records per second.
+ *
+ *     The JobIds that are not done yet are kept in the working
+ *     directory, so the deletion goes on after a restart.
+ */
+
+#include "bacula.h"
+#include "dird.h"
+
+static const int dbglvl = 100;
+
+/* Number of File records deleted by one query */
+#define PRUNE_CHUNK_MIN 100
+#define PRUNE_CHUNK_MAX 10000
+
+/* Time to wait after a catalog error (in seconds) */
+#define PRUNE_RETRY_WAIT 60
+
+struct prune_item {
+   dlink link;
+   JobId_t JobId;
+   char catalog[MAX_NAME_LENGTH];     /* Catalog resource name */
+};
+
+static pthread_mutex_t prune_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t prune_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t prune_tid;
+static bool prune_started = false;
+static bool prune_quit = false;
+static dlist *prune_list = NULL;      /* JobIds to do, protected by prune_mutex */
+static uint64_t prune_deleted = 0;    /* File records deleted since the startup */
+static uint64_t prune_rate = 0;       /* Records/second of the last Job */
+static JobId_t prune_current = 0;     /* JobId in progress */
+
+static void make_prune_file_name(POOLMEM **fname)
+{
+   Mmsg(fname, "%s/%s.prune", director->working_directory, director->name());
+}
+
+/*
+ * Write the list of the JobIds to do in the working directory,
+ *  must be called with prune_mutex locked.
+ */
+static void save_prune_list()
+{
+   POOL_MEM fname(PM_FNAME), tmp(PM_FNAME);
+   prune_item *item;
+   FILE *fp;
+
+   make_prune_file_name(fname.handle());
+   if (prune_list->empty()) {
+      unlink(fname.c_str());
+      return;
+   }
+   Mmsg(tmp, "%s.tmp", fname.c_str());
+   if ((fp = bfopen(tmp.c_str(), "w")) == NULL) {
+      berrno be;
+      Dmsg2(dbglvl, "Could not create %s. ERR=%s\n", tmp.c_str(), be.bstrerror());
+      return;
+   }
+   foreach_dlist(item, prune_list) {
+      fprintf(fp, "%u %s\n", (uint32_t)item->JobId, item->catalog);
+   }
+   if (fclose(fp) != 0 || rename(tmp.c_str(), fname.c_str()) != 0) {
+      berrno be;
+      Dmsg2(dbglvl, "Could not write %s. ERR=%s\n", fname.c_str(), be.bstrerror());
+      unlink(tmp.c_str());
+   }
+}
+
+/*
+ * Reload the JobIds that were not done before the last stop
+ */
+static void load_prune_list()
+{
+   POOL_MEM fname(PM_FNAME);
+   char line[MAXSTRING];
+   prune_item *item;
+   uint32_t JobId;
+   char *p;
+   FILE *fp;
+
+   make_prune_file_name(fname.handle());
+   if ((fp = bfopen(fname.c_str(), "r")) == NULL) {
+      return;
+   }
+   while (bfgets(line, sizeof(line), fp)) {
+      strip_trailing_newline(line);
+      p = strchr(line, ' ');
+      if (!p || sscanf(line, "%u", &JobId) != 1 || JobId == 0) {
+         continue;
+      }
+      item = (prune_item *)malloc(sizeof(prune_item));
+      item->JobId = JobId;
+      bstrncpy(item->catalog, p+1, sizeof(item->catalog));
+      prune_list->append(item);
+   }
+   fclose(fp);
+   Dmsg1(dbglvl, "Loaded %d JobIds to prune\n", prune_list->size());
+}
+
+/*
+ * Wait for usec microseconds or until the service is stopped
+ */
+static void prune_wait(int64_t usec)
+{
+   struct timespec timeout;
+   btime_t end = get_current_btime() + usec;
+
+   P(prune_mutex);
+   while (!prune_quit && get_current_btime() < end) {
+      timeout.tv_sec = end / 1000000;
+      timeout.tv_nsec = (end % 1000000) * 1000;
+      pthread_cond_timedwait(&prune_cond, &prune_mutex, &timeout);
+   }
+   V(prune_mutex);
+}
+
+static BDB *open_prune_db(const char *name)
+{
+   BDB *db = NULL;
+   CAT *catalog;
+
+   LockRes();
+   catalog = (CAT *)GetResWithName(R_CATALOG, name);
+   if (catalog) {
+      db = db_init_database(NULL, catalog->db_driver, catalog->db_name,
+              catalog->db_user,
+              catalog->db_password, catalog->db_address,
+              catalog->db_port, catalog->db_socket,
+              catalog->db_ssl_mode, catalog->db_ssl_key,
+              catalog->db_ssl_cert, catalog->db_ssl_ca,
+              catalog->db_ssl_capath, catalog->db_ssl_cipher,
+              true /* private connection */,
+              catalog->disable_batch_insert);
+   }
+   UnlockRes();
+   if (!catalog) {
+      Jmsg(NULL, M_WARNING, 0, _("Catalog \"%s\" not found, cannot prune its File records.\n"),
+           name);
+      return NULL;
+   }
+   if (!db || !db_open_database(NULL, db)) {
+      Jmsg(NULL, M_ERROR, 0, _("Could not open Catalog \"%s\" to prune the File records. ERR=%s"),
+           name, db ? db_strerror(db) : "");
+      if (db) {
+         db_close_database(NULL, db);
+      }
+      return NULL;
+   }
+   return db;
+}
+
+static int prune_int_handler(void *ctx, int num_fields, char **row)
+{
+   if (row[0]) {
+      *(int64_t *)ctx = str_to_int64(row[0]);
+   }
+   return 0;
+}
+
+/* List of FileIds of the next chunk */
+struct prune_chunk_ctx {
+   POOLMEM *ids;
+   int len;
+   int count;
+};
+
+static int prune_chunk_handler(void *ctx, int num_fields, char **row)
+{
+   prune_chunk_ctx *chunk = (prune_chunk_ctx *)ctx;
+   int len = strlen(row[0]);
+
+   chunk->ids = check_pool_memory_size(chunk->ids, chunk->len + len + 2);
+   if (chunk->count++ > 0) {
+      chunk->ids[chunk->len++] = ',';
+   }
+   memcpy(chunk->ids + chunk->len, row[0], len + 1);
+   chunk->len += len;
+   return 0;
+}
+
+/*
+ * Delete the File records of a Job by chunks
+ *
+ *  Returns: true when the Job is done
+ *           false on error or when the service is stopped
+ */
+static bool prune_job_files(BDB *db, JobId_t JobId)
+{
+   POOL_MEM query(PM_MESSAGE);
+   prune_chunk_ctx chunk;
+   uint64_t rows = 0;
+   btime_t start = get_current_btime();
+   bool ret = false;
+   int64_t purged;
+   int32_t rate;
+   int limit;
+   char ed1[50];
+
+   edit_uint64(JobId, ed1);
+   chunk.ids = get_pool_memory(PM_MESSAGE);
+
+   while (!prune_quit) {
+      /*
+       * The Job must still be there with its Files purged, the
+       *  File records are deleted by the purge of the Job otherwise.
+       */
+      purged = -1;
+      Mmsg(query, "SELECT PurgedFiles FROM Job WHERE JobId=%s", ed1);
+      if (!db_sql_query(db, query.c_str(), prune_int_handler, &purged)) {
+         Jmsg(NULL, M_ERROR, 0, _("Prune of JobId=%s failed. ERR=%s"), ed1, db_strerror(db));
+         goto bail_out;
+      }
+      if (purged != 1) {
+         Dmsg2(dbglvl, "JobId=%s PurgedFiles=%lld, nothing to do\n", ed1, purged);
+         ret = true;
+         goto bail_out;
+      }
+
+      /* Size the chunks to do about four queries per second */
+      rate = director->MaxPruneRate;
+      limit = rate > 0 ? MIN(MAX(rate / 4, PRUNE_CHUNK_MIN), PRUNE_CHUNK_MAX) : PRUNE_CHUNK_MAX;
+
+      *chunk.ids = 0;
+      chunk.len = chunk.count = 0;
+      Mmsg(query, "SELECT FileId FROM File WHERE JobId=%s LIMIT %d", ed1, limit);
+      if (!db_sql_query(db, query.c_str(), prune_chunk_handler, &chunk)) {
+         Jmsg(NULL, M_ERROR, 0, _("Prune of JobId=%s failed. ERR=%s"), ed1, db_strerror(db));
+         goto bail_out;
+      }
+      if (chunk.count == 0) {
+         ret = true;
+         goto bail_out;
+      }
+      Mmsg(query, "DELETE FROM File WHERE FileId IN (%s)", chunk.ids);
+      if (!db_sql_query(db, query.c_str(), NULL, NULL)) {
+         Jmsg(NULL, M_ERROR, 0, _("Prune of JobId=%s failed. ERR=%s"), ed1, db_strerror(db));
+         goto bail_out;
+      }
+      rows += chunk.count;
+
+      P(prune_mutex);
+      prune_deleted += chunk.count;
+      V(prune_mutex);
+
+      /* Wait until we are back under the rate limit */
+      if (rate > 0) {
+         prune_wait(start + (btime_t)(rows * 1000000 / rate) - get_current_btime());
+      }
+
+      P(prune_mutex);
+      prune_rate = rows * 1000000 / MAX(get_current_btime() - start, 1);
+      V(prune_mutex);
+   }
+
+bail_out:
+   Dmsg3(dbglvl, "JobId=%s %lld File records deleted done=%d\n", ed1, rows, ret);
+   free_pool_memory(chunk.ids);
+   return ret;
+}
+
+extern "C" void *prune_service_thread(void *arg)
+{
+   char catalog[MAX_NAME_LENGTH];
+   char cur_catalog[MAX_NAME_LENGTH];
+   prune_item *item;
+   JobId_t JobId;
+   BDB *db = NULL;
+   bool done;
+
+   set_jcr_in_tsd(INVALID_JCR);
+   cur_catalog[0] = 0;
+
+   P(prune_mutex);
+   while (!prune_quit) {
+      if (prune_list->empty()) {
+         if (db) {
+            db_close_database(NULL, db);      /* do not keep an idle connection */
+            db = NULL;
+         }
+         prune_rate = 0;
+         pthread_cond_wait(&prune_cond, &prune_mutex);
+         continue;
+      }
+      /* Only this thread removes items, so we can work on it unlocked */
+      item = (prune_item *)prune_list->first();
+      JobId = prune_current = item->JobId;
+      bstrncpy(catalog, item->catalog, sizeof(catalog));
+      V(prune_mutex);
+
+      if (db && strcmp(catalog, cur_catalog) != 0) {
+         db_close_database(NULL, db);
+         db = NULL;
+      }
+      if (!db) {
+         db = open_prune_db(catalog);
+         bstrncpy(cur_catalog, catalog, sizeof(cur_catalog));
+      }
+      done = db ? prune_job_files(db, JobId) : false;
+
+      P(prune_mutex);
+      prune_current = 0;
+      if (done) {
+         prune_list->remove(item);
+         free(item);
+         save_prune_list();
+
+      } else if (!prune_quit) {
+         /* Try again later, the connection may be the problem */
+         if (db) {
+            db_close_database(NULL, db);
+            db = NULL;
+         }
+         V(prune_mutex);
+         prune_wait(PRUNE_RETRY_WAIT * 1000000LL);
+         P(prune_mutex);
+      }
+   }
+   V(prune_mutex);
+   if (db) {
+      db_close_database(NULL, db);
+   }
+   return NULL;
+}
+
+/*
+ * Give the JobIds (comma separated list) of a catalog to the service
+ */
+void prune_service_add_jobids(CAT *catalog, char *jobids)
+{
+   prune_item *item;
+   uint32_t JobId;
+   char *p = jobids;
+
+   P(prune_mutex);
+   while (get_next_jobid_from_list(&p, &JobId) > 0) {
+      item = (prune_item *)malloc(sizeof(prune_item));
+      item->JobId = JobId;
+      bstrncpy(item->catalog, catalog->name(), sizeof(item->catalog));
+      prune_list->append(item);
+   }
+   save_prune_list();
+   pthread_cond_signal(&prune_cond);
+   V(prune_mutex);
+}
+
+/*
+ * Returns true if the File records of the pruned Jobs are
+ *  deleted by the service
+ */
+bool prune_service_enabled()
+{
+   return prune_started && director->BackgroundPruning;
+}
+
+void get_prune_service_status(PRUNE_STATUS *st)
+{
+   P(prune_mutex);
+   st->pending = prune_list ? prune_list->size() : 0;
+   st->JobId = prune_current;
+   st->deleted = prune_deleted;
+   st->rate = prune_rate;
+   V(prune_mutex);
+}
+
+void start_prune_service()
+{
+   prune_item *item = NULL;
+   int status;
+
+   prune_list = New(dlist(item, &item->link));
+   load_prune_list();
+   prune_quit = false;
+   if ((status = pthread_create(&prune_tid, NULL, prune_service_thread, NULL)) != 0) {
+      berrno be;
+      Jmsg1(NULL, M_ERROR, 0, _("Cannot create the prune thread: %s\n"), be.bstrerror(status));
+      return;
+   }
+   prune_started = true;
+}
+
+/*
+ * Stop the thread, the JobIds not done are in the working
+ *  directory for the next startup.
+ */
+void stop_prune_service()
+{
+   if (prune_started) {
+      P(prune_mutex);
+      prune_quit = true;
+      pthread_cond_broadcast(&prune_cond);
+      V(prune_mutex);
+      pthread_join(prune_tid, NULL);
+      prune_started = false;
+   }
+   if (prune_list) {
+      delete prune_list;
+      prune_list = NULL;
+   }
+}
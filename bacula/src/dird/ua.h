@@ -34,6 +34,7 @@ public:
    BDB *db;                          /* Pointing to shared or private db */
    BDB *shared_db;                   /* Main Bacula DB access */
    BDB *private_db;                  /* Private DB access */
+   BDB *replica_db;                  /* Private DB access to the replica */
    CAT *catalog;
    CONRES *cons;                      /* console resource */
    POOLMEM *cmd;                      /* return command/name buffer */
@@ -51,6 +52,7 @@ public:
    int api;                           /* For programs want an API */
    int cmd_index;                     /* Index in command table */
    bool force_mult_db_connections;    /* overwrite cat.mult_db_connections */
+   bool use_replica;                  /* open the replica of the catalog */
    bool auto_display_messages;        /* if set, display messages */
    bool user_notified_msg_pending;    /* set when user notified */
    bool automount;                    /* if set, mount after label */
@@ -78,6 +80,8 @@ public:
    void send_events(const char *code, const char *type, const char *fmt, ...);
 };
 
+struct TREE_LOADER;                   /* see load_tree_from_catalog() */
+
 /* Context for insert_tree_handler() */
 struct TREE_CTX {
    TREE_ROOT *root;                   /* root */
@@ -96,6 +100,7 @@ struct TREE_CTX {
    alist *gid_acl;                    /* GID allowed in the tree */
    alist *dir_acl;                    /* Directories that can be displayed */
    char  *last_dir_acl;               /* Last directory from the DirectoryACL list */
+   TREE_LOADER *loader;               /* set while the tree is loaded in background */
 };
 
 struct NAME_LIST {
@@ -2626,6 +2626,24 @@ bool open_new_client_db(UAContext *ua)
    return ret;
 }
 
+/*
+ * This call uses open_client_db() and opens a dedicated
+ * connection to the read-only replica of the catalog,
+ * or to the catalog when there is no replica.
+ */
+bool open_replica_client_db(UAContext *ua)
+{
+   bool ret;
+
+   ua->force_mult_db_connections = true;
+   ua->use_replica = true;
+   ret = open_client_db(ua);
+   ua->use_replica = false;
+   ua->force_mult_db_connections = false;
+
+   return ret;
+}
+
 /*
  * This call explicitly checks for a catalog=xxx and
  *  if given, opens that catalog.  It also checks for
@@ -2721,7 +2739,10 @@ bool open_db(UAContext *ua)
    /* The force_mult_db_connections is telling us if we modify the
     * private or the shared link
     */
-   if (ua->force_mult_db_connections) {
+   if (ua->use_replica) {
+      ua->jcr->db = ua->db = ua->replica_db;
+
+   } else if (ua->force_mult_db_connections) {
       ua->jcr->db = ua->db = ua->private_db;
 
    } else {
@@ -2740,6 +2761,12 @@ bool open_db(UAContext *ua)
       }
    }
 
+   /* Without a replica, the private connection to the catalog is used */
+   if (ua->use_replica && !ua->catalog->db_replica_address) {
+      ua->use_replica = false;
+      return open_db(ua);
+   }
+
    /* Some modules like bvfs need their own catalog connection */
    mult_db_conn = ua->catalog->mult_db_connections;
    if (ua->force_mult_db_connections) {
@@ -2749,6 +2776,35 @@ bool open_db(UAContext *ua)
    ua->jcr->catalog = ua->catalog;
 
    Dmsg0(100, "UA Open database\n");
+   if (!mult_db_conn) {
+      ua->db = acquire_catalog_connection(ua->jcr, ua->catalog, CAT_POOL_CONSOLE);
+      if (ua->db) {
+         goto opened;
+      }
+   }
+   if (ua->use_replica) {
+      ua->db = db_init_database(ua->jcr, ua->catalog->db_driver,
+                                ua->catalog->db_name,
+                                ua->catalog->db_user,
+                                ua->catalog->db_password, ua->catalog->db_replica_address,
+                                ua->catalog->db_replica_port ? ua->catalog->db_replica_port : ua->catalog->db_port,
+                                NULL,
+                                ua->catalog->db_ssl_mode, ua->catalog->db_ssl_key,
+                                ua->catalog->db_ssl_cert, ua->catalog->db_ssl_ca,
+                                ua->catalog->db_ssl_capath, ua->catalog->db_ssl_cipher,
+                                true, ua->catalog->disable_batch_insert);
+      if (!ua->db || !db_open_database(ua->jcr, ua->db)) {
+         ua->warning_msg(_("Could not open the replica of the catalog \"%s\", using the catalog. ERR=%s"),
+                         ua->catalog->db_name, ua->db ? db_strerror(ua->db) : "\n");
+         if (ua->db) {
+            db_close_database(ua->jcr, ua->db);
+            ua->db = NULL;
+         }
+         ua->use_replica = false;
+         return open_db(ua);
+      }
+      goto opened;
+   }
    ua->db = db_init_database(ua->jcr, ua->catalog->db_driver,
                              ua->catalog->db_name,
                              ua->catalog->db_user,
@@ -2767,10 +2823,15 @@ bool open_db(UAContext *ua)
       close_db(ua);
       return false;
    }
+
+opened:
    ua->jcr->db = ua->db;
 
    /* Depending on the type of connection, we set the right variable */
-   if (ua->force_mult_db_connections) {
+   if (ua->use_replica) {
+      ua->replica_db = ua->db;
+
+   } else if (ua->force_mult_db_connections) {
       ua->private_db = ua->db;
 
    } else {
@@ -2808,7 +2869,9 @@ void close_db(UAContext *ua)
    }
 
    if (ua->shared_db) {
-      db_close_database(ua->jcr, ua->shared_db);
+      if (!release_catalog_connection(ua->jcr, ua->shared_db)) {
+         db_close_database(ua->jcr, ua->shared_db);
+      }
       ua->shared_db = NULL;
    }
 
@@ -2817,5 +2880,10 @@ void close_db(UAContext *ua)
       ua->private_db = NULL;
    }
 
+   if (ua->replica_db) {
+      db_close_database(ua->jcr, ua->replica_db);
+      ua->replica_db = NULL;
+   }
+
    ua->db = NULL;
 }
@@ -331,7 +331,7 @@ static bool dot_bvfs_decode_lstat(UAContext *ua, const char *cmd)
 
    if (pos > 0) {
       for (char *p = ua->argv[pos] ; *p ; p++) {
-         if (! (B_ISALPHA(*p) || B_ISDIGIT(*p) || B_ISSPACE(*p) || *p == '/' || *p == '+' || *p == '-')) {
+         if (! (B_ISALPHA(*p) || B_ISDIGIT(*p) || B_ISSPACE(*p) || *p == '/' || *p == '+' || *p == '-' || *p == '.')) {
             ua->error_msg("Can't accept %c in lstat\n", *p);
             return true;
          }
@@ -465,6 +465,7 @@ static int bvfs_result_handler(void *ctx, int fields, char **row)
    char *fileid=row[BVFS_FileId];
    char *lstat=row[BVFS_LStat];
    char *jobid=row[BVFS_JobId];
+   char buf[MAXSTRING];
 
    char empty[] = "A A A A A A A A A A A A A A";
    char zero[] = "0";
@@ -483,6 +484,8 @@ static int bvfs_result_handler(void *ctx, int fields, char **row)
             (int)ua->uid, (int)ua->gid, (int)statp.st_uid, (int)statp.st_gid, (int)statp.st_mode);
       return 0;
    }
+   /* The clients know only the space separated format */
+   lstat = uncompact_stat(lstat, buf);
    Dmsg1(100, "type=%s\n", row[0]);
    if (bvfs_is_dir(row)) {
       char *path = bvfs_basename_dir(row[BVFS_Name]);
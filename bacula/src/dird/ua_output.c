@@ -358,7 +358,8 @@ static int do_list_cmd(UAContext *ua, const char *cmd, e_list_type llist)
    POOL_DBR pr;
    MEDIA_DBR mr;
 
-   if (!open_new_client_db(ua))
+   /* The list commands are read-only, they can use the replica */
+   if (!open_replica_client_db(ua))
       return 1;
 
    bmemset(&jr, 0, sizeof(jr));
@@ -285,14 +285,21 @@ static int purge_jobs_from_client(UAContext *ua, CLIENT *client)
 
 /*
  * Remove File records from a list of JobIds
+ *
+ *  With background set and "Background Pruning" enabled, the
+ *  File table records are deleted later by the prune service.
  */
-void purge_files_from_jobs(UAContext *ua, char *jobs)
+void purge_files_from_jobs(UAContext *ua, char *jobs, bool background)
 {
    POOL_MEM query(PM_MESSAGE);
+   CAT *catalog = ua->catalog ? ua->catalog : ua->jcr->catalog;
 
-   Mmsg(query, "DELETE FROM File WHERE JobId IN (%s)", jobs);
-   db_sql_query(ua->db, query.c_str(), NULL, (void *)NULL);
-   Dmsg1(050, "Delete File sql=%s\n", query.c_str());
+   background = background && catalog && prune_service_enabled();
+   if (!background) {
+      Mmsg(query, "DELETE FROM File WHERE JobId IN (%s)", jobs);
+      db_sql_query(ua->db, query.c_str(), NULL, (void *)NULL);
+      Dmsg1(050, "Delete File sql=%s\n", query.c_str());
+   }
 
    Mmsg(query, "DELETE FROM FileMedia WHERE JobId IN (%s)", jobs);
    db_sql_query(ua->db, query.c_str(), NULL, (void *)NULL);
@@ -315,6 +322,10 @@ void purge_files_from_jobs(UAContext *ua, char *jobs)
    Mmsg(query, "UPDATE Job SET PurgedFiles=1 WHERE JobId IN (%s)", jobs);
    db_sql_query(ua->db, query.c_str(), NULL, (void *)NULL);
    Dmsg1(050, "Mark purged sql=%s\n", query.c_str());
+
+   if (background) {
+      prune_service_add_jobids(catalog, jobs);
+   }
 }
 
 /*
@@ -430,8 +441,10 @@ void purge_jobs_from_catalog(UAContext *ua, char *jobs)
    /* Keep track of this important event */
    ua->send_events("DC0002", EVENTS_TYPE_COMMAND, "purge jobid=%s", jobs);
 
-   /* Delete (or purge) records associated with the job */
-   purge_files_from_jobs(ua, jobs);
+   /* Delete (or purge) records associated with the job, the Job
+    * record is deleted, so the File records cannot wait
+    */
+   purge_files_from_jobs(ua, jobs, false);
 
    Mmsg(query, "DELETE FROM JobMedia WHERE JobId IN (%s)", jobs);
    db_sql_query(ua->db, query.c_str(), NULL, (void *)NULL);
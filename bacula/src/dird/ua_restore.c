@@ -1367,6 +1367,7 @@ static bool build_directory_tree(UAContext *ua, RESTORE_CTX *rx)
    JobId_t JobId, last_JobId;
    char *p;
    bool OK = true;
+   bool purged;
    char ed1[50];
 
    memset(&tree, 0, sizeof(TREE_CTX));
@@ -1400,16 +1401,31 @@ static bool build_directory_tree(UAContext *ua, RESTORE_CTX *rx)
       }
    }
 
+   /*
+    * Look at the JobIds on the list and if one is marked purged,
+    *  don't do the manual selection because the Job was pruned, so
+    *  the tree would be incomplete. It is checked before the tree
+    *  load that uses the catalog connection in background.
+    */
+   Mmsg(rx->query, "SELECT SUM(PurgedFiles) FROM Job WHERE JobId IN (%s%s%s)",
+        rx->JobIds, *rx->BaseJobIds ? "," : "", rx->BaseJobIds);
+   if (!db_sql_query(ua->db, rx->query, restore_count_handler, (void *)rx)) {
+      ua->error_msg("%s\n", db_strerror(ua->db));
+   }
+   /* rx->JobId is the PurgedFiles flag */
+   purged = rx->found && rx->JobId > 0;
+
    ua->info_msg(_("\nBuilding directory tree for JobId(s) %s ...  "),
                 rx->JobIds);
 
 #define new_get_file_list
 #ifdef new_get_file_list
-   if (!db_get_file_list(ua->jcr, ua->db,
-                         rx->JobIds, DBL_USE_DELTA,
-                         insert_tree_handler, (void *)&tree))
-   {
-      ua->error_msg("%s", db_strerror(ua->db));
+   if (!purged) {
+      /* The prompt comes back with the first files, unless the
+       *  selection is not interactive
+       */
+      load_tree_from_catalog(&tree, rx->JobIds,
+                             ua->api || find_arg(ua, NT_("done")) >= 0);
    }
    if (*rx->BaseJobIds) {
       pm_strcat(rx->JobIds, ",");
@@ -1431,7 +1447,10 @@ static bool build_directory_tree(UAContext *ua, RESTORE_CTX *rx)
          ua->error_msg("%s", db_strerror(ua->db));
       }
    }
+   /* Sort the children of each directory for the file selection */
+   tree_build_children(tree.root);
 #endif
+
    /*
     * At this point, the tree is built, so we can garbage collect
     * any memory released by the SQL engine that RedHat has
@@ -1439,23 +1458,7 @@ static bool build_directory_tree(UAContext *ua, RESTORE_CTX *rx)
     */
     garbage_collect_memory();
 
-   /*
-    * Look at the first JobId on the list (presumably the oldest) and
-    *  if it is marked purged, don't do the manual selection because
-    *  the Job was pruned, so the tree is incomplete.
-    */
-   if (tree.FileCount != 0) {
-      /* Find out if any Job is purged */
-      Mmsg(rx->query, "SELECT SUM(PurgedFiles) FROM Job WHERE JobId IN (%s)", rx->JobIds);
-      if (!db_sql_query(ua->db, rx->query, restore_count_handler, (void *)rx)) {
-         ua->error_msg("%s\n", db_strerror(ua->db));
-      }
-      /* rx->JobId is the PurgedFiles flag */
-      if (rx->found && rx->JobId > 0) {
-         tree.FileCount = 0;           /* set count to zero, no tree selection */
-      }
-   }
-   if (tree.FileCount == 0) {
+   if (tree.FileCount == 0) {          /* no file or purged Job */
       OK = ask_for_fileregex(ua, rx);
       if (OK) {
          last_JobId = 0;
@@ -1468,7 +1471,11 @@ static bool build_directory_tree(UAContext *ua, RESTORE_CTX *rx)
       }
    } else {
       char ec1[50];
-      if (tree.all) {
+      if (tree.loader) {
+         ua->info_msg(_("\n%s files inserted into the tree, the others are inserted while you browse.\n"
+                        "The commands other than cd, ls and pwd wait for the end of the load.\n"),
+                      edit_uint64_with_commas(tree.FileCount, ec1));
+      } else if (tree.all) {
          ua->info_msg(_("\n%s files inserted into the tree and marked for extraction.\n"),
                       edit_uint64_with_commas(tree.FileCount, ec1));
       } else {
@@ -1480,6 +1487,7 @@ static bool build_directory_tree(UAContext *ua, RESTORE_CTX *rx)
          /* Let the user interact in selecting which files to restore */
          OK = user_select_files_from_tree(&tree);
       }
+      wait_tree_loaded(&tree);         /* the tree must be complete */
 
       /*
        * Walk down through the tree finding all files marked to be
@@ -1487,12 +1495,12 @@ static bool build_directory_tree(UAContext *ua, RESTORE_CTX *rx)
        */
       if (OK) {
          char cwd[2000];
-         for (TREE_NODE *node=first_tree_node(tree.root); node; node=next_tree_node(node)) {
+         for (TREE_NODE *node=first_tree_node(tree.root); node; node=next_tree_node(tree.root, node)) {
             Dmsg2(400, "FI=%d node=0x%x\n", node->FileIndex, node);
-            if (node->extract || node->extract_dir) {
+            if (tree_extract(tree.root, node) || tree_extract_dir(tree.root, node)) {
                Dmsg3(400, "JobId=%lld type=%d FI=%d\n", (uint64_t)node->JobId, node->type, node->FileIndex);
                /* TODO: optimize bsr insertion when jobid are non sorted */
-               add_delta_list_findex(rx, node->delta_list);
+               add_delta_list_findex(rx, tree_delta_list(tree.root, node));
                add_findex(rx->bsr_list, node->JobId, node->FileIndex);
                /*
                 * Special VSS plugin code to return selected
@@ -1500,13 +1508,13 @@ static bool build_directory_tree(UAContext *ua, RESTORE_CTX *rx)
                 *   for the VSS plugin.
                 */
                if (fnmatch(":component_info_*", node->fname, 0) == 0) {
-                  tree_getpath(node, cwd, sizeof(cwd));
+                  tree_getpath(tree.root, node, cwd, sizeof(cwd));
                   if (!write_component_file(ua, rx, cwd)) {
                      OK = false;
                      break;
                   }
                }
-               if (node->extract && node->type != TN_NEWDIR) {
+               if (tree_extract(tree.root, node) && node->type != TN_NEWDIR) {
                   rx->selected_files++;  /* count only saved files */
                }
             }
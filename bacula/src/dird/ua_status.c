@@ -434,9 +434,17 @@ static void do_all_status(UAContext *ua)
 
 }
 
+/* Max number of catalog pools displayed by status director */
+#define MAX_POOL_STATUS 30
+
 static void api_list_dir_status_header(UAContext *ua)
 {
+   PRUNE_STATUS prune;
+   CAT_POOL_STATUS pools[MAX_POOL_STATUS];
+   int nb_pools;
    OutputWriter wt(ua->api_opts);
+
+   get_prune_service_status(&prune);
    wt.start_group("header");
    wt.get_output(
       OT_STRING, "name",        my_name,
@@ -456,15 +464,38 @@ static void api_list_dir_status_header(UAContext *ua)
       OT_PLUGINS,"plugins",     b_plugin_list,
       OT_INT32,  "fips",        crypto_get_fips(),
       OT_STRING, "crypto",      crypto_get_version(),
+      OT_INT,    "prune_pending", prune.pending,
+      OT_INT64,  "prune_deleted", prune.deleted,
+      OT_INT64,  "prune_rate",  prune.rate,
       OT_END);
 
    ua->send_msg("%s", wt.end_group());
+
+   nb_pools = get_catalog_pool_status(pools, MAX_POOL_STATUS);
+   for (int i = 0; i < nb_pools; i++) {
+      wt.start_group("catalog_pool", false);
+      wt.get_output(
+         OT_STRING, "catalog",     pools[i].catalog,
+         OT_STRING, "pool",        pools[i].name,
+         OT_INT,    "connections", pools[i].connections,
+         OT_INT,    "max_connections", pools[i].max_connections,
+         OT_INT,    "users",       pools[i].users,
+         OT_INT64,  "requests",    pools[i].requests,
+         OT_INT64,  "waits",       pools[i].waits,
+         OT_INT64,  "wait_time",   pools[i].wait_time,
+         OT_INT64,  "max_wait",    pools[i].max_wait,
+         OT_END);
+      ua->send_msg("%s", wt.end_group());
+   }
 }
 
 void list_dir_status_header(UAContext *ua)
 {
    char dt[MAX_TIME_LENGTH], dt1[MAX_TIME_LENGTH];
    char b1[35], b2[35], b3[35], b4[35], b5[35];
+   PRUNE_STATUS prune;
+   CAT_POOL_STATUS pools[MAX_POOL_STATUS];
+   int nb_pools;
 
    if (ua->api > 1) {
       api_list_dir_status_header(ua);
@@ -503,6 +534,25 @@ void list_dir_status_header(UAContext *ua)
       ((rblist *)res_head[R_FILESET-r_first]->res_list)->size(),
       ((rblist *)res_head[R_SCHEDULE-r_first]->res_list)->size());
 
+   get_prune_service_status(&prune);
+   if (director->BackgroundPruning || prune.pending > 0) {
+      ua->send_msg(_(" Prune: pending=%d jobid=%u deleted=%s rate=%s rows/s\n"),
+         prune.pending, (uint32_t)prune.JobId,
+         edit_uint64_with_commas(prune.deleted, b1),
+         edit_uint64_with_commas(prune.rate, b2));
+   }
+
+   nb_pools = get_catalog_pool_status(pools, MAX_POOL_STATUS);
+   for (int i = 0; i < nb_pools; i++) {
+      ua->send_msg(_(" Catalog pool: %s %s conns=%d/%d users=%d requests=%s"
+                     " waits=%s wait=%sms max_wait=%sms\n"),
+         pools[i].catalog, pools[i].name, pools[i].connections,
+         pools[i].max_connections, pools[i].users,
+         edit_uint64_with_commas(pools[i].requests, b1),
+         edit_uint64_with_commas(pools[i].waits, b2),
+         edit_uint64_with_commas(pools[i].wait_time / 1000, b3),
+         edit_uint64_with_commas(pools[i].max_wait / 1000, b4));
+   }
 
    /* TODO: use this function once for all daemons */
    if (b_plugin_list && b_plugin_list->size() > 0) {
@@ -36,8 +36,48 @@
 #include "findlib/find.h"
 
 
-/* Forward referenced commands */
+/*
+ * The catalog rows are copied into batches by the SQL handler
+ *  of a fetch thread, and a worker thread decodes them and inserts
+ *  them in the tree, so the tree insertion overlaps the fetch of
+ *  the next rows.
+ *
+ * The user gets the prompt once the first files are in the tree.
+ *  The commands that only browse the tree (cd, ls, pwd) run while
+ *  the worker keeps inserting, both take the loader mutex. The
+ *  other commands wait for the end of the load.
+ *
+ * A batch is a TREE_BATCH header followed by num_fields
+ *  strings per row.
+ */
+#define TREE_BATCH_ROWS   1000          /* rows per batch */
+#define TREE_BATCH_SIZE   (256 * 1024)  /* max bytes per batch */
+#define TREE_BATCH_QUEUE  10            /* batches waiting for the worker */
+#define TREE_MAX_FIELDS   10
+
+struct TREE_BATCH {
+   int32_t nb_rows;
+   int32_t num_fields;
+};
+
+struct TREE_LOADER {
+   TREE_CTX *tree;
+   worker *wrk;                       /* inserts the batches */
+   pthread_t fetch_id;                /* runs the catalog query */
+   pthread_mutex_t mutex;             /* tree access while it is loaded */
+   pthread_cond_t cond;               /* signaled after each batch */
+   char *jobids;
+   POOLMEM *buf;                      /* batch being filled */
+   int32_t len;                       /* bytes used in buf */
+   int32_t nb_rows;
+   int32_t num_fields;
+   alist *msgs;                       /* warnings for the UA thread */
+   bool quit;                         /* drop the remaining rows */
+   bool done;                         /* all the rows are inserted */
+   bool ret;                          /* result of db_get_file_list() */
+};
 
+/* Forward referenced commands */
 static int markcmd(UAContext *ua, TREE_CTX *tree);
 static int markdircmd(UAContext *ua, TREE_CTX *tree);
 static int countcmd(UAContext *ua, TREE_CTX *tree);
@@ -59,6 +99,8 @@ static int dot_lsdircmd(UAContext *ua, TREE_CTX *tree);
 static int dot_lscmd(UAContext *ua, TREE_CTX *tree);
 static int dot_helpcmd(UAContext *ua, TREE_CTX *tree);
 static int dot_lsmarkcmd(UAContext *ua, TREE_CTX *tree);
+static void tree_warning_msg(TREE_CTX *tree, const char *msg);
+static void tree_check_load(TREE_CTX *tree);
 
 struct cmdstruct { const char *key; int (*func)(UAContext *ua, TREE_CTX *tree); const char *help; };
 static struct cmdstruct commands[] = {
@@ -90,6 +132,13 @@ static struct cmdstruct commands[] = {
              };
 #define comsize ((int)(sizeof(commands)/sizeof(struct cmdstruct)))
 
+/* Commands that can run while the tree is loaded */
+static bool is_browse_cmd(int (*func)(UAContext *ua, TREE_CTX *tree))
+{
+   return func == cdcmd || func == lscmd || func == dot_lscmd || func == dot_lsdircmd ||
+          func == pwdcmd || func == dot_pwdcmd || func == helpcmd || func == dot_helpcmd;
+}
+
 /*
  * Enter a prompt mode where the user can select/deselect
  *  files to be restored. This is sort of like a mini-shell
@@ -115,11 +164,20 @@ bool user_select_files_from_tree(TREE_CTX *tree)
     * Enter interactive command handler allowing selection
     *  of individual files.
     */
-   tree->node = (TREE_NODE *)tree->root;
-   tree_getpath(tree->node, cwd, sizeof(cwd));
+   if (tree->loader) {
+      P(tree->loader->mutex);
+   }
+   tree->node = tree_root_node(tree->root);
+   tree_getpath(tree->root, tree->node, cwd, sizeof(cwd));
+   if (tree->loader) {
+      V(tree->loader->mutex);
+   }
    ua->send_msg(_("cwd is: %s\n"), cwd);
    for ( ;; ) {
       int found, len, i;
+      if (tree->loader) {
+         tree_check_load(tree);
+      }
       if (!get_cmd(ua, "$ ", true)) {
          break;
       }
@@ -136,7 +194,23 @@ bool user_select_files_from_tree(TREE_CTX *tree)
       stat = false;
       for (i=0; i<comsize; i++)       /* search for command */
          if (strncasecmp(ua->argk[0],  commands[i].key, len) == 0) {
-            stat = (*commands[i].func)(ua, tree);   /* go execute command */
+            if (tree->loader && !is_browse_cmd(commands[i].func)) {
+               if (commands[i].func == quitcmd) {
+                  P(tree->loader->mutex);
+                  tree->loader->quit = true;     /* stop inserting */
+                  V(tree->loader->mutex);
+               } else {
+                  ua->send_msg(_("Waiting for the end of the tree load...\n"));
+               }
+               wait_tree_loaded(tree);
+            }
+            if (tree->loader) {
+               P(tree->loader->mutex);
+               stat = (*commands[i].func)(ua, tree);   /* go execute command */
+               V(tree->loader->mutex);
+            } else {
+               stat = (*commands[i].func)(ua, tree);   /* go execute command */
+            }
             found = 1;
             break;
          }
@@ -230,9 +304,11 @@ int insert_tree_handler(void *ctx, int num_fields, char **row)
             tree_remove_node(tree->root, node);
 
          } else {
-            tree->ua->warning_msg(_("Something is wrong with the Delta sequence of %s, "
-                                    "skipping new parts. Current sequence is %d\n"),
-                                  row[1], node->delta_seq);
+            POOL_MEM msg;
+            Mmsg(msg, _("Something is wrong with the Delta sequence of %s, "
+                        "skipping new parts. Current sequence is %d\n"),
+                 row[1], node->delta_seq);
+            tree_warning_msg(tree, msg.c_str());
 
             Dmsg3(0, "Something is wrong with Delta, skip it "
                   "fname=%s d1=%d d2=%d\n", row[1], node->delta_seq, delta_seq);
@@ -269,9 +345,9 @@ int insert_tree_handler(void *ctx, int num_fields, char **row)
          mark_access_denied(node);
 
       } else if (tree->all) {
-         node->extract = true;          /* extract all by default */
+         tree_set_extract(tree->root, node, true);  /* extract all by default */
          if (type == TN_DIR || type == TN_DIR_NLS) {
-            node->extract_dir = true;   /* if dir, extract it */
+            tree_set_extract_dir(tree->root, node, true); /* if dir, extract it */
          }
       }
       /* insert file having hardlinks into hardlink hashtable */
@@ -298,7 +374,9 @@ int insert_tree_handler(void *ctx, int num_fields, char **row)
    }
    if (node->inserted) {
       tree->FileCount++;
-      if (tree->DeltaCount > 0 && (tree->FileCount-tree->LastCount) > tree->DeltaCount) {
+      /* With a loader, the UA thread sends the ticks */
+      if (!tree->loader && tree->DeltaCount > 0 &&
+          (tree->FileCount-tree->LastCount) > tree->DeltaCount) {
          tree->ua->send_msg("+");
          tree->LastCount = tree->FileCount;
       }
@@ -307,6 +385,275 @@ int insert_tree_handler(void *ctx, int num_fields, char **row)
    return 0;
 }
 
+/*
+ * Called from insert_tree_handler(), only the UA thread can
+ *  talk to the console.
+ */
+static void tree_warning_msg(TREE_CTX *tree, const char *msg)
+{
+   if (tree->loader) {
+      tree->loader->msgs->append(bstrdup(msg));  /* loader mutex is held */
+   } else {
+      tree->ua->warning_msg("%s", msg);
+   }
+}
+
+/* Send the warnings and the progress ticks of the worker */
+static void tree_send_load_msgs(TREE_CTX *tree, bool ticks)
+{
+   TREE_LOADER *ld = tree->loader;
+   char *msg;
+
+   foreach_alist(msg, ld->msgs) {
+      tree->ua->warning_msg("%s", msg);
+   }
+   ld->msgs->destroy();
+   while (ticks && tree->DeltaCount > 0 &&
+          (tree->FileCount - tree->LastCount) > tree->DeltaCount) {
+      tree->ua->send_msg("+");
+      tree->LastCount += tree->DeltaCount;
+   }
+}
+
+static void *tree_insert_thread(void *arg)
+{
+   worker *wrk = (worker *)arg;
+   TREE_LOADER *ld = (TREE_LOADER *)wrk->get_ctx();
+   TREE_BATCH *batch;
+   char *row[TREE_MAX_FIELDS];
+   POOLMEM *buf;
+   char *p;
+
+   lmgr_init_thread();                /* worker.c uses the real pthread_create() */
+   wrk->set_running();
+   while (!wrk->is_quit_state()) {
+      if (wrk->is_wait_state()) {
+         wrk->wait();
+         continue;
+      }
+      if ((buf = (POOLMEM *)wrk->dequeue()) == NULL) {
+         continue;
+      }
+      batch = (TREE_BATCH *)buf;
+      p = buf + sizeof(TREE_BATCH);
+      P(ld->mutex);
+      for (int i = 0; i < batch->nb_rows && !ld->quit; i++) {
+         for (int j = 0; j < batch->num_fields; j++) {
+            row[j] = p;
+            p += strlen(p) + 1;
+         }
+         insert_tree_handler(ld->tree, batch->num_fields, row);
+      }
+      pthread_cond_broadcast(&ld->cond);
+      V(ld->mutex);
+      wrk->push_free_buffer(buf);
+   }
+   lmgr_cleanup_thread();
+   return NULL;
+}
+
+static void tree_flush_batch(TREE_LOADER *ld)
+{
+   TREE_BATCH *batch;
+
+   if (!ld->buf || ld->nb_rows == 0) {
+      return;
+   }
+   batch = (TREE_BATCH *)ld->buf;
+   batch->nb_rows = ld->nb_rows;
+   batch->num_fields = ld->num_fields;
+   ld->wrk->queue(ld->buf);           /* waits if the worker is late */
+   ld->buf = NULL;
+}
+
+static int tree_queue_handler(void *ctx, int num_fields, char **row)
+{
+   TREE_LOADER *ld = (TREE_LOADER *)ctx;
+   const char *field;
+   int32_t len;
+
+   if (ld->quit) {
+      return 0;                       /* the user left the tree */
+   }
+   if (!ld->buf) {
+      if ((ld->buf = (POOLMEM *)ld->wrk->pop_free_buffer()) == NULL) {
+         ld->buf = get_pool_memory(PM_MESSAGE);
+      }
+      ld->len = sizeof(TREE_BATCH);
+      ld->nb_rows = 0;
+   }
+   num_fields = MIN(num_fields, TREE_MAX_FIELDS);
+   for (int i = 0; i < num_fields; i++) {
+      field = NPRTB(row[i]);
+      len = strlen(field) + 1;
+      ld->buf = check_pool_memory_size(ld->buf, ld->len + len);
+      memcpy(ld->buf + ld->len, field, len);
+      ld->len += len;
+   }
+   ld->num_fields = num_fields;
+   if (++ld->nb_rows >= TREE_BATCH_ROWS || ld->len >= TREE_BATCH_SIZE) {
+      tree_flush_batch(ld);
+   }
+   return 0;
+}
+
+static void *tree_fetch_thread(void *arg)
+{
+   TREE_LOADER *ld = (TREE_LOADER *)arg;
+   UAContext *ua = ld->tree->ua;
+   bool ret;
+
+   ret = db_get_file_list(ua->jcr, ua->db, ld->jobids, DBL_USE_DELTA,
+                          tree_queue_handler, (void *)ld);
+   tree_flush_batch(ld);
+   if (ld->buf) {
+      free_pool_memory(ld->buf);
+      ld->buf = NULL;
+   }
+   ld->wrk->finish_work();            /* wait for the last batch */
+   P(ld->mutex);
+   ld->ret = ret;
+   ld->done = true;
+   pthread_cond_broadcast(&ld->cond);
+   V(ld->mutex);
+   return NULL;
+}
+
+static void free_tree_loader(TREE_LOADER *ld)
+{
+   delete ld->wrk;
+   delete ld->msgs;
+   pthread_cond_destroy(&ld->cond);
+   pthread_mutex_destroy(&ld->mutex);
+   free(ld->jobids);
+   free(ld);
+}
+
+/* Release the loader once all the rows are inserted */
+static bool tree_end_load(TREE_CTX *tree)
+{
+   TREE_LOADER *ld = tree->loader;
+   bool ret = ld->ret;
+
+   pthread_join(ld->fetch_id, NULL);
+   ld->wrk->stop();
+   tree_send_load_msgs(tree, false);
+   tree->loader = NULL;
+   free_tree_loader(ld);
+   if (!ret) {
+      tree->ua->error_msg("%s", db_strerror(tree->ua->db));
+   }
+   /* Sort the children of each directory for the file selection */
+   tree_build_children(tree->root);
+   return ret;
+}
+
+/*
+ * Wait until the rows are inserted in the tree, or only until
+ *  the first ones when first_rows is set. Must be called with the
+ *  loader mutex.
+ */
+static void tree_wait_rows(TREE_CTX *tree, bool first_rows, bool ticks)
+{
+   TREE_LOADER *ld = tree->loader;
+   struct timespec to;
+
+   while (!ld->done && !(first_rows && tree->FileCount > 0)) {
+      to.tv_sec = time(NULL) + 1;
+      to.tv_nsec = 0;
+      pthread_cond_timedwait(&ld->cond, &ld->mutex, &to);
+      tree_send_load_msgs(tree, ticks);
+   }
+}
+
+/*
+ * Called by the UA thread between two commands to send the
+ *  warnings of the worker and to release the loader at the end.
+ */
+static void tree_check_load(TREE_CTX *tree)
+{
+   char ec1[50];
+   bool done;
+
+   P(tree->loader->mutex);
+   tree_send_load_msgs(tree, false);
+   done = tree->loader->done;
+   V(tree->loader->mutex);
+   if (done && tree_end_load(tree)) {
+      tree->ua->send_msg(_("The tree is loaded, %s files inserted.\n"),
+                         edit_uint64_with_commas(tree->FileCount, ec1));
+   }
+}
+
+/*
+ * Wait for the end of a background load, then the tree
+ *  cannot change anymore.
+ *  Returns false on catalog error.
+ */
+bool wait_tree_loaded(TREE_CTX *tree)
+{
+   if (!tree->loader) {
+      return true;
+   }
+   P(tree->loader->mutex);
+   tree_wait_rows(tree, false, false);
+   V(tree->loader->mutex);
+   return tree_end_load(tree);
+}
+
+/*
+ * Load the files of the given JobIds into the tree. When wait is
+ *  not set, return as soon as the first files are in the tree and
+ *  let the worker insert the others, see wait_tree_loaded().
+ *  Returns false on catalog error.
+ */
+bool load_tree_from_catalog(TREE_CTX *tree, char *jobids, bool wait)
+{
+   UAContext *ua = tree->ua;
+   TREE_LOADER *ld;
+   bool ret;
+
+   ld = (TREE_LOADER *)malloc(sizeof(TREE_LOADER));
+   memset(ld, 0, sizeof(TREE_LOADER));
+   ld->tree = tree;
+   ld->jobids = bstrdup(jobids);
+   ld->msgs = New(alist(10, owned_by_alist));
+   pthread_mutex_init(&ld->mutex, NULL);
+   pthread_cond_init(&ld->cond, NULL);
+   ld->wrk = New(worker(TREE_BATCH_QUEUE));
+   if (ld->wrk->start(tree_insert_thread, ld) != 0) {
+      Dmsg0(50, "Unable to start the tree worker, insert the rows directly\n");
+      free_tree_loader(ld);
+      goto insert_rows;
+   }
+   tree->loader = ld;
+   if (pthread_create(&ld->fetch_id, NULL, tree_fetch_thread, (void *)ld) != 0) {
+      Dmsg0(50, "Unable to start the tree fetch thread, insert the rows directly\n");
+      tree->loader = NULL;
+      ld->wrk->finish_work();
+      ld->wrk->stop();
+      free_tree_loader(ld);
+      goto insert_rows;
+   }
+   P(ld->mutex);
+   tree_wait_rows(tree, !wait, true);
+   ret = ld->done;
+   V(ld->mutex);
+   if (ret) {
+      return tree_end_load(tree);     /* everything is in the tree */
+   }
+   return true;
+
+insert_rows:
+   ret = db_get_file_list(ua->jcr, ua->db, jobids, DBL_USE_DELTA,
+                          insert_tree_handler, (void *)tree);
+   if (!ret) {
+      ua->error_msg("%s", db_strerror(ua->db));
+   }
+   tree_build_children(tree->root);
+   return ret;
+}
+
 /*
  * Set extract to value passed. We recursively walk
  *  down the tree setting all children if the
@@ -314,7 +661,8 @@ int insert_tree_handler(void *ctx, int num_fields, char **row)
  */
 static int set_extract(UAContext *ua, TREE_NODE *node, TREE_CTX *tree, bool extract)
 {
-   TREE_NODE *n;
+   TREE_ROOT *root = tree->root;
+   TREE_NODE *n, *parent;
    int count = 0;
 
    /* The node is not accessible, just stop here */
@@ -322,9 +670,9 @@ static int set_extract(UAContext *ua, TREE_NODE *node, TREE_CTX *tree, bool extr
       return 0;
    }
 
-   node->extract = extract;
+   tree_set_extract(root, node, extract);
    if (node->type == TN_DIR || node->type == TN_DIR_NLS) {
-      node->extract_dir = extract;    /* set/clear dir too */
+      tree_set_extract_dir(root, node, extract);    /* set/clear dir too */
    }
    if (node->type != TN_NEWDIR) {
       count++;
@@ -332,7 +680,7 @@ static int set_extract(UAContext *ua, TREE_NODE *node, TREE_CTX *tree, bool extr
    /* For a non-file (i.e. directory), we see all the children */
    if (node->type != TN_FILE || (node->soft_link && tree_node_has_child(node))) {
       /* Recursive set children within directory */
-      foreach_child(n, node) {
+      foreach_child(root, n, node) {
          count += set_extract(ua, n, tree, extract);
       }
       /*
@@ -340,9 +688,9 @@ static int set_extract(UAContext *ua, TREE_NODE *node, TREE_CTX *tree, bool extr
        * extracted.
        */
       if (!tree->no_auto_parent && extract) {
-         while (node->parent && !node->parent->extract_dir) {
-            node = node->parent;
-            node->extract_dir = true;
+         while ((parent = tree_parent(root, node)) && !tree_extract_dir(root, parent)) {
+            node = parent;
+            tree_set_extract_dir(root, node, true);
          }
       }
    } else if (extract) {
@@ -361,7 +709,7 @@ static int set_extract(UAContext *ua, TREE_NODE *node, TREE_CTX *tree, bool extr
           * attributes, decode them, and if we are hard linked to
           * a file that was saved, we must load that file too.
           */
-         tree_getpath(node, cwd, sizeof(cwd));
+         tree_getpath(root, node, cwd, sizeof(cwd));
          fdbr.FileId = 0;
          fdbr.JobId = node->JobId;
          if (node->hard_link && db_get_file_attributes_record(ua->jcr, ua->db, cwd, NULL, &fdbr)) {
@@ -376,11 +724,11 @@ static int set_extract(UAContext *ua, TREE_NODE *node, TREE_CTX *tree, bool extr
           * If we point to a hard linked file, find that file in
           * hardlinks hashmap, and mark it to be restored as well.
           */
-         HL_ENTRY *entry = (HL_ENTRY *)tree->root->hardlinks.lookup(key);
+         HL_ENTRY *entry = (HL_ENTRY *)root->hardlinks.lookup(key);
          if (entry && entry->node) {
             n = entry->node;
-            n->extract = true;
-            n->extract_dir = (n->type == TN_DIR || n->type == TN_DIR_NLS);
+            tree_set_extract(root, n, true);
+            tree_set_extract_dir(root, n, n->type == TN_DIR || n->type == TN_DIR_NLS);
          }
       }
    }
@@ -415,7 +763,7 @@ static int markcmd(UAContext *ua, TREE_CTX *tree)
    }
    for (int i=1; i < ua->argc; i++) {
       strip_trailing_slash(ua->argk[i]);
-      foreach_child(node, tree->node) {
+      foreach_child(tree->root, node, tree->node) {
          if (fnmatch(ua->argk[i], node->fname, 0) == 0) {
             count += set_extract(ua, node, tree, true);
          }
@@ -444,10 +792,10 @@ static int markdircmd(UAContext *ua, TREE_CTX *tree)
    }
    for (int i=1; i < ua->argc; i++) {
       strip_trailing_slash(ua->argk[i]);
-      foreach_child(node, tree->node) {
+      foreach_child(tree->root, node, tree->node) {
          if (fnmatch(ua->argk[i], node->fname, 0) == 0) {
             if (node->type == TN_DIR || node->type == TN_DIR_NLS) {
-               node->extract_dir = true;
+               tree_set_extract_dir(tree->root, node, true);
                count++;
             }
          }
@@ -471,10 +819,10 @@ static int countcmd(UAContext *ua, TREE_CTX *tree)
    char ec1[50], ec2[50];
 
    total = num_extract = 0;
-   for (TREE_NODE *node=first_tree_node(tree->root); node; node=next_tree_node(node)) {
+   for (TREE_NODE *node=first_tree_node(tree->root); node; node=next_tree_node(tree->root, node)) {
       if (node->type != TN_NEWDIR) {
          total++;
-         if (node->extract || node->extract_dir) {
+         if (tree_extract(tree->root, node) || tree_extract_dir(tree->root, node)) {
             num_extract++;
          }
       }
@@ -495,13 +843,13 @@ static int findcmd(UAContext *ua, TREE_CTX *tree)
    }
 
    for (int i=1; i < ua->argc; i++) {
-      for (TREE_NODE *node=first_tree_node(tree->root); node; node=next_tree_node(node)) {
+      for (TREE_NODE *node=first_tree_node(tree->root); node; node=next_tree_node(tree->root, node)) {
          if (fnmatch(ua->argk[i], node->fname, 0) == 0) {
             const char *tag;
-            tree_getpath(node, cwd, sizeof(cwd));
-            if (node->extract) {
+            tree_getpath(tree->root, node, cwd, sizeof(cwd));
+            if (tree_extract(tree->root, node)) {
                tag = "*";
-            } else if (node->extract_dir) {
+            } else if (tree_extract_dir(tree->root, node)) {
                tag = "+";
             } else {
                tag = "";
@@ -521,7 +869,7 @@ static int dot_lsdircmd(UAContext *ua, TREE_CTX *tree)
       return 1;
    }
 
-   foreach_child(node, tree->node) {
+   foreach_child(tree->root, node, tree->node) {
       if (ua->argc == 1 || fnmatch(ua->argk[1], node->fname, 0) == 0) {
          if (tree_node_has_child(node)) {
             ua->send_msg("%s/\n", node->fname);
@@ -551,7 +899,7 @@ static int dot_lscmd(UAContext *ua, TREE_CTX *tree)
       return 1;
    }
 
-   foreach_child(node, tree->node) {
+   foreach_child(tree->root, node, tree->node) {
       if (ua->argc == 1 || fnmatch(ua->argk[1], node->fname, 0) == 0) {
          ua->send_msg("%s%s\n", node->fname, tree_node_has_child(node)?"/":"");
       }
@@ -567,12 +915,12 @@ static int lscmd(UAContext *ua, TREE_CTX *tree)
    if (!tree_node_has_child(tree->node)) {
       return 1;
    }
-   foreach_child(node, tree->node) {
+   foreach_child(tree->root, node, tree->node) {
       if (ua->argc == 1 || fnmatch(ua->argk[1], node->fname, 0) == 0) {
          const char *tag;
-         if (node->extract) {
+         if (tree_extract(tree->root, node)) {
             tag = "*";
-         } else if (node->extract_dir) {
+         } else if (tree_extract_dir(tree->root, node)) {
             tag = "+";
          } else {
             tag = "";
@@ -592,9 +940,9 @@ static int dot_lsmarkcmd(UAContext *ua, TREE_CTX *tree)
    if (!tree_node_has_child(tree->node)) {
       return 1;
    }
-   foreach_child(node, tree->node) {
+   foreach_child(tree->root, node, tree->node) {
       if ((ua->argc == 1 || fnmatch(ua->argk[1], node->fname, 0) == 0) &&
-          (node->extract || node->extract_dir)) {
+          (tree_extract(tree->root, node) || tree_extract_dir(tree->root, node))) {
          ua->send_msg("%s%s\n", node->fname, tree_node_has_child(node)?"/":"");
       }
    }
@@ -604,7 +952,7 @@ static int dot_lsmarkcmd(UAContext *ua, TREE_CTX *tree)
 /*
  * This recursive ls command that lists only the marked files
  */
-static void rlsmark(UAContext *ua, TREE_NODE *tnode, int level)
+static void rlsmark(UAContext *ua, TREE_ROOT *root, TREE_NODE *tnode, int level)
 {
    TREE_NODE *node;
    const int max_level = 100;
@@ -620,20 +968,20 @@ static void rlsmark(UAContext *ua, TREE_NODE *tnode, int level)
       indent[j++] = ' ';
    }
    indent[j] = 0;
-   foreach_child(node, tnode) {
+   foreach_child(root, node, tnode) {
       if ((ua->argc == 1 || fnmatch(ua->argk[1], node->fname, 0) == 0) &&
-          (node->extract || node->extract_dir)) {
+          (tree_extract(root, node) || tree_extract_dir(root, node))) {
          const char *tag;
-         if (node->extract) {
+         if (tree_extract(root, node)) {
             tag = "*";
-         } else if (node->extract_dir) {
+         } else if (tree_extract_dir(root, node)) {
             tag = "+";
          } else {
             tag = "";
          }
          ua->send_msg("%s%s%s%s\n", indent, tag, node->fname, tree_node_has_child(node)?"/":"");
          if (tree_node_has_child(node)) {
-            rlsmark(ua, node, level+1);
+            rlsmark(ua, root, node, level+1);
          }
       }
    }
@@ -641,7 +989,7 @@ static void rlsmark(UAContext *ua, TREE_NODE *tnode, int level)
 
 static int lsmarkcmd(UAContext *ua, TREE_CTX *tree)
 {
-   rlsmark(ua, tree->node, 0);
+   rlsmark(ua, tree->root, tree->node, 0);
    return 1;
 }
 
@@ -716,17 +1064,17 @@ static int do_dircmd(UAContext *ua, TREE_CTX *tree, bool dot_cmd)
    }
 
    guid = new_guid_list();
-   foreach_child(node, tree->node) {
+   foreach_child(tree->root, node, tree->node) {
       const char *tag;
       if (ua->argc == 1 || fnmatch(ua->argk[1], node->fname, 0) == 0) {
-         if (node->extract) {
+         if (tree_extract(tree->root, node)) {
             tag = "*";
-         } else if (node->extract_dir) {
+         } else if (tree_extract_dir(tree->root, node)) {
             tag = "+";
          } else {
             tag = " ";
          }
-         tree_getpath(node, cwd, sizeof(cwd));
+         tree_getpath(tree->root, node, cwd, sizeof(cwd));
          fdbr.FileId = 0;
          fdbr.JobId = node->JobId;
          /*
@@ -782,13 +1130,13 @@ static int estimatecmd(UAContext *ua, TREE_CTX *tree)
    char ec1[50];
 
    total = num_extract = 0;
-   for (TREE_NODE *node=first_tree_node(tree->root); node; node=next_tree_node(node)) {
+   for (TREE_NODE *node=first_tree_node(tree->root); node; node=next_tree_node(tree->root, node)) {
       if (node->type != TN_NEWDIR) {
          total++;
          /* If regular file, get size */
-         if (node->extract && node->type == TN_FILE) {
+         if (tree_extract(tree->root, node) && node->type == TN_FILE) {
             num_extract++;
-            tree_getpath(node, cwd, sizeof(cwd));
+            tree_getpath(tree->root, node, cwd, sizeof(cwd));
             fdbr.FileId = 0;
             fdbr.JobId = node->JobId;
             if (db_get_file_attributes_record(ua->jcr, ua->db, cwd, NULL, &fdbr)) {
@@ -799,7 +1147,7 @@ static int estimatecmd(UAContext *ua, TREE_CTX *tree)
                }
             }
          /* Directory, count only */
-         } else if (node->extract || node->extract_dir) {
+         } else if (tree_extract(tree->root, node) || tree_extract_dir(tree->root, node)) {
             num_extract++;
          }
       }
@@ -867,7 +1215,7 @@ static int cdcmd(UAContext *ua, TREE_CTX *tree)
 static int pwdcmd(UAContext *ua, TREE_CTX *tree)
 {
    char cwd[2000];
-   tree_getpath(tree->node, cwd, sizeof(cwd));
+   tree_getpath(tree->root, tree->node, cwd, sizeof(cwd));
    if (ua->api) {
       ua->send_msg("%s", cwd);
    } else {
@@ -879,7 +1227,7 @@ static int pwdcmd(UAContext *ua, TREE_CTX *tree)
 static int dot_pwdcmd(UAContext *ua, TREE_CTX *tree)
 {
    char cwd[2000];
-   tree_getpath(tree->node, cwd, sizeof(cwd));
+   tree_getpath(tree->root, tree->node, cwd, sizeof(cwd));
    ua->send_msg("%s", cwd);
    return 1;
 }
@@ -895,7 +1243,7 @@ static int unmarkcmd(UAContext *ua, TREE_CTX *tree)
    }
    for (int i=1; i < ua->argc; i++) {
       strip_trailing_slash(ua->argk[i]);
-      foreach_child(node, tree->node) {
+      foreach_child(tree->root, node, tree->node) {
          if (fnmatch(ua->argk[i], node->fname, 0) == 0) {
             count += set_extract(ua, node, tree, false);
          }
@@ -924,10 +1272,10 @@ static int unmarkdircmd(UAContext *ua, TREE_CTX *tree)
 
    for (int i=1; i < ua->argc; i++) {
       strip_trailing_slash(ua->argk[i]);
-      foreach_child(node, tree->node) {
+      foreach_child(tree->root, node, tree->node) {
          if (fnmatch(ua->argk[i], node->fname, 0) == 0) {
             if (node->type == TN_DIR || node->type == TN_DIR_NLS) {
-               node->extract_dir = false;
+               tree_set_extract_dir(tree->root, node, false);
                count++;
             }
          }
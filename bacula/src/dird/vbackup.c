@@ -603,6 +603,8 @@ static bool create_bootstrap_file(JCR *jcr, char *jobids)
    {
       Jmsg(jcr, M_ERROR, 0, "%s", db_strerror(jcr->db_batch));
    }
+   /* The attributes of the new Job will take it again */
+   release_batch_connection(jcr);
 #else
    char *p;
    JobId_t JobId, last_JobId = 0;
@@ -47,7 +47,27 @@ static char OKbootstrap[] = "3000 OK bootstrap\n";
 
 /* Forward referenced functions */
 static void prt_fname(JCR *jcr);
-static int missing_handler(void *ctx, int num_fields, char **row);
+
+/*
+ * File record of the Job that we verify. All the records of the
+ *  Job are loaded in a hash table before the comparison.
+ */
+typedef struct PrivateVerifyFile {
+   hlink link;
+   char *fname;                  /* Path + Filename */
+   char *lstat;
+   char *digest;
+   int32_t FileIndex;
+   bool seen;                    /* reported by the FD */
+} VerifyFile;
+
+struct verify_list_ctx {
+   JCR *jcr;
+   htable *list;
+   bool by_index;                /* VolumeToCatalog matches the FileIndex */
+};
+
+static int verify_list_handler(void *ctx, int num_fields, char **row);
 
 /*
  * Called here before the job is run to do the job
@@ -599,7 +619,8 @@ void get_attributes_and_compare_to_catalog(JCR *jcr, JobId_t JobId)
 {
    BSOCK   *fd;
    int n, len;
-   FILE_DBR fdbr;
+   VerifyFile *elt = NULL;
+   struct verify_list_ctx lctx;
    struct stat statf;                 /* file stat */
    struct stat statc;                 /* catalog stat */
    char buf[MAXSTRING];
@@ -607,11 +628,23 @@ void get_attributes_and_compare_to_catalog(JCR *jcr, JobId_t JobId)
    int do_Digest = CRYPTO_DIGEST_NONE;
    int32_t file_index = 0;
 
-   memset(&fdbr, 0, sizeof(FILE_DBR));
    fd = jcr->file_bsock;
-   fdbr.JobId = JobId;
    jcr->FileIndex = 0;
 
+   /*
+    * Load all the File records of the Job with one query, the
+    *  FD/SD stream is then compared without going to the catalog.
+    */
+   lctx.jcr = jcr;
+   lctx.by_index = jcr->getJobLevel() == L_VERIFY_VOLUME_TO_CATALOG;
+   lctx.list = New(htable(elt, &elt->link, MAX(jcr->previous_jr.JobFiles, 100)));
+   if (!db_get_verify_file_list(jcr, jcr->db, JobId, verify_list_handler, &lctx)) {
+      Jmsg(jcr, M_FATAL, 0, _("Could not get the File records of JobId=%d. ERR=%s"),
+           JobId, db_strerror(jcr->db));
+      goto bail_out;
+   }
+   Dmsg2(20, "Loaded %d File records of JobId=%d\n", lctx.list->size(), JobId);
+
    Dmsg0(20, "bdird: waiting to receive file attributes\n");
    /*
     * Get Attributes and Signature from File daemon
@@ -629,8 +662,7 @@ void get_attributes_and_compare_to_catalog(JCR *jcr, JobId_t JobId)
       char Opts_Digest[MAXSTRING];        /* Verify Opts or MD5/SHA1 digest */
 
       if (job_canceled(jcr)) {
-         free_pool_memory(fname);
-         return;
+         goto bail_out;
       }
       fname = check_pool_memory_size(fname, fd->msglen);
       jcr->fname = check_pool_memory_size(jcr->fname, fd->msglen);
@@ -639,8 +671,7 @@ void get_attributes_and_compare_to_catalog(JCR *jcr, JobId_t JobId)
             fname)) != 3) {
          Jmsg3(jcr, M_FATAL, 0, _("bird<filed: bad attributes, expected 3 fields got %d\n"
 " mslen=%d msg=%s\n"), len, fd->msglen, fd->msg);
-         free_pool_memory(fname);
-         return;
+         goto bail_out;
       }
       stream = full_stream & STREAMMASK_TYPE;
       Dmsg4(30, "Got hdr: FilInx=%d FullStream=%d Stream=%d fname=%s.\n", file_index, full_stream, stream, fname);
@@ -681,30 +712,32 @@ void get_attributes_and_compare_to_catalog(JCR *jcr, JobId_t JobId)
          Dmsg1(020, "dird<filed: attr=%s\n", attr);
 
          /*
-          * Find equivalent record in the database
+          * Find equivalent record in the catalog list
           */
-         fdbr.FileId = 0;
+         elt = NULL;
          /* Don't look for deleted records */
          if (jcr->FileIndex <= 0) {
             continue;
          }
-         if (!db_get_file_attributes_record(jcr, jcr->db, jcr->fname,
-              &jcr->previous_jr, &fdbr)) {
+         if (lctx.by_index) {
+            elt = (VerifyFile *)lctx.list->lookup((uint64_t)jcr->FileIndex);
+            if (elt && strcmp(elt->fname, jcr->fname) != 0) {
+               elt = NULL;
+            }
+         } else {
+            elt = (VerifyFile *)lctx.list->lookup(jcr->fname);
+         }
+         if (!elt) {
             Jmsg(jcr, M_INFO, 0, _("New file: %s\n"), jcr->fname);
             Dmsg1(020, _("File not in catalog: %s\n"), jcr->fname);
             jcr->setJobStatus(JS_Differences);
             continue;
-         } else {
-            /*
-             * mark file record as visited by stuffing the
-             * current JobId, which is unique, into the MarkId field.
-             */
-            db_mark_file_record(jcr, jcr->db, fdbr.FileId, jcr->JobId);
          }
+         elt->seen = true;
 
          Dmsg3(400, "Found %s in catalog. inx=%d Opts=%s\n", jcr->fname,
             file_index, Opts_Digest);
-         decode_stat(fdbr.LStat, &statc, sizeof(statc), &LinkFIc); /* decode catalog stat */
+         decode_stat(elt->lstat, &statc, sizeof(statc), &LinkFIc); /* decode catalog stat */
          /*
           * Loop over options supplied by user and verify the
           * fields he requests.
@@ -820,15 +853,14 @@ void get_attributes_and_compare_to_catalog(JCR *jcr, JobId_t JobId)
          if (jcr->FileIndex != file_index) {
             Jmsg2(jcr, M_FATAL, 0, _("MD5/SHA1 index %d not same as attributes %d\n"),
                file_index, jcr->FileIndex);
-            free_pool_memory(fname);
-            return;
+            goto bail_out;
          }
-         if (do_Digest != CRYPTO_DIGEST_NONE) {
+         if (do_Digest != CRYPTO_DIGEST_NONE && elt) {
             db_escape_string(jcr, jcr->db, buf, Opts_Digest, strlen(Opts_Digest));
-            if (strcmp(buf, fdbr.Digest) != 0) {
+            if (strcmp(buf, elt->digest) != 0) {
                prt_fname(jcr);
                Jmsg(jcr, M_INFO, 0, _("      %s differs. File=%s Cat=%s\n"),
-                    stream_to_ascii(stream), buf, fdbr.Digest);
+                    stream_to_ascii(stream), buf, elt->digest);
                jcr->setJobStatus(JS_Differences);
             }
             do_Digest = CRYPTO_DIGEST_NONE;
@@ -840,46 +872,75 @@ void get_attributes_and_compare_to_catalog(JCR *jcr, JobId_t JobId)
       berrno be;
       Jmsg2(jcr, M_FATAL, 0, _("bdird<filed: bad attributes from filed n=%d : %s\n"),
                         n, be.bstrerror());
-      free_pool_memory(fname);
-      return;
+      goto bail_out;
    }
 
    /* Now find all the files that are missing -- i.e. all files in
-    *  the database where the MarkId != current JobId
+    *  the catalog list that were not seen
     */
    jcr->fn_printed = false;
-   bsnprintf(buf, sizeof(buf),
-      "SELECT Path.Path,File.Filename FROM File,Path "
-       "WHERE File.JobId=%d AND File.FileIndex > 0 "
-         "AND File.MarkId!=%d AND File.PathId=Path.PathId ",
-         JobId, jcr->JobId);
-   /* missing_handler is called for each file found */
-   db_sql_query(jcr->db, buf, missing_handler, (void *)jcr);
+   foreach_htable(elt, lctx.list) {
+      if (job_canceled(jcr)) {
+         break;
+      }
+      if (elt->seen) {
+         continue;
+      }
+      if (!jcr->fn_printed) {
+         Qmsg(jcr, M_WARNING, 0, _("The following files are in the Catalog but not on %s:\n"),
+             jcr->getJobLevel() == L_VERIFY_VOLUME_TO_CATALOG ? "the Volume(s)" : "disk");
+         jcr->fn_printed = true;
+      }
+      Qmsg(jcr, M_INFO, 0, "      %s\n", elt->fname);
+   }
    if (jcr->fn_printed) {
       jcr->setJobStatus(JS_Differences);
    }
+
+bail_out:
+   delete lctx.list;
    free_pool_memory(fname);
 }
 
 /*
- * We are called here for each record that matches the above
- *  SQL query -- that is for each file contained in the Catalog
- *  that was not marked earlier. This means that the file in
- *  question is a missing file (in the Catalog but not on Disk).
+ * We are called here for each File record of the Job that we
+ *  verify, we keep the record in the hash table. The name and
+ *  the attributes are stored in the same chunk.
  */
-static int missing_handler(void *ctx, int num_fields, char **row)
+static int verify_list_handler(void *ctx, int num_fields, char **row)
 {
-   JCR *jcr = (JCR *)ctx;
+   struct verify_list_ctx *lctx = (struct verify_list_ctx *)ctx;
+   VerifyFile *item;
+   int plen, flen, llen, dlen;
 
-   if (job_canceled(jcr)) {
+   if (job_canceled(lctx->jcr)) {
       return 1;
    }
-   if (!jcr->fn_printed) {
-      Qmsg(jcr, M_WARNING, 0, _("The following files are in the Catalog but not on %s:\n"),
-          jcr->getJobLevel() == L_VERIFY_VOLUME_TO_CATALOG ? "the Volume(s)" : "disk");
-      jcr->fn_printed = true;
+   plen = strlen(row[0]);
+   flen = strlen(row[1]);
+   llen = strlen(row[3]);
+   dlen = row[4] ? strlen(row[4]) : 0;
+
+   item = (VerifyFile *)lctx->list->hash_malloc(sizeof(VerifyFile) +
+                                               plen + flen + llen + dlen + 3);
+   item->fname = (char *)item + sizeof(VerifyFile);
+   memcpy(item->fname, row[0], plen);
+   memcpy(item->fname + plen, row[1], flen + 1);
+
+   item->lstat = item->fname + plen + flen + 1;
+   memcpy(item->lstat, row[3], llen + 1);
+
+   item->digest = item->lstat + llen + 1;
+   memcpy(item->digest, row[4] ? row[4] : "", dlen + 1);
+
+   item->FileIndex = str_to_int64(row[2]);
+   item->seen = false;
+
+   if (lctx->by_index) {
+      lctx->list->insert((uint64_t)item->FileIndex, item);
+   } else {
+      lctx->list->insert(item->fname, item);
    }
-   Qmsg(jcr, M_INFO, 0, "      %s%s\n", row[0]?row[0]:"", row[1]?row[1]:"");
    return 0;
 }
 
@@ -342,6 +342,7 @@ bool accurate_check_file(JCR *jcr, FF_PKT *ff_pkt)
 
    ff_pkt->delta_seq = 0;
    ff_pkt->accurate_found = false;
+   jcr->accurate_data_len = 0;
 
    if (!jcr->accurate && !jcr->rerunning) {
       return true;
@@ -489,7 +490,7 @@ bool accurate_check_file(JCR *jcr, FF_PKT *ff_pkt)
           */
          if (!stat && ff_pkt->type != FT_LNKSAVED &&
              (S_ISREG(ff_pkt->statp.st_mode) &&
-              ff_pkt->flags & (FO_MD5|FO_SHA1|FO_SHA256|FO_SHA512)))
+              ff_pkt->flags & (FO_MD5|FO_SHA1|FO_SHA256|FO_SHA512|FO_XXH128)))
          {
 
             if (!*elt.chksum && !jcr->rerunning) {
@@ -518,6 +519,10 @@ bool accurate_check_file(JCR *jcr, FF_PKT *ff_pkt)
             } else if (ff_pkt->flags & FO_SHA512) {
                digest = crypto_digest_new(jcr, CRYPTO_DIGEST_SHA512);
                digest_stream = STREAM_SHA512_DIGEST;
+
+            } else if (ff_pkt->flags & FO_XXH128) {
+               digest = crypto_digest_new(jcr, CRYPTO_DIGEST_XXH128);
+               digest_stream = STREAM_XXH128_DIGEST;
             }
 
             /* Did digest initialization fail? */
@@ -530,10 +535,21 @@ bool accurate_check_file(JCR *jcr, FF_PKT *ff_pkt)
             if (digest) {
                char md[CRYPTO_DIGEST_MAX_SIZE];
                uint32_t size;
+               bool keep_data;
 
                size = sizeof(md);
 
-               if (digest_file(jcr, ff_pkt, digest) != 0) {
+               /* If the file is small enough, keep its data to send it
+                * without reading it again when the checksum differs
+                */
+               keep_data = jcr->accurate_data && !ff_pkt->cmd_plugin &&
+                  ff_pkt->statp.st_size > 0 &&
+                  (uint64_t)ff_pkt->statp.st_size <= me->max_accurate_buffer_size;
+#ifdef HAVE_WIN32
+               keep_data = false;        /* backup reads use BackupRead() */
+#endif
+
+               if (digest_file(jcr, ff_pkt, digest, keep_data) != 0) {
                   jcr->JobErrors++;
 
                } else if (crypto_digest_finalize(digest, (uint8_t *)md, &size)) {
@@ -556,6 +572,11 @@ bool accurate_check_file(JCR *jcr, FF_PKT *ff_pkt)
 
                   free(digest_buf);
                }
+               if (stat && jcr->accurate_data_len > 0) {
+                  jcr->accurate_data_ino = ff_pkt->statp.st_ino;
+               } else {
+                  jcr->accurate_data_len = 0;
+               }
                crypto_digest_free(digest);
             }
          }
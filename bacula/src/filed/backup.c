@@ -39,9 +39,19 @@ const bool have_libz = true;
 const bool have_libz = false;
 #endif
 
+/* Size of the buffer used to group the small messages sent to the SD */
+#define SD_COALESCE_SIZE  (64 * 1024)
+
 /* Forward referenced functions */
 int save_file(JCR *jcr, FF_PKT *ff_pkt, bool top_level);
 static int send_data(bctx_t &bctx, int stream);
+static bool send_plugin_buffers(bctx_t &bctx);
+static bool send_plugin_extents(bctx_t &bctx);
+static bool send_changed_blocks(bctx_t &bctx);
+static bool send_accurate_data(bctx_t &bctx);
+#if defined(SEEK_DATA) && defined(SEEK_HOLE)
+static int send_sparse_data(bctx_t &bctx);
+#endif
 static void close_vss_backup_session(JCR *jcr);
 #ifdef HAVE_DARWIN_OS
 static bool send_resource_fork(bctx_t &bctx);
@@ -151,6 +161,11 @@ bool blast_data_to_storage_daemon(JCR *jcr, char *addr)
    /** in accurate mode, we overload the find_one check function */
    if (jcr->accurate) {
       set_find_changed_function((FF_PKT *)jcr->ff, accurate_check_file);
+      /* Keep the data read to compute the checksum of the small files */
+      if (me->max_accurate_buffer_size > 0) {
+         jcr->accurate_data = get_pool_memory(PM_MESSAGE);
+         jcr->accurate_data_len = 0;
+      }
    }
    start_heartbeat_monitor(jcr);
 
@@ -165,6 +180,9 @@ bool blast_data_to_storage_daemon(JCR *jcr, char *addr)
       return false;
    }
 
+   /* Send the attributes and the small files with a few large writes */
+   sd->set_coalescing(SD_COALESCE_SIZE);
+
    /** Subroutine save_file() is called for each file */
    if (!find_files(jcr, (FF_PKT *)jcr->ff, save_file, plugin_save)) {
       ok = false;                     /* error */
@@ -193,6 +211,7 @@ bool blast_data_to_storage_daemon(JCR *jcr, char *addr)
 
    stop_heartbeat_monitor(jcr);
    sd->signal(BNET_EOD);            /* end of sending data */
+   sd->set_coalescing(0);
 
 #ifdef HAVE_ACL
    if (jcr->bacl) {
@@ -249,6 +268,7 @@ int save_file(JCR *jcr, FF_PKT *ff_pkt, bool top_level)
    int stat;
    int rtnstat = 0;
    bool has_file_data = false;
+   uint64_t cbt_flags = 0;
    struct save_pkt sp;          /* used by option plugin */
    BSOCK *sd = jcr->store_bsock;
    bctx_t bctx;                  /* backup context */
@@ -433,6 +453,22 @@ int save_file(JCR *jcr, FF_PKT *ff_pkt, bool top_level)
       plugin_started = true;
    }
 
+   /*
+    * With changed block tracking, we must know if we send the whole
+    *  file or a delta before sending the attributes (delta_seq).
+    */
+   if (has_file_data && !do_plugin_set && (ff_pkt->flags & FO_CHANGED_BLOCKS) &&
+       (ff_pkt->type == FT_RAW || (ff_pkt->type == FT_REG && ff_pkt->statp.st_size > 0)) &&
+       is_portable_backup(&ff_pkt->bfd)) {
+      cbt_flags = ff_pkt->flags;
+      bctx.cbt = New(cbt_file(jcr));
+      if (!bctx.cbt->open(ff_pkt)) {
+         delete bctx.cbt;
+         bctx.cbt = NULL;
+         ff_pkt->flags = cbt_flags;
+      }
+   }
+
    /*
     * Send attributes -- must be done after binit()
     *  Note: this subroutine also defines bctx.stream
@@ -509,6 +545,10 @@ int save_file(JCR *jcr, FF_PKT *ff_pkt, bool top_level)
 
       stat = send_data(bctx, bctx.data_stream);
 
+      if (bctx.cbt) {
+         bctx.cbt->close(stat != 0);
+      }
+
       if (ff_pkt->flags & FO_CHKCHANGES) {
          has_file_changed(jcr, ff_pkt);
       }
@@ -556,6 +596,10 @@ bail_out:
    if (plugin_started) {
       send_plugin_name(jcr, sd, false); /* signal end of plugin data */
    }
+   if (bctx.cbt) {
+      delete bctx.cbt;          /* discard the tracking file if not closed */
+      ff_pkt->flags = cbt_flags;
+   }
    if (ff_pkt->opt_plugin) {
       jcr->plugin_sp = NULL;    /* sp is local to this function */
       jcr->plugin_ctx = NULL;
@@ -696,6 +740,68 @@ static int send_data(bctx_t &bctx, int stream)
    /* Fall through to standard bread() loop */
 #endif
 
+   /*
+    * Send only the blocks that changed since the previous backup
+    */
+   if (bctx.cbt) {
+      if (!send_changed_blocks(bctx)) {
+         goto err;
+      }
+      goto finish_sending;
+   }
+
+   /*
+    * The plugin tells us which parts of the file must be saved
+    */
+   if (bctx.ff_pkt->nb_extents > 0 && bctx.ff_pkt->bfd.cmd_plugin) {
+      if (!send_plugin_extents(bctx)) {
+         goto err;
+      }
+      goto finish_sending;
+   }
+
+   /*
+    * The plugin gives us its own buffers, no need to copy the data
+    */
+   if (bctx.ff_pkt->plugin_read_buf && bctx.ff_pkt->bfd.cmd_plugin) {
+      if (!send_plugin_buffers(bctx)) {
+         goto err;
+      }
+      goto finish_sending;
+   }
+
+   /*
+    * The accurate checksum comparison has already read the file
+    */
+   if (jcr->accurate_data_len > 0) {
+      if (stream == bctx.data_stream && !bctx.ff_pkt->bfd.cmd_plugin &&
+          jcr->accurate_data_ino == bctx.ff_pkt->statp.st_ino &&
+          jcr->accurate_data_len == bctx.ff_pkt->statp.st_size) {
+         if (!send_accurate_data(bctx)) {
+            goto err;
+         }
+         goto finish_sending;
+      }
+      jcr->accurate_data_len = 0;
+   }
+
+#if defined(SEEK_DATA) && defined(SEEK_HOLE)
+   /*
+    * Sparse file, ask the filesystem where the data is and skip the holes
+    */
+   if ((bctx.ff_pkt->flags & FO_SPARSE) && !bctx.ff_pkt->bfd.cmd_plugin &&
+       bctx.ff_pkt->type == FT_REG && bctx.ff_pkt->statp.st_size > 0) {
+      switch (send_sparse_data(bctx)) {
+      case 0:
+         goto err;
+      case 1:
+         goto finish_sending;
+      default:
+         break;                 /* Not supported, use the read loop */
+      }
+   }
+#endif
+
    /*
     * Normal read the file data in a loop and send it to SD
     */
@@ -771,6 +877,242 @@ err:
 }
 
 
+/*
+ * Read the data of a command plugin that supports IO_READ_BUF.
+ *  When the data is sent as is, the plugin buffer is given directly
+ *  to the network layer. When the data must be compressed, we work
+ *  on slices of rsize bytes (the size of the compression buffer),
+ *  and when an offset must be prepended or when the data is encrypted
+ *  or deduplicated, we copy the slices into our read buffer.
+ */
+static bool send_plugin_buffers(bctx_t &bctx)
+{
+   JCR *jcr = bctx.jcr;
+   BSOCK *sd = bctx.sd;
+   char *rbuf = bctx.rbuf;
+   char *wbuf = bctx.wbuf;
+   char *buf;
+   ssize_t len;
+   bool ret = false;
+   bool copy = (bctx.ff_pkt->flags & (FO_SPARSE|FO_OFFSETS|FO_ENCRYPT)) ||
+      bctx.dedup_client_side || jcr->sd_dedup;
+   bool compress = bctx.wbuf != bctx.rbuf;
+
+   while ((len = plugin_bread_buf(&bctx.ff_pkt->bfd, &buf, IO_READ_BUF_MAX)) > 0) {
+      if (!copy && !compress) {
+         bctx.rbuf = bctx.wbuf = buf;
+         sd->msglen = len;
+         if (!process_and_send_data(bctx)) {
+            goto bail_out;
+         }
+         continue;
+      }
+      while (len > 0) {
+         sd->msglen = MIN(len, bctx.rsize);
+         if (copy) {
+            memcpy(rbuf, buf, sd->msglen);
+         } else {
+            bctx.rbuf = buf;
+         }
+         buf += sd->msglen;
+         len -= sd->msglen;
+         if (!process_and_send_data(bctx)) {
+            goto bail_out;
+         }
+      }
+   }
+   sd->msglen = len;            /* error is checked by the caller */
+   ret = true;
+
+bail_out:
+   bctx.rbuf = rbuf;
+   bctx.wbuf = wbuf;
+   return ret;
+}
+
+/*
+ * Read only the ranges given by a command plugin in save_pkt.extents.
+ *  Each block is sent with its offset in the file (FO_OFFSETS).
+ */
+static bool send_plugin_extents(bctx_t &bctx)
+{
+   BSOCK *sd = bctx.sd;
+   FF_PKT *ff_pkt = bctx.ff_pkt;
+   struct bextent *ext;
+   uint64_t addr, end;
+
+   for (int i = 0; i < ff_pkt->nb_extents; i++) {
+      ext = &ff_pkt->extents[i];
+      Dmsg2(300, "extent offset=%lld length=%lld\n", ext->offset, ext->length);
+      if (blseek(&ff_pkt->bfd, (boffset_t)ext->offset, SEEK_SET) < 0) {
+         sd->msglen = -1;       /* error is reported by the caller */
+         return true;
+      }
+      for (addr = ext->offset, end = ext->offset + ext->length; addr < end; ) {
+         sd->msglen = (uint32_t)bread(&ff_pkt->bfd, bctx.rbuf,
+                                      (size_t)MIN((uint64_t)bctx.rsize, end - addr));
+         if (sd->msglen <= 0) {
+            break;
+         }
+         ff_pkt->bfd.offset = addr;
+         addr += sd->msglen;
+         if (!process_and_send_data(bctx)) {
+            return false;
+         }
+      }
+      if (sd->msglen < 0) {
+         return true;
+      }
+   }
+   sd->msglen = 0;
+   return true;
+}
+
+#if defined(SEEK_DATA) && defined(SEEK_HOLE)
+/*
+ * Read only the allocated extents of a sparse file. The reads are
+ *  aligned on rsize, so we send exactly the same records as the
+ *  standard read loop would send, minus the blocks that are in a hole.
+ *  The last block is always sent, it gives the size of the file.
+ *
+ * Returns 1 if OK (read errors are checked by the caller with msglen),
+ *  0 on a fatal error, and -1 if the filesystem cannot report the
+ *  holes, nothing is sent in this case.
+ */
+static int send_sparse_data(bctx_t &bctx)
+{
+   BSOCK *sd = bctx.sd;
+   BFILE *bfd = &bctx.ff_pkt->bfd;
+   boffset_t size = bctx.ff_pkt->statp.st_size;
+   boffset_t data, hole, pos = 0;
+
+   data = blseek(bfd, 0, SEEK_DATA);
+   if (data < 0 && bfd->berrno != ENXIO) {
+      Dmsg2(300, "SEEK_DATA not supported on %s. ERR=%d\n", bctx.ff_pkt->fname,
+            bfd->berrno);
+      blseek(bfd, 0, SEEK_SET);
+      return -1;
+   }
+   while (data >= 0 && data < size) {
+      hole = blseek(bfd, data, SEEK_HOLE);
+      if (hole < 0 || hole > size) {
+         hole = size;
+      }
+      data = MAX(pos, (data / bctx.rsize) * bctx.rsize);
+      Dmsg3(300, "sparse %s data=%lld hole=%lld\n", bctx.ff_pkt->fname, data, hole);
+      if (blseek(bfd, data, SEEK_SET) < 0) {
+         sd->msglen = -1;
+         return 1;
+      }
+      for (pos = data; pos < hole; ) {
+         sd->msglen = (uint32_t)bread(bfd, bctx.rbuf, bctx.rsize);
+         if (sd->msglen <= 0) {
+            return 1;           /* error or file truncated */
+         }
+         bctx.fileAddr = pos;
+         pos += sd->msglen;     /* msglen is the compressed length once sent */
+         if (!process_and_send_data(bctx)) {
+            return 0;
+         }
+      }
+      data = blseek(bfd, pos, SEEK_DATA);
+   }
+
+   if (pos < size) {
+      pos = MAX(pos, ((size - 1) / bctx.rsize) * bctx.rsize);
+      if (blseek(bfd, pos, SEEK_SET) < 0) {
+         sd->msglen = -1;
+         return 1;
+      }
+      while ((sd->msglen = (uint32_t)bread(bfd, bctx.rbuf, bctx.rsize)) > 0) {
+         bctx.fileAddr = pos;
+         pos += sd->msglen;
+         if (!process_and_send_data(bctx)) {
+            return 0;
+         }
+      }
+      return 1;
+   }
+   sd->msglen = 0;
+   return 1;
+}
+#endif
+
+/*
+ * Read the file by blocks of CBT_BLOCK_SIZE, and send only the blocks
+ *  that are different from the previous backup with their offset.
+ *  The blocks that did not change must still be part of the digest
+ *  of the file.
+ */
+static bool send_changed_blocks(bctx_t &bctx)
+{
+   JCR *jcr = bctx.jcr;
+   BSOCK *sd = bctx.sd;
+   cbt_file *cbt = bctx.cbt;
+   uint64_t addr = 0;
+   ssize_t len, count;
+   char *buf;
+
+   while ((len = cbt->read_block(&bctx.ff_pkt->bfd)) > 0) {
+      if (!cbt->block_changed()) {
+         if (bctx.digest) {
+            crypto_digest_update(bctx.digest, (uint8_t *)cbt->buf, len);
+         }
+         if (bctx.signing_digest) {
+            crypto_digest_update(bctx.signing_digest, (uint8_t *)cbt->buf, len);
+         }
+         jcr->ReadBytes += len;
+         addr += len;
+         continue;
+      }
+      for (buf = cbt->buf; len > 0; buf += count, len -= count) {
+         count = MIN(len, bctx.rsize);
+         memcpy(bctx.rbuf, buf, count);
+         sd->msglen = count;
+         bctx.ff_pkt->bfd.offset = addr;
+         addr += count;
+         if (!process_and_send_data(bctx)) {
+            return false;
+         }
+      }
+   }
+   if (len < 0) {
+      cbt->close(false);        /* the tracking file is not complete */
+   }
+   sd->msglen = len;            /* error is checked by the caller */
+   return true;
+}
+
+/*
+ * Send the data kept by accurate_check_file() when it computed
+ *  the checksum of the file, instead of reading the file again.
+ */
+static bool send_accurate_data(bctx_t &bctx)
+{
+   JCR *jcr = bctx.jcr;
+   BSOCK *sd = bctx.sd;
+   int32_t len = jcr->accurate_data_len;
+   char *buf = jcr->accurate_data;
+   uint64_t addr = 0;
+   int32_t count;
+
+   Dmsg2(130, "Send %d bytes read by accurate for %s\n", len,
+         bctx.ff_pkt->fname);
+   jcr->accurate_data_len = 0;  /* used only once */
+   for ( ; len > 0; buf += count, len -= count) {
+      count = MIN(len, bctx.rsize);
+      memcpy(bctx.rbuf, buf, count);
+      sd->msglen = count;
+      bctx.ff_pkt->bfd.offset = addr;
+      addr += count;
+      if (!process_and_send_data(bctx)) {
+         return false;
+      }
+   }
+   sd->msglen = 0;
+   return true;
+}
+
 /*
  * Apply processing (sparse, compression, encryption, and
  *   send to the SD.
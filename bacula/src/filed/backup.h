@@ -39,6 +39,9 @@ struct bctx_t {
    /* Dedup variables */
    bool dedup_client_side;
 
+   /* Changed block tracking */
+   cbt_file *cbt;
+
    /* Crypto variables */
    DIGEST *digest;
    DIGEST *signing_digest;
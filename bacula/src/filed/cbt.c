@@ -0,0 +1,302 @@
+/*
+   Bacula(R) - The Network Backup Solution
+
+   Copyright (C) 2000-2020 Kern Sibbald
+
+   The original author of Bacula is Kern Sibbald, with contributions
+   from many others, a complete list can be found in the file AUTHORS.
+
+   You may use this file and others of this release according to the
+   license defined in the LICENSE file, which includes the Affero General
+   Public License, v3.0 ("AGPLv3") and some additional permissions and
+   terms pursuant to its AGPLv3 Section 7.
+
+   This notice must be preserved when any source code is
+   conveyed and/or propagated.
+
+   Bacula(R) is a registered trademark of Kern Sibbald.
+*/
+/*
+ * Changed block tracking for large files and raw devices
+ *
+ * The tracking file of a given Job/file is kept in
+ *  <WorkingDirectory>/cbt/<md5(basejobname/filename)>.cbt
+ *
+ *   uint32 magic, uint32 version, uint32 block size,
+ *   int32 delta_seq, uint64 file size, uint64 number of blocks,
+ *   followed by one MD5 digest per block.
+ *
+ * A new tracking file is written during the backup, and it replaces
+ *  the previous one only when the Job terminates successfully, so the
+ *  delta_seq of the tracking file always matches the one of the last
+ *  part known by the catalog (sent by the Director in the accurate list).
+ */
+
+#include "bacula.h"
+#include "filed.h"
+
+static const int dbglvl = 150;
+
+/*
+ * The unique Job name is <name>.<YYYY-MM-DD_HH.MM.SS>_<seq>,
+ *  the tracking file must survive from one job to the next one.
+ */
+static void get_base_job_name(JCR *jcr, POOLMEM **name)
+{
+   char *p;
+
+   pm_strcpy(name, jcr->Job);
+   p = strrchr(*name, '_');
+   if (p && (p - *name) > 20 && (p - 20)[0] == '.') {
+      (p - 20)[0] = 0;
+   }
+}
+
+cbt_file::cbt_file(JCR *ajcr)
+{
+   jcr = ajcr;
+   old_fp = new_fp = NULL;
+   path = get_pool_memory(PM_FNAME);
+   new_path = get_pool_memory(PM_FNAME);
+   nb_old_blocks = nb_blocks = nb_bytes = 0;
+   delta_seq = 0;
+   changed = false;
+   full = true;
+   buf = NULL;
+}
+
+cbt_file::~cbt_file()
+{
+   if (old_fp) {
+      fclose(old_fp);
+   }
+   if (new_fp) {
+      fclose(new_fp);
+      unlink(new_path);
+   }
+   if (buf) {
+      free(buf);
+   }
+   free_pool_memory(path);
+   free_pool_memory(new_path);
+}
+
+bool cbt_file::read_header(int32_t *seq)
+{
+   uint8_t hdr[CBT_HEADER_SIZE];
+   uint32_t magic, version, block_size;
+   uint64_t size;
+   unser_declare;
+
+   if (fread(hdr, 1, sizeof(hdr), old_fp) != sizeof(hdr)) {
+      return false;
+   }
+   unser_begin(hdr, sizeof(hdr));
+   unser_uint32(magic);
+   unser_uint32(version);
+   unser_uint32(block_size);
+   unser_int32(*seq);
+   unser_uint64(size);
+   unser_uint64(nb_old_blocks);
+   unser_end(hdr, sizeof(hdr));
+
+   Dmsg5(dbglvl, "cbt %s version=%d bsize=%d seq=%d blocks=%lld\n", path,
+         version, block_size, *seq, nb_old_blocks);
+   return magic == CBT_MAGIC && version == CBT_VERSION &&
+      block_size == CBT_BLOCK_SIZE &&
+      nb_old_blocks == (size + CBT_BLOCK_SIZE - 1) / CBT_BLOCK_SIZE;
+}
+
+bool cbt_file::write_header(uint64_t size)
+{
+   uint8_t hdr[CBT_HEADER_SIZE];
+   ser_declare;
+
+   ser_begin(hdr, sizeof(hdr));
+   ser_uint32(CBT_MAGIC);
+   ser_uint32(CBT_VERSION);
+   ser_uint32(CBT_BLOCK_SIZE);
+   ser_int32(delta_seq);
+   ser_uint64(size);
+   ser_uint64(nb_blocks);
+   ser_end(hdr, sizeof(hdr));
+
+   return fseeko(new_fp, 0, SEEK_SET) == 0 &&
+      fwrite(hdr, 1, sizeof(hdr), new_fp) == sizeof(hdr);
+}
+
+bool cbt_file::open(FF_PKT *ff_pkt)
+{
+   POOL_MEM key(PM_FNAME);
+   MD5Context md5;
+   unsigned char digest[CBT_DIGEST_SIZE];
+   char hex[CBT_DIGEST_SIZE * 2 + 1];
+   int32_t seq = 0;
+
+   get_base_job_name(jcr, key.handle());
+   pm_strcat(key, "/");
+   pm_strcat(key, ff_pkt->fname);
+   MD5Init(&md5);
+   MD5Update(&md5, (unsigned char *)key.c_str(), strlen(key.c_str()));
+   MD5Final(digest, &md5);
+   for (int i = 0; i < CBT_DIGEST_SIZE; i++) {
+      bsnprintf(hex + 2*i, 3, "%02x", digest[i]);
+   }
+
+   Mmsg(path, "%s/cbt", working_directory);
+   if (mkdir(path, 0700) != 0 && errno != EEXIST) {
+      berrno be;
+      Jmsg(jcr, M_WARNING, 0, _("Cannot create changed block tracking directory %s. ERR=%s\n"),
+           path, be.bstrerror());
+      return false;
+   }
+   Mmsg(path, "%s/cbt/%s.cbt", working_directory, hex);
+   Mmsg(new_path, "%s.%d", path, (int)jcr->JobId);
+
+   /*
+    * We can send only the changed blocks if the restore of the previous
+    *  parts gives the content described by the tracking file, so the
+    *  catalog must know the same delta sequence.
+    */
+   full = true;
+   if (jcr->getJobLevel() != L_FULL && jcr->accurate && ff_pkt->accurate_found) {
+      if ((old_fp = bfopen(path, "rb")) != NULL) {
+         if (read_header(&seq) && seq == ff_pkt->delta_seq && seq < CBT_MAX_DELTA_SEQ) {
+            full = false;
+         } else {
+            Dmsg3(dbglvl, "cbt %s cannot be used seq=%d delta_seq=%d\n", path, seq,
+                  ff_pkt->delta_seq);
+            fclose(old_fp);
+            old_fp = NULL;
+         }
+      }
+   }
+
+   if ((new_fp = bfopen(new_path, "w+b")) == NULL) {
+      berrno be;
+      Jmsg(jcr, M_WARNING, 0, _("Cannot create changed block tracking file %s. ERR=%s\n"),
+           new_path, be.bstrerror());
+      return false;
+   }
+   delta_seq = full ? 0 : seq + 1;
+   if (!write_header(0)) {
+      berrno be;
+      Jmsg(jcr, M_WARNING, 0, _("Cannot write changed block tracking file %s. ERR=%s\n"),
+           new_path, be.bstrerror());
+      return false;
+   }
+   buf = (char *)malloc(CBT_BLOCK_SIZE);
+
+   /*
+    * Each block carries its offset. A block of zeros must overwrite
+    *  the previous content, so sparse handling is not compatible.
+    */
+   ff_pkt->flags |= FO_OFFSETS;
+   ff_pkt->flags &= ~FO_SPARSE;
+   ff_pkt->delta_seq = delta_seq;
+   Dmsg3(dbglvl, "cbt %s full=%d delta_seq=%d\n", ff_pkt->fname, full, delta_seq);
+   return true;
+}
+
+ssize_t cbt_file::read_block(BFILE *bfd)
+{
+   unsigned char old_digest[CBT_DIGEST_SIZE];
+   unsigned char digest[CBT_DIGEST_SIZE];
+   MD5Context md5;
+   ssize_t len = 0, stat;
+
+   while (len < CBT_BLOCK_SIZE) {
+      stat = bread(bfd, buf + len, CBT_BLOCK_SIZE - len);
+      if (stat < 0) {
+         return stat;
+      }
+      if (stat == 0) {
+         break;
+      }
+      len += stat;
+   }
+   if (len == 0) {
+      return 0;
+   }
+
+   MD5Init(&md5);
+   MD5Update(&md5, (unsigned char *)buf, len);
+   MD5Final(digest, &md5);
+
+   changed = true;
+   if (!full && nb_blocks < nb_old_blocks &&
+       fread(old_digest, 1, sizeof(old_digest), old_fp) == sizeof(old_digest)) {
+      changed = memcmp(old_digest, digest, sizeof(digest)) != 0;
+   }
+   if (fwrite(digest, 1, sizeof(digest), new_fp) != sizeof(digest)) {
+      berrno be;
+      Jmsg(jcr, M_ERROR, 0, _("Cannot write changed block tracking file %s. ERR=%s\n"),
+           new_path, be.bstrerror());
+      fclose(new_fp);
+      unlink(new_path);
+      new_fp = NULL;
+      full = true;             /* we do not compare anymore, send everything */
+   }
+   nb_blocks++;
+   nb_bytes += len;
+   return len;
+}
+
+bool cbt_file::close(bool ok)
+{
+   bool ret = false;
+
+   if (!new_fp) {
+      return false;
+   }
+   if (ok) {
+      ret = write_header(nb_bytes) && fflush(new_fp) == 0;
+      if (!ret) {
+         berrno be;
+         Jmsg(jcr, M_ERROR, 0, _("Cannot write changed block tracking file %s. ERR=%s\n"),
+              new_path, be.bstrerror());
+      }
+   }
+   fclose(new_fp);
+   new_fp = NULL;
+   if (!ret) {
+      unlink(new_path);
+      return false;
+   }
+   if (!jcr->cbt_pending) {
+      jcr->cbt_pending = New(alist(100, owned_by_alist));
+   }
+   jcr->cbt_pending->append(bstrdup(new_path));
+   return true;
+}
+
+/*
+ * At the end of the backup, keep the new tracking files if the Job
+ *  is good, else the previous ones still describe the catalog content.
+ */
+void cbt_end_job(JCR *jcr, bool ok)
+{
+   POOL_MEM dest(PM_FNAME);
+   char *fname, *p;
+
+   if (!jcr->cbt_pending) {
+      return;
+   }
+   foreach_alist(fname, jcr->cbt_pending) {
+      if (ok) {
+         pm_strcpy(dest, fname);
+         if ((p = strrchr(dest.c_str(), '.')) != NULL) {
+            *p = 0;             /* strip .JobId */
+         }
+         if (rename(fname, dest.c_str()) == 0) {
+            continue;
+         }
+         berrno be;
+         Jmsg(jcr, M_WARNING, 0, _("Cannot rename changed block tracking file %s. ERR=%s\n"),
+              fname, be.bstrerror());
+      }
+      unlink(fname);
+   }
+   delete jcr->cbt_pending;
+   jcr->cbt_pending = NULL;
+}
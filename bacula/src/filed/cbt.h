@@ -0,0 +1,91 @@
+/*
+   Bacula(R) - The Network Backup Solution
+
+   Copyright (C) 2000-2020 Kern Sibbald
+
+   The original author of Bacula is Kern Sibbald, with contributions
+   from many others, a complete list can be found in the file AUTHORS.
+
+   You may use this file and others of this release according to the
+   license defined in the LICENSE file, which includes the Affero General
+   Public License, v3.0 ("AGPLv3") and some additional permissions and
+   terms pursuant to its AGPLv3 Section 7.
+
+   This notice must be preserved when any source code is
+   conveyed and/or propagated.
+
+   Bacula(R) is a registered trademark of Kern Sibbald.
+*/
+/*
+ * Changed block tracking for large files and raw devices
+ *
+ * For each file saved with the ChangedBlocks option, we keep in the
+ * working directory the digest of every CBT_BLOCK_SIZE block that was
+ * sent by the previous job. The next Incremental or Differential
+ * compares the blocks with these digests and sends only the blocks
+ * that differ, with their offset, as a new part of the delta chain
+ * (delta_seq + 1). The restore applies the parts in order on the
+ * same file.
+ */
+
+#ifndef __CBT_H
+#define __CBT_H
+
+#define CBT_MAGIC          0x42434254      /* "BCBT" */
+#define CBT_VERSION        1
+#define CBT_BLOCK_SIZE     (1024 * 1024)   /* tracking granularity */
+#define CBT_DIGEST_SIZE    MD5HashSize
+#define CBT_HEADER_SIZE    (4 + 4 + 4 + 4 + 8 + 8)
+
+/* After this many parts, the next job sends the whole file again
+ *  to limit the work done at restore time.
+ */
+#define CBT_MAX_DELTA_SEQ  100
+
+class cbt_file: public SMARTALLOC
+{
+private:
+   JCR *jcr;
+   FILE *old_fp;                 /* digests of the previous job, NULL if full */
+   FILE *new_fp;                 /* digests of this job */
+   POOLMEM *path;                /* current tracking file */
+   POOLMEM *new_path;            /* tracking file written by this job */
+   uint64_t nb_old_blocks;       /* number of digests in old_fp */
+   uint64_t nb_blocks;           /* number of blocks read so far */
+   uint64_t nb_bytes;            /* number of bytes read so far */
+   int32_t delta_seq;            /* delta sequence of this backup */
+   bool changed;                 /* set if the last block differs */
+
+   bool read_header(int32_t *seq);
+   bool write_header(uint64_t size);
+
+public:
+   char *buf;                    /* CBT_BLOCK_SIZE read buffer */
+   bool full;                    /* set if all blocks are sent */
+
+   cbt_file(JCR *jcr);
+   ~cbt_file();
+
+   /* Decide if we send a delta or the whole file, and update the
+    *  FF_PKT flags and delta_seq accordingly. Must be called before
+    *  the attributes are sent.
+    */
+   bool open(FF_PKT *ff_pkt);
+
+   /* Read the next block into buf, return its length, 0 at the end
+    *  of the file, -1 on error.
+    */
+   ssize_t read_block(BFILE *bfd);
+
+   /* True if the last block read must be sent */
+   bool block_changed() { return full || changed; };
+
+   /* Write the header of the new tracking file, it will be
+    *  committed at the end of the job by cbt_end_job()
+    */
+   bool close(bool ok);
+};
+
+void cbt_end_job(JCR *jcr, bool ok);
+
+#endif /* __CBT_H */
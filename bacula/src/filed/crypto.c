@@ -96,6 +96,10 @@ bool crypto_setup_digests(bctx_t &bctx)
    } else if (ff_pkt->flags & FO_SHA512) {
       bctx.digest = crypto_digest_new(jcr, CRYPTO_DIGEST_SHA512);
       bctx.digest_stream = STREAM_SHA512_DIGEST;
+
+   } else if (ff_pkt->flags & FO_XXH128) {
+      bctx.digest = crypto_digest_new(jcr, CRYPTO_DIGEST_XXH128);
+      bctx.digest_stream = STREAM_XXH128_DIGEST;
    }
 
    /** Did digest initialization fail? */
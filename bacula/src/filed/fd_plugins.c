@@ -467,6 +467,9 @@ static void update_ff_pkt(FF_PKT *ff_pkt, struct save_pkt *sp)
 {
    Dsm_check(999);
    ff_pkt->no_read = sp->no_read;
+   ff_pkt->plugin_read_buf = sp->read_buf;
+   ff_pkt->extents = sp->extents;
+   ff_pkt->nb_extents = sp->nb_extents;
    ff_pkt->delta_seq = sp->delta_seq;
 
    if (sp->flags & FO_DELTA) {
@@ -477,7 +480,7 @@ static void update_ff_pkt(FF_PKT *ff_pkt, struct save_pkt *sp)
       ff_pkt->delta_seq = 0;
    }
 
-   if (sp->flags & FO_OFFSETS) {
+   if ((sp->flags & FO_OFFSETS) || sp->nb_extents > 0) {
       ff_pkt->flags |= FO_OFFSETS;
    } else {
       ff_pkt->flags &= ~FO_OFFSETS;
@@ -1814,6 +1817,52 @@ static ssize_t my_plugin_bread(BFILE *bfd, void *buf, size_t count)
    return (ssize_t)io.status;
 }
 
+/*
+ * Ask the plugin for a pointer to its own data buffer (IO_READ_BUF),
+ *  this avoids to copy the data into our buffer. The plugin must have
+ *  set save_pkt.read_buf in startBackupFile().
+ */
+ssize_t plugin_bread_buf(BFILE *bfd, char **buf, size_t count)
+{
+   JCR *jcr = bfd->jcr;
+   Plugin *plugin = (Plugin *)jcr->plugin;
+   struct io_pkt io;
+
+   Dsm_check(999);
+   Dmsg0(dbglvl2, "plugin_bread_buf\n");
+   *buf = NULL;
+   if (!plugin || !jcr->plugin_ctx) {
+      return 0;
+   }
+   io.pkt_size = sizeof(io);
+   io.pkt_end = sizeof(io);
+   io.func = IO_READ_BUF;
+   io.count = MIN(count, IO_READ_BUF_MAX);
+   io.buf = NULL;
+   io.win32 = false;
+   io.offset = 0;
+   io.lerror = 0;
+   io.status = -1;
+   plug_func(plugin)->pluginIO(jcr->plugin_ctx, &io);
+   bfd->offset = io.offset;
+   bfd->berrno = io.io_errno;
+   if (io.win32) {
+      errno = b_errno_win32;
+   } else {
+      errno = io.io_errno;
+      bfd->lerror = io.lerror;
+   }
+   if (io.status > 0 && (!io.buf || io.status > io.count)) {
+      Jmsg3(jcr, M_FATAL, 0, _("Plugin \"%s\" returned an invalid buffer buf=%p len=%d\n"),
+            plugin->file, io.buf, io.status);
+      errno = bfd->berrno = EINVAL;
+      return -1;
+   }
+   *buf = io.buf;
+   Dsm_check(999);
+   return (ssize_t)io.status;
+}
+
 static ssize_t my_plugin_bwrite(BFILE *bfd, void *buf, size_t count)
 {
    JCR *jcr = bfd->jcr;
@@ -91,6 +91,19 @@ struct stream_pkt {
    int32_t pkt_end;                   /* end packet sentinel */
 };
 
+/*
+ * A range of data to read. When the plugin knows which parts of a file
+ *  changed since the previous backup, it can set save_pkt.extents in
+ *  startBackupFile() (with FO_DELTA to create a new part of the delta
+ *  chain). The FD will then use IO_SEEK/IO_READ to read only these
+ *  ranges, and each block is sent with its offset (FO_OFFSETS).
+ *  The array must stay valid until endBackupFile().
+ */
+struct bextent {
+   uint64_t offset;                   /* start of the range in the file */
+   uint64_t length;                   /* number of bytes to read */
+};
+
 /*
  * This packet is used for file save info transfer.
 */
@@ -114,6 +127,9 @@ struct save_pkt {
    int32_t object_len;                /* restore object length */
    int32_t index;                     /* restore object index */
    int32_t LinkFI;                    /* LinkFI if LINKSAVED */
+   bool read_buf;                     /* Plugin handles IO_READ_BUF for this file */
+   struct bextent *extents;           /* Changed extents to read, NULL to read all */
+   int32_t nb_extents;                /* number of items in extents */
    int32_t pkt_end;                   /* end packet sentinel */
 };
 
@@ -162,9 +178,22 @@ enum {
    IO_READ = 2,
    IO_WRITE = 3,
    IO_CLOSE = 4,
-   IO_SEEK = 5
+   IO_SEEK = 5,
+   IO_READ_BUF = 6
 };
 
+/*
+ * With IO_READ_BUF (only used during backup when save_pkt.read_buf is set),
+ *  the plugin does not copy the data into the Bacula buffer, it returns
+ *  in io->buf a pointer to its own buffer and in io->status the number
+ *  of bytes available (at most io->count, 0 at the end of the file).
+ *  The buffer must stay valid until the next call to pluginIO(), and the
+ *  IO_BUF_HEADROOM bytes just before io->buf must be writable, they are
+ *  used to build the network header.
+ */
+#define IO_BUF_HEADROOM   16
+#define IO_READ_BUF_MAX   (512 * 1024)
+
 struct io_pkt {
    int32_t pkt_size;                  /* Size of this packet */
    int32_t func;                      /* Function code */
@@ -293,6 +322,7 @@ bool plugin_set_attributes(JCR *jcr, ATTR *attr, BFILE *ofd);
 int plugin_save(JCR *jcr, FF_PKT *ff_pkt, bool top_level);
 int plugin_estimate(JCR *jcr, FF_PKT *ff_pkt, bool top_level);
 bool plugin_check_file(JCR *jcr, char *fname);
+ssize_t plugin_bread_buf(BFILE *bfd, char **buf, size_t count);
 bRC plugin_option_handle_file(JCR *jcr, FF_PKT *ff_pkt, struct save_pkt *sp);
 int plugin_get_idx(JCR *jcr, char *plugin);
 bool plugin_send_restorefilelist(JCR *jcr, int plugin_index,
@@ -362,7 +392,7 @@ typedef enum {
 
 #define FD_PLUGIN_MAGIC  "*FDPluginData*"
 
-#define FD_PLUGIN_INTERFACE_VERSION  ( 21 )
+#define FD_PLUGIN_INTERFACE_VERSION  ( 22 )
 
 typedef struct s_pluginInfo {
    uint32_t size;
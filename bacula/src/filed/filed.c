@@ -395,6 +395,13 @@ static bool check_resources()
          }
       }
 
+      /* The kept data is a pool memory buffer, its size is an int32_t */
+      if (me->max_accurate_buffer_size > MAX_ACCURATE_BUFFER_SIZE) {
+         Emsg2(M_FATAL, 0, _("MaximumAccurateBufferSize cannot be more than %d bytes in %s\n"),
+               MAX_ACCURATE_BUFFER_SIZE, configfile);
+         OK = false;
+      }
+
       /* Construct disabled command array */
       for (i=0; cmds[i].cmd; i++) { }  /* Count commands */
       if (me->disable_cmds) {
@@ -462,6 +469,15 @@ static bool check_resources()
       }
       me->psk_ctx = new_psk_context(NULL); /* the shared key is generated by the DIR */
 
+      /* Only the data connections with the SD use these contexts */
+      if (me->tls_kernel_offload) {
+         if (!set_tls_kernel_offload(me->tls_ctx, true) ||
+             !set_tls_kernel_offload(me->psk_ctx, true)) {
+            Jmsg(NULL, M_WARNING, 0, _("TLS Kernel Offload is not supported by this TLS library for File daemon \"%s\" in %s.\n"),
+                 me->hdr.name, configfile);
+         }
+      }
+
       /* In this case, we have TLS Require=Yes and TLS not setup and no PSK */
       if (OK && need_tls == false && me->tls_require) {
          if (me->psk_ctx == NULL) {
@@ -93,6 +93,8 @@ static RES_ITEM cli_items[] = {
    {"SdConnectTimeout", store_time,ITEM(res_client.SDConnectTimeout), 0, ITEM_DEFAULT, 60 * 30},
    {"HeartbeatInterval", store_time, ITEM(res_client.heartbeat_interval), 0, ITEM_DEFAULT, 5 * 60},
    {"MaximumNetworkBufferSize", store_pint32, ITEM(res_client.max_network_buffer_size), 0, 0, 0},
+   {"MaximumRestoreWriters", store_pint32, ITEM(res_client.MaxRestoreWriters), 0, ITEM_DEFAULT, 0},
+   {"MaximumRestoreDecompressors", store_pint32, ITEM(res_client.MaxRestoreDecompressors), 0, ITEM_DEFAULT, 0},
 #if BEEF
    {"FipsRequire", store_bool, ITEM(res_client.require_fips), 0, 0, 0},
 #endif
@@ -109,12 +111,14 @@ static RES_ITEM cli_items[] = {
    {"TlsEnable",             store_bool,    ITEM(res_client.tls_enable),  0, 0, 0},
    {"TlsPskEnable",          store_bool,    ITEM(res_client.tls_psk_enable),  0, ITEM_DEFAULT, tls_psk_default},
    {"TlsRequire",            store_bool,    ITEM(res_client.tls_require), 0, 0, 0},
+   {"TlsKernelOffload",      store_bool,    ITEM(res_client.tls_kernel_offload), 0, ITEM_DEFAULT, 0},
    {"TlsCaCertificateFile",  store_dir,     ITEM(res_client.tls_ca_certfile), 0, 0, 0},
    {"TlsCaCertificateDir",   store_dir,     ITEM(res_client.tls_ca_certdir), 0, 0, 0},
    {"TlsCertificate",        store_dir,     ITEM(res_client.tls_certfile), 0, 0, 0},
    {"TlsKey",                store_dir,     ITEM(res_client.tls_keyfile), 0, 0, 0},
    {"VerId",                 store_str,     ITEM(res_client.verid), 0, 0, 0},
    {"MaximumBandwidthPerJob",store_speed,   ITEM(res_client.max_bandwidth_per_job), 0, 0, 0},
+   {"MaximumAccurateBufferSize", store_size64, ITEM(res_client.max_accurate_buffer_size), 0, ITEM_DEFAULT, 0},
    {"CommCompression",       store_bool,    ITEM(res_client.comm_compression), 0, ITEM_DEFAULT, true},
    {"DisableCommand",        store_alist_str, ITEM(res_client.disable_cmds), 0, 0, 0},
 #if BEEF
@@ -44,6 +44,9 @@
 #define R_PASSWORD                    1022
 #define R_TYPE                        1023
 
+/* Largest MaximumAccurateBufferSize value (1GB) */
+#define MAX_ACCURATE_BUFFER_SIZE      (1024 * 1024 * 1024)
+
 /* Cipher/Digest keyword structure */
 struct s_ct {
    const char *type_name;
@@ -135,6 +138,8 @@ struct CLIENT {
    utime_t SDConnectTimeout;          /* timeout in seconds */
    utime_t heartbeat_interval;        /* Interval to send heartbeats */
    uint32_t max_network_buffer_size;  /* max network buf size */
+   uint32_t MaxRestoreWriters;        /* threads writing the restored files */
+   uint32_t MaxRestoreDecompressors;  /* threads decompressing the restored data */
    bool comm_compression;             /* Enable comm line compression */
    bool pki_sign;                     /* Enable Data Integrity Verification via Digital Signatures */
    bool pki_encrypt;                  /* Enable Data Encryption */
@@ -148,6 +153,7 @@ struct CLIENT {
    bool tls_enable;                   /* Enable TLS */
    bool tls_psk_enable;               /* Enable TLS-PSK */
    bool tls_require;                  /* Require TLS */
+   bool tls_kernel_offload;           /* Use kernel TLS with the SD if possible */
    char *tls_ca_certfile;             /* TLS CA Certificate File */
    char *tls_ca_certdir;              /* TLS CA Certificate Directory */
    char *tls_certfile;                /* TLS Client Certificate File */
@@ -160,6 +166,7 @@ struct CLIENT {
    TLS_CONTEXT *psk_ctx;              /* Shared TLS-PSK Context */
    char *verid;                       /* Custom Id to print in version command */
    uint64_t max_bandwidth_per_job;    /* Bandwidth limitation (global) */
+   uint64_t max_accurate_buffer_size; /* Largest file kept in memory by the accurate checksum */
    bool require_fips;                  /* Check for FIPS module */
    bool allow_dedup_cache;            /* allow the use of dedup cache for rehydration */
    alist *disable_cmds;               /* Commands to disable */
@@ -1922,6 +1922,10 @@ static int set_options(findFOPTS *fo, const char *opts)
             p++;
             break;
 #endif
+         case '4':
+            fo->flags |= FO_XXH128;
+            p++;
+            break;
          default:
             /*
              * If 2 or 3 is seen here, SHA2 is not configured, so
@@ -2029,6 +2033,9 @@ static int set_options(findFOPTS *fo, const char *opts)
       case 'X':
          fo->flags |= FO_XATTR;
          break;
+      case 'T':                 /* changed block tracking */
+         fo->flags |= FO_CHANGED_BLOCKS;
+         break;
       default:
          Jmsg1(NULL, M_ERROR, 0, _("Unknown include/exclude option: %c\n"), *p);
          break;
@@ -2999,6 +3006,9 @@ cleanup:
    delete jcr->dedup;
    jcr->dedup = NULL;
 
+   /* Keep the new changed block tracking files only if the Job is good */
+   cbt_end_job(jcr, jcr->JobStatus == JS_Terminated || jcr->JobStatus == JS_Warnings);
+
    /* Keep track of important events */
    events_send_msg(jcr, "FJ0002", EVENTS_TYPE_JOB, jcr->director->hdr.name, (intptr_t)jcr,
                    "Job End jobid=%d job=%s", jcr->JobId, jcr->Job);
@@ -3419,6 +3429,10 @@ void filed_free_jcr(JCR *jcr)
    if (jcr->last_fname) {
       free_pool_memory(jcr->last_fname);
    }
+   if (jcr->accurate_data) {
+      free_pool_memory(jcr->accurate_data);
+      jcr->accurate_data = NULL;
+   }
 #ifdef WIN32_VSS
    VSSCleanup(jcr->pVSSClient);
 #endif
@@ -72,7 +72,7 @@ typedef enum {
 BSOCK *connect_director(JCR *jcr, const char *name, DIRINFO *dir, connect_dir_mode_t mode /* console or fdcallsdir */);
 
 /* From verify.c */
-int digest_file(JCR *jcr, FF_PKT *ff_pkt, DIGEST *digest);
+int digest_file(JCR *jcr, FF_PKT *ff_pkt, DIGEST *digest, bool keep_data=false);
 void do_verify(JCR *jcr);
 
 /* From heartbeat.c */
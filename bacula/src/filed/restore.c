@@ -84,6 +84,14 @@ static bool close_previous_stream(r_ctx &rctx);
 static int32_t extract_data(r_ctx &rctx, POOLMEM *buf, int32_t buflen);
 static bool flush_cipher(r_ctx &rctx, BFILE *bfd,  uint64_t *addr, int flags, int32_t stream,
                   RESTORE_CIPHER_CTX *cipher_ctx);
+static bool seek_sparse_data(JCR *jcr, const char *fname, BFILE *bfd, uint64_t *addr,
+                             char **data, uint32_t *length);
+static bool decompress_buffer(JCR *jcr, const char *fname, int32_t stream,
+                              char **data, uint32_t *length,
+                              POOLMEM **buf, int32_t *buf_size);
+static void start_restore_decompressors(r_ctx &rctx, int nb);
+static void stop_restore_decompressors(r_ctx &rctx);
+static void discard_restore_blocks(r_ctx &rctx);
 
 /*
  * Close a bfd check that we are at the expected file offset.
@@ -351,6 +359,386 @@ get_out:
 }
 
 
+/*
+ * Restore writer threads
+ *
+ * When the Client has Maximum Restore Writers set, the regular files
+ *  are written by a pool of threads. The job thread reads the records
+ *  from the Storage daemon and creates each file as before (the path
+ *  cache of create_file() is not shared). The data records of a file
+ *  are then kept until its next attributes, and the whole file is
+ *  queued to a writer, which writes the data, closes the file and
+ *  sets its attributes. The records of a file are written in order
+ *  by a single thread.
+ *
+ * The directories are created by the job thread, and their attributes
+ *  are still set when their FT_DIREND record is read, after all their
+ *  files are created. Writing the data of a file or setting its
+ *  attributes does not change the directory.
+ *
+ * Only the simple cases are written by a writer: regular files without
+ *  plugin, delta, encryption or signature, with plain, sparse or
+ *  compressed data. When an other stream is found for a file (ACL,
+ *  xattr, ...), the file is given back to the job thread, its records
+ *  are replayed through the regular restore code.
+ */
+#define RESTORE_WRITER_MAX_SIZE   (1024 * 1024)  /* data kept per file */
+#define RESTORE_WRITER_QUEUE_SIZE 20             /* files queued per writer */
+
+static RESTORE_RECORD *new_restore_record(uint32_t VolSessionId, uint32_t VolSessionTime,
+                          int32_t FileIndex, int32_t Stream, char *data, uint32_t len)
+{
+   RESTORE_RECORD *rec;
+
+   rec = (RESTORE_RECORD *)malloc(sizeof(RESTORE_RECORD) + len);
+   rec->VolSessionId = VolSessionId;
+   rec->VolSessionTime = VolSessionTime;
+   rec->FileIndex = FileIndex;
+   rec->Stream = Stream;
+   rec->len = len;
+   memcpy(rec->data, data, len);
+   rec->data[len] = 0;
+   return rec;
+}
+
+static void free_restore_file(RESTORE_FILE *rf)
+{
+   if (is_bopen(&rf->bfd)) {
+      bclose(&rf->bfd);
+   }
+   if (rf->attr) {
+      free(rf->attr);
+   }
+   delete rf->records;
+   free(rf);
+}
+
+/* Update the bytes written, the writers and the job thread do it */
+static void add_restore_bytes(JCR *jcr, uint32_t bytes)
+{
+   jcr->lock();
+   jcr->JobBytes += bytes;
+   jcr->unlock();
+}
+
+/*
+ * Write the data of a file and set its attributes, called by a
+ *  writer thread. On error, the file is closed and its attributes
+ *  are not set, as in extract_data().
+ */
+static void write_restore_file(RESTORE_WRITER *wctx, RESTORE_FILE *rf)
+{
+   JCR *jcr = wctx->jcr;
+   ATTR *attr = wctx->attr;
+   RESTORE_RECORD *rec;
+   uint64_t fileAddr = 0;
+   char *wbuf;
+   uint32_t wsize;
+   int32_t stream;
+   ssize_t wstat;
+
+   /* The attributes were checked by the job thread */
+   unpack_attributes_record(jcr, rf->attr->Stream & STREAMMASK_TYPE, rf->attr->data,
+                            rf->attr->len, attr);
+   attr->data_stream = decode_stat(attr->attr, &attr->statp, sizeof(attr->statp), &attr->LinkFI);
+   build_attr_output_fnames(jcr, attr);
+
+   foreach_alist(rec, rf->records) {
+      stream = rec->Stream & STREAMMASK_TYPE;
+      wbuf = rec->data;
+      wsize = rec->len;
+      if (stream == STREAM_SPARSE_DATA || stream == STREAM_SPARSE_GZIP_DATA ||
+          stream == STREAM_SPARSE_COMPRESSED_DATA || (rec->Stream & STREAM_BIT_OFFSETS)) {
+         if (!seek_sparse_data(jcr, attr->ofname, &rf->bfd, &fileAddr, &wbuf, &wsize)) {
+            goto get_out;
+         }
+      }
+      if (stream != STREAM_FILE_DATA && stream != STREAM_SPARSE_DATA) {
+         if (!decompress_buffer(jcr, attr->ofname, stream, &wbuf, &wsize,
+                                &wctx->compress_buf, &wctx->compress_buf_size)) {
+            goto get_out;
+         }
+      }
+      if ((wstat = bwrite(&rf->bfd, wbuf, wsize)) != (ssize_t)wsize) {
+         berrno be;
+         if (wstat >= 0) {
+            Jmsg4(jcr, M_ERROR, 0, _("Wrong write size error at byte=%lld block=%d wanted=%d wrote=%d\n"),
+               rf->bfd.total_bytes, rf->bfd.block, wsize, wstat);
+         } else {
+            Jmsg3(jcr, M_ERROR, 0, _("Write error at byte=%lld on %s: ERR=%s\n"),
+               rf->bfd.total_bytes, attr->ofname, be.bstrerror(rf->bfd.berrno));
+         }
+         goto get_out;
+      }
+      add_restore_bytes(jcr, wsize);
+      fileAddr += wsize;
+   }
+   Dmsg2(130, "Writer restored %s size=%lld\n", attr->ofname, fileAddr);
+   set_attributes(jcr, attr, &rf->bfd);
+   return;
+
+get_out:
+   bclose(&rf->bfd);
+}
+
+static void *restore_writer(void *arg)
+{
+   worker *wrk = (worker *)arg;
+   RESTORE_FILE *rf;
+
+   lmgr_init_thread();
+   wrk->set_running();
+   while (!wrk->is_quit_state()) {
+      if (wrk->is_wait_state()) {
+         wrk->wait();
+         continue;
+      }
+      if ((rf = (RESTORE_FILE *)wrk->dequeue()) == NULL) {
+         continue;
+      }
+      write_restore_file((RESTORE_WRITER *)wrk->get_ctx(), rf);
+      free_restore_file(rf);
+   }
+   lmgr_cleanup_thread();
+   return NULL;
+}
+
+static void start_restore_writers(r_ctx &rctx, int nb)
+{
+   JCR *jcr = rctx.jcr;
+   RESTORE_WRITER *wctx;
+   worker *wrk;
+
+#ifdef HAVE_WIN32
+   nb = 0;                            /* EFS and portable data are not handled */
+#endif
+   if (nb <= 0 || jcr->crypto.pki_sign) {
+      return;
+   }
+   rctx.writers = (worker **)malloc(nb * sizeof(worker *));
+   for (int i=0; i < nb; i++) {
+      wctx = (RESTORE_WRITER *)malloc(sizeof(RESTORE_WRITER));
+      wctx->jcr = jcr;
+      wctx->attr = new_attr(jcr);
+      wctx->compress_buf_size = jcr->buf_size + 12 + ((jcr->buf_size+999) / 1000) + 100;
+      wctx->compress_buf = get_memory(wctx->compress_buf_size);
+      wrk = New(worker(RESTORE_WRITER_QUEUE_SIZE));
+      if (wrk->start(restore_writer, wctx) != 0) {
+         Jmsg0(jcr, M_WARNING, 0, _("Could not start a restore writer thread.\n"));
+         delete wrk;
+         free_attr(wctx->attr);
+         free_pool_memory(wctx->compress_buf);
+         free(wctx);
+         break;
+      }
+      rctx.writers[rctx.nb_writers++] = wrk;
+   }
+   if (rctx.nb_writers == 0) {
+      free(rctx.writers);
+      rctx.writers = NULL;
+   }
+   Dmsg1(50, "Started %d restore writers\n", rctx.nb_writers);
+}
+
+/* Wait for the queued files, and stop the writers */
+static void stop_restore_writers(r_ctx &rctx)
+{
+   RESTORE_WRITER *wctx;
+   worker *wrk;
+
+   for (int i=0; i < rctx.nb_writers; i++) {
+      wrk = rctx.writers[i];
+      wrk->finish_work();
+      wrk->stop();
+      wctx = (RESTORE_WRITER *)wrk->get_ctx();
+      delete wrk;
+      free_attr(wctx->attr);
+      free_pool_memory(wctx->compress_buf);
+      free(wctx);
+   }
+   if (rctx.writers) {
+      free(rctx.writers);
+      rctx.writers = NULL;
+   }
+   rctx.nb_writers = 0;
+}
+
+/*
+ * Return true if the file just created by the job thread can be
+ *  written by a writer thread.
+ */
+static bool use_restore_writer(r_ctx &rctx, ATTR *attr)
+{
+   return rctx.writers && !rctx.jcr->plugin && !have_darwin_os &&
+      attr->type == FT_REG && attr->delta_seq == 0 &&
+      attr->statp.st_size <= RESTORE_WRITER_MAX_SIZE &&
+      is_bopen(&rctx.bfd);
+}
+
+/* Take the file just created, its data records will follow */
+static void new_restore_file(r_ctx &rctx, uint32_t VolSessionId, uint32_t VolSessionTime,
+                             int32_t FileIndex, char *data, uint32_t len)
+{
+   RESTORE_FILE *rf;
+
+   rf = (RESTORE_FILE *)malloc(sizeof(RESTORE_FILE));
+   rf->bfd = rctx.bfd;
+   binit(&rctx.bfd);
+   rf->attr = new_restore_record(VolSessionId, VolSessionTime, FileIndex,
+                                 rctx.full_stream, data, len);
+   rf->records = New(alist(10, owned_by_alist));
+   rf->size = 0;
+   rctx.rfile = rf;
+}
+
+/*
+ * Keep a record of the file read for a writer. Returns false if the
+ *  record cannot be written by a writer.
+ */
+static bool add_restore_record(r_ctx &rctx, uint32_t VolSessionId, uint32_t VolSessionTime,
+                               int32_t FileIndex, char *data, uint32_t len)
+{
+   RESTORE_FILE *rf = rctx.rfile;
+   RESTORE_RECORD *first;
+
+   switch (rctx.stream) {
+   case STREAM_MD5_DIGEST:
+   case STREAM_SHA1_DIGEST:
+   case STREAM_SHA256_DIGEST:
+   case STREAM_SHA512_DIGEST:
+   case STREAM_XXH128_DIGEST:
+      return true;                    /* ignored by the restore */
+   case STREAM_FILE_DATA:
+   case STREAM_SPARSE_DATA:
+   case STREAM_GZIP_DATA:
+   case STREAM_SPARSE_GZIP_DATA:
+   case STREAM_COMPRESSED_DATA:
+   case STREAM_SPARSE_COMPRESSED_DATA:
+      break;
+   default:
+      return false;
+   }
+   /* A changed block chain is tracked by the job thread */
+   if (rctx.full_stream & (STREAM_BIT_DEDUPLICATION_DATA|STREAM_BIT_OFFSETS) ||
+       rf->size + len > RESTORE_WRITER_MAX_SIZE) {
+      return false;
+   }
+   /* All the data records of a file have the same stream */
+   first = (RESTORE_RECORD *)rf->records->first();
+   if (first && first->Stream != rctx.full_stream) {
+      return false;
+   }
+   rf->records->append(new_restore_record(VolSessionId, VolSessionTime, FileIndex,
+                                          rctx.full_stream, data, len));
+   rf->size += len;
+   rctx.jcr->ReadBytes += len;
+   return true;
+}
+
+/* The file is complete, queue it to the least busy writer */
+static void queue_restore_file(r_ctx &rctx)
+{
+   RESTORE_FILE *rf = rctx.rfile;
+   worker *wrk = rctx.writers[0];
+
+   rctx.rfile = NULL;
+   for (int i=1; i < rctx.nb_writers; i++) {
+      if (rctx.writers[i]->size() < wrk->size()) {
+         wrk = rctx.writers[i];
+      }
+   }
+   if (!wrk->queue(rf)) {
+      Jmsg0(rctx.jcr, M_ERROR, 0, _("Could not queue a file to a restore writer.\n"));
+      free_restore_file(rf);
+   }
+}
+
+/*
+ * The file has a record that a writer cannot handle. Give it back to
+ *  the job thread, its records and the current one are replayed by
+ *  restore_bget_msg() as if they came from the Storage daemon.
+ */
+static void replay_restore_file(r_ctx &rctx, RESTORE_RECORD *cur)
+{
+   RESTORE_FILE *rf = rctx.rfile;
+   RESTORE_RECORD *rec;
+
+   rctx.rfile = NULL;
+   rctx.bfd = rf->bfd;
+   binit(&rf->bfd);
+   rctx.extract = true;
+   rctx.fileAddr = 0;
+   /* As if the attributes were the last stream read */
+   rctx.stream = rf->attr->Stream & STREAMMASK_TYPE;
+   rctx.jcr->ReadBytes -= rf->size;   /* counted again by extract_data() */
+   if (!rctx.replay) {
+      rctx.replay = New(alist(10, owned_by_alist));
+   }
+   while ((rec = (RESTORE_RECORD *)rf->records->remove(0)) != NULL) {
+      rctx.replay->append(rec);
+   }
+   rctx.replay->append(cur);
+   Dmsg2(130, "Replay %d records of %s\n", rctx.replay->size(), rctx.attr->ofname);
+   free_restore_file(rf);
+}
+
+/*
+ * Get the next message, a replayed record header and data first, or
+ *  a message from the Storage daemon.
+ */
+static int restore_bget_msg(r_ctx &rctx, GetMsg *fdmsg, bmessage **pbmsg)
+{
+   bmessage *bmsg = *pbmsg;
+   RESTORE_RECORD *rec;
+
+   if (rctx.replay_rec && rctx.replay_data) {
+      rec = rctx.replay_rec;
+      rctx.replay_data = false;
+      bmsg->rbuf = rec->data;
+      bmsg->rbuflen = bmsg->msglen = bmsg->origlen = rec->len;
+      return rec->len;
+   }
+   if (rctx.replay_rec) {
+      free(rctx.replay_rec);
+      rctx.replay_rec = NULL;
+   }
+   if (rctx.replay && !rctx.replay->empty()) {
+      rec = (RESTORE_RECORD *)rctx.replay->remove(0);
+      if (!rctx.replay_hdr) {
+         rctx.replay_hdr = get_pool_memory(PM_MESSAGE);
+      }
+      Mmsg(rctx.replay_hdr, rec_header, (long)rec->VolSessionId, (long)rec->VolSessionTime,
+           (long)rec->FileIndex, (long)rec->Stream, (long)rec->len);
+      rctx.replay_rec = rec;
+      rctx.replay_data = true;
+      bmsg->rbuf = rctx.replay_hdr;
+      bmsg->rbuflen = bmsg->msglen = bmsg->origlen = strlen(rctx.replay_hdr);
+      return bmsg->rbuflen;
+   }
+   return fdmsg->bget_msg(pbmsg);
+}
+
+/* Free the writer state of a job, after stop_restore_writers() */
+static void free_restore_replay(r_ctx &rctx)
+{
+   if (rctx.rfile) {
+      free_restore_file(rctx.rfile);
+      rctx.rfile = NULL;
+   }
+   if (rctx.replay) {
+      delete rctx.replay;
+      rctx.replay = NULL;
+   }
+   if (rctx.replay_rec) {
+      free(rctx.replay_rec);
+      rctx.replay_rec = NULL;
+   }
+   if (rctx.replay_hdr) {
+      free_pool_memory(rctx.replay_hdr);
+      rctx.replay_hdr = NULL;
+   }
+}
+
 /*
  * Restore the requested files.
  */
@@ -406,6 +794,9 @@ void do_restore(JCR *jcr)
       jcr->compress_buf_size = compress_buf_size;
    }
 
+   start_restore_writers(rctx, client ? client->MaxRestoreWriters : 0);
+   start_restore_decompressors(rctx, client ? client->MaxRestoreDecompressors : 0);
+
    GetMsg *fdmsg = get_msg_buffer(jcr, sd, rec_header);
 
    fdmsg->start_read_sock();
@@ -465,7 +856,7 @@ void do_restore(JCR *jcr)
 #endif
 
    Dsm_check(200);
-   while ((bget_ret = fdmsg->bget_msg(&bmsg)) >= 0 && !job_canceled(jcr)) {
+   while ((bget_ret = restore_bget_msg(rctx, fdmsg, &bmsg)) >= 0 && !job_canceled(jcr)) {
       time_t now = time(NULL);
       if (jcr->last_stat_time == 0) {
          jcr->last_stat_time = now;
@@ -492,7 +883,7 @@ void do_restore(JCR *jcr)
             jcr->JobFiles, file_index, rctx.size, rctx.stream, stream_to_ascii(rctx.stream));
 
       /* Now we expect the Stream Data */
-      if ((bget_ret = fdmsg->bget_msg(&bmsg)) < 0) {
+      if ((bget_ret = restore_bget_msg(rctx, fdmsg, &bmsg)) < 0) {
          if (bget_ret != BNET_EXT_TERMINATE) {
             Jmsg1(jcr, M_FATAL, 0, _("Data record error. ERR=%s\n"), sd->bstrerror());
          } else {
@@ -510,6 +901,23 @@ void do_restore(JCR *jcr)
       Dmsg3(DT_DEDUP|620, "Got stream: %s len=%d extract=%d\n", stream_to_ascii(rctx.stream),
             bmsg->msglen, rctx.extract);
 
+      /* The current file is read for a restore writer */
+      if (rctx.rfile) {
+         if (add_restore_record(rctx, VolSessionId, VolSessionTime, file_index,
+                                bmsg->rbuf, bmsg->rbuflen)) {
+            continue;
+         }
+         if (rctx.stream == STREAM_UNIX_ATTRIBUTES ||
+             rctx.stream == STREAM_UNIX_ATTRIBUTES_EX ||
+             rctx.stream == STREAM_PLUGIN_NAME) {
+            queue_restore_file(rctx);
+         } else {
+            replay_restore_file(rctx, new_restore_record(VolSessionId, VolSessionTime,
+                                   file_index, rctx.full_stream, bmsg->rbuf, bmsg->rbuflen));
+            continue;
+         }
+      }
+
       /* If we change streams, close and reset alternate data streams */
       if (rctx.prev_stream != rctx.stream) {
          if (is_bopen(&rctx.forkbfd)) {
@@ -636,6 +1044,11 @@ void do_restore(JCR *jcr)
                } else {
                   set_attributes(jcr, attr, &rctx.bfd);
                }
+            } else if (use_restore_writer(rctx, attr)) {
+               /* The data and attributes are written by a writer thread */
+               new_restore_file(rctx, VolSessionId, VolSessionTime, file_index,
+                                bmsg->rbuf, bmsg->rbuflen);
+               rctx.extract = false;
             }
             break;
          }
@@ -751,6 +1164,15 @@ void do_restore(JCR *jcr)
 
             if (rctx.full_stream & STREAM_BIT_OFFSETS) {
                rctx.flags |= FO_OFFSETS;
+
+               /* Remember the first part of a changed block chain, the
+                *  next parts can be written only over this file
+                *  (see create_file()).
+                */
+               if (!jcr->plugin && attr->type == FT_REG && attr->delta_seq == 0 &&
+                   rctx.prev_stream != rctx.stream) {
+                  path_list_add(jcr, strlen(attr->ofname), attr->ofname);
+               }
             }
 
             if (rctx.stream == STREAM_GZIP_DATA
@@ -1007,6 +1429,7 @@ void do_restore(JCR *jcr)
       case STREAM_SHA1_DIGEST:
       case STREAM_SHA256_DIGEST:
       case STREAM_SHA512_DIGEST:
+      case STREAM_XXH128_DIGEST:
          break;
 
       case STREAM_PROGRAM_NAMES:
@@ -1057,6 +1480,9 @@ void do_restore(JCR *jcr)
    if (is_bopen(&rctx.forkbfd)) {
       bclose_chksize(rctx, &rctx.forkbfd, rctx.fork_size);
    }
+   if (rctx.rfile) {
+      queue_restore_file(rctx);
+   }
 
    if (!close_previous_stream(rctx)) {
       goto get_out;
@@ -1069,6 +1495,10 @@ get_out:
 
 ok_out:
    Dsm_check(200);
+   stop_restore_writers(rctx);
+   free_restore_replay(rctx);
+   discard_restore_blocks(rctx);
+   stop_restore_decompressors(rctx);
    Dmsg0(DT_DEDUP|215, "wait BufferedMsg\n");
    fdmsg->wait_read_sock(jcr->is_job_canceled());
    delete bmsg;
@@ -1212,6 +1642,16 @@ static int do_file_digest(JCR *jcr, FF_PKT *ff_pkt, bool top_level)
 }
 
 bool sparse_data(JCR *jcr, BFILE *bfd, uint64_t *addr, char **data, uint32_t *length, int flags)
+{
+   return seek_sparse_data(jcr, jcr->last_fname, bfd, addr, data, length);
+}
+
+/*
+ * Seek to the address at the start of a sparse or offset record,
+ *  fname is used in the error messages.
+ */
+static bool seek_sparse_data(JCR *jcr, const char *fname, BFILE *bfd, uint64_t *addr,
+                             char **data, uint32_t *length)
 {
    unser_declare;
    uint64_t faddr;
@@ -1223,7 +1663,7 @@ bool sparse_data(JCR *jcr, BFILE *bfd, uint64_t *addr, char **data, uint32_t *le
       if (blseek(bfd, (boffset_t)*addr, SEEK_SET) < 0) {
          berrno be;
          Jmsg3(jcr, M_ERROR, 0, _("Seek to %s error on %s: ERR=%s\n"),
-               edit_uint64(*addr, ec1), jcr->last_fname,
+               edit_uint64(*addr, ec1), fname,
                be.bstrerror(bfd->berrno));
          return false;
       }
@@ -1234,6 +1674,19 @@ bool sparse_data(JCR *jcr, BFILE *bfd, uint64_t *addr, char **data, uint32_t *le
 }
 
 bool decompress_data(JCR *jcr, int32_t stream, char **data, uint32_t *length)
+{
+   return decompress_buffer(jcr, jcr->last_fname, stream, data, length,
+                            &jcr->compress_buf, &jcr->compress_buf_size);
+}
+
+/*
+ * Uncompress data into buf, which is grown as needed. The restore
+ *  writer threads have their own buffer, fname is used in the error
+ *  messages.
+ */
+static bool decompress_buffer(JCR *jcr, const char *fname, int32_t stream,
+                              char **data, uint32_t *length,
+                              POOLMEM **buf, int32_t *buf_size)
 {
 #if defined(HAVE_LZO) || defined(HAVE_LIBZ)
    char ec1[50];                   /* Buffer printing huge values */
@@ -1275,27 +1728,27 @@ bool decompress_data(JCR *jcr, int32_t stream, char **data, uint32_t *length)
       switch(comp_magic) {
 #ifdef HAVE_LZO
          case COMPRESS_LZO1X:
-            compress_len = jcr->compress_buf_size;
+            compress_len = *buf_size;
             cbuf = (const unsigned char*)*data + sizeof(comp_stream_header);
             real_compress_len = *length - sizeof(comp_stream_header);
             Dmsg2(200, "Comp_len=%d msglen=%d\n", compress_len, *length);
             while ((r=lzo1x_decompress_safe(cbuf, real_compress_len,
-                                            (unsigned char *)jcr->compress_buf, &compress_len, NULL)) == LZO_E_OUTPUT_OVERRUN)
+                                            (unsigned char *)*buf, &compress_len, NULL)) == LZO_E_OUTPUT_OVERRUN)
             {
                /*
                 * The buffer size is too small, try with a bigger one
                 */
-               compress_len = jcr->compress_buf_size = jcr->compress_buf_size + (jcr->compress_buf_size >> 1);
+               compress_len = *buf_size = *buf_size + (*buf_size >> 1);
                Dmsg2(200, "Comp_len=%d msglen=%d\n", compress_len, *length);
-               jcr->compress_buf = check_pool_memory_size(jcr->compress_buf,
+               *buf = check_pool_memory_size(*buf,
                                                     compress_len);
             }
             if (r != LZO_E_OK) {
                Qmsg(jcr, M_ERROR, 0, _("LZO uncompression error on file %s. ERR=%d\n"),
-                    jcr->last_fname, r);
+                    fname, r);
                return false;
             }
-            *data = jcr->compress_buf;
+            *data = *buf;
             *length = compress_len;
             Dmsg2(200, "Write uncompressed %d bytes, total before write=%s\n", compress_len, edit_uint64(jcr->JobBytes, ec1));
             return true;
@@ -1314,23 +1767,23 @@ bool decompress_data(JCR *jcr, int32_t stream, char **data, uint32_t *length)
        *  needed by the zlib routines, they should not otherwise
        *  be used in Bacula.
        */
-      compress_len = jcr->compress_buf_size;
+      compress_len = *buf_size;
       Dmsg2(200, "Comp_len=%d msglen=%d\n", compress_len, *length);
-      while ((stat=uncompress((Byte *)jcr->compress_buf, &compress_len,
+      while ((stat=uncompress((Byte *)*buf, &compress_len,
                               (const Byte *)*data, (uLong)*length)) == Z_BUF_ERROR)
       {
          /* The buffer size is too small, try with a bigger one. */
-         compress_len = jcr->compress_buf_size = jcr->compress_buf_size + (jcr->compress_buf_size >> 1);
+         compress_len = *buf_size = *buf_size + (*buf_size >> 1);
          Dmsg2(200, "Comp_len=%d msglen=%d\n", compress_len, *length);
-         jcr->compress_buf = check_pool_memory_size(jcr->compress_buf,
+         *buf = check_pool_memory_size(*buf,
                                                     compress_len);
       }
       if (stat != Z_OK) {
          Qmsg(jcr, M_ERROR, 0, _("Uncompression error on file %s. ERR=%s\n"),
-              jcr->last_fname, zlib_strerror(stat));
+              fname, zlib_strerror(stat));
          return false;
       }
-      *data = jcr->compress_buf;
+      *data = *buf;
       *length = compress_len;
       Dmsg2(200, "Write uncompressed %d bytes, total before write=%s\n", compress_len, edit_uint64(jcr->JobBytes, ec1));
       return true;
@@ -1432,6 +1885,211 @@ static bool store_data(r_ctx &rctx, char *data, const int32_t length, bool win32
    return true;
 }
 
+/*
+ * Restore decompression threads
+ *
+ * When the Client has Maximum Restore Decompressors set, the compressed
+ *  blocks of the files restored by the job thread are decompressed by a
+ *  pool of threads. Each record is compressed on its own, so the blocks
+ *  of a file can be decompressed at the same time. The job thread
+ *  decrypts the data (the cipher context is chained from one record to
+ *  the next), queues the block, and writes the oldest blocks in order
+ *  as they are done. The queued blocks are written before the file is
+ *  closed.
+ */
+#define RESTORE_PIPE_DEPTH 2           /* blocks queued per thread */
+
+static void *restore_decompressor(void *arg)
+{
+   worker *wrk = (worker *)arg;
+   RESTORE_PIPE *rp = (RESTORE_PIPE *)wrk->get_ctx();
+   RESTORE_BLOCK *b;
+   bool ok;
+
+   lmgr_init_thread();
+   wrk->set_running();
+   while (!wrk->is_quit_state()) {
+      if (wrk->is_wait_state()) {
+         wrk->wait();
+         continue;
+      }
+      if ((b = (RESTORE_BLOCK *)wrk->dequeue()) == NULL) {
+         continue;
+      }
+      b->wbuf = b->data;
+      b->wsize = b->len;
+      if (b->flags & (FO_SPARSE|FO_OFFSETS)) {
+         b->wbuf += OFFSET_FADDR_SIZE;  /* the address is used by the job thread */
+         b->wsize -= OFFSET_FADDR_SIZE;
+      }
+      ok = decompress_buffer(rp->jcr, b->fname, b->stream, &b->wbuf, &b->wsize,
+                             &b->buf, &b->buf_size);
+      P(rp->mutex);
+      b->ok = ok;
+      b->done = true;
+      pthread_cond_broadcast(&rp->cond);
+      V(rp->mutex);
+   }
+   lmgr_cleanup_thread();
+   return NULL;
+}
+
+static void start_restore_decompressors(r_ctx &rctx, int nb)
+{
+   JCR *jcr = rctx.jcr;
+   RESTORE_PIPE *rp;
+   RESTORE_BLOCK *b;
+   worker *wrk;
+
+   if (nb <= 0 || !(have_libz || have_lzo)) {
+      return;
+   }
+   rp = (RESTORE_PIPE *)malloc(sizeof(RESTORE_PIPE));
+   bmemset(rp, 0, sizeof(RESTORE_PIPE));
+   rp->jcr = jcr;
+   pthread_mutex_init(&rp->mutex, NULL);
+   pthread_cond_init(&rp->cond, NULL);
+   rp->threads = (worker **)malloc(nb * sizeof(worker *));
+   for (int i=0; i < nb; i++) {
+      wrk = New(worker(RESTORE_PIPE_DEPTH * nb));
+      if (wrk->start(restore_decompressor, rp) != 0) {
+         Jmsg0(jcr, M_WARNING, 0, _("Could not start a restore decompression thread.\n"));
+         delete wrk;
+         break;
+      }
+      rp->threads[rp->nb_threads++] = wrk;
+   }
+   rp->nb_blocks = RESTORE_PIPE_DEPTH * rp->nb_threads;
+   rp->blocks = (RESTORE_BLOCK *)malloc(rp->nb_blocks * sizeof(RESTORE_BLOCK));
+   for (int i=0; i < rp->nb_blocks; i++) {
+      b = &rp->blocks[i];
+      bmemset(b, 0, sizeof(RESTORE_BLOCK));
+      b->data = get_memory(jcr->buf_size);
+      b->buf_size = jcr->compress_buf_size;
+      b->buf = get_memory(b->buf_size);
+   }
+   rctx.pipe = rp;
+   Dmsg1(50, "Started %d restore decompressors\n", rp->nb_threads);
+   if (rp->nb_threads == 0) {
+      stop_restore_decompressors(rctx);
+   }
+}
+
+static void stop_restore_decompressors(r_ctx &rctx)
+{
+   RESTORE_PIPE *rp = rctx.pipe;
+
+   if (!rp) {
+      return;
+   }
+   for (int i=0; i < rp->nb_threads; i++) {
+      rp->threads[i]->finish_work();
+      rp->threads[i]->stop();
+      delete rp->threads[i];
+   }
+   for (int i=0; i < rp->nb_blocks; i++) {
+      free_pool_memory(rp->blocks[i].data);
+      free_pool_memory(rp->blocks[i].buf);
+   }
+   free(rp->blocks);
+   free(rp->threads);
+   pthread_cond_destroy(&rp->cond);
+   pthread_mutex_destroy(&rp->mutex);
+   free(rp);
+   rctx.pipe = NULL;
+}
+
+/* Wait until the oldest queued block is decompressed, and remove it */
+static RESTORE_BLOCK *wait_restore_block(RESTORE_PIPE *rp)
+{
+   RESTORE_BLOCK *b = &rp->blocks[rp->first];
+
+   P(rp->mutex);
+   while (!b->done) {
+      pthread_cond_wait(&rp->cond, &rp->mutex);
+   }
+   V(rp->mutex);
+   rp->first = (rp->first + 1) % rp->nb_blocks;
+   rp->count--;
+   return b;
+}
+
+/* Forget the queued blocks, after an error */
+static void discard_restore_blocks(r_ctx &rctx)
+{
+   while (rctx.pipe && rctx.pipe->count > 0) {
+      wait_restore_block(rctx.pipe);
+   }
+}
+
+/* Write the oldest queued block */
+static bool write_restore_block(r_ctx &rctx)
+{
+   RESTORE_BLOCK *b = wait_restore_block(rctx.pipe);
+   char *data = b->data;
+   uint32_t len = b->len;
+
+   if (!b->ok) {
+      goto get_out;
+   }
+   if (b->flags & (FO_SPARSE|FO_OFFSETS)) {
+      if (!sparse_data(rctx.jcr, &rctx.bfd, &rctx.fileAddr, &data, &len, b->flags)) {
+         goto get_out;
+      }
+   }
+   if (!store_data(rctx, b->wbuf, b->wsize, false)) {
+      goto get_out;
+   }
+   add_restore_bytes(rctx.jcr, b->wsize);
+   rctx.fileAddr += b->wsize;
+   return true;
+
+get_out:
+   discard_restore_blocks(rctx);
+   return false;
+}
+
+/* Write all the queued blocks, before the file is closed */
+static bool drain_restore_blocks(r_ctx &rctx)
+{
+   while (rctx.pipe && rctx.pipe->count > 0) {
+      if (!write_restore_block(rctx)) {
+         return false;
+      }
+   }
+   return true;
+}
+
+/*
+ * Queue a compressed block to the decompression threads. The oldest
+ *  block is written first when all the blocks are in use.
+ */
+static bool queue_restore_block(r_ctx &rctx, int32_t stream, int flags, char *data, uint32_t len)
+{
+   RESTORE_PIPE *rp = rctx.pipe;
+   RESTORE_BLOCK *b;
+   worker *wrk;
+
+   if (rp->count == rp->nb_blocks && !write_restore_block(rctx)) {
+      return false;
+   }
+   b = &rp->blocks[(rp->first + rp->count) % rp->nb_blocks];
+   b->data = check_pool_memory_size(b->data, len);
+   memcpy(b->data, data, len);
+   b->len = len;
+   b->stream = stream;
+   b->flags = flags;
+   b->fname = rctx.jcr->last_fname;     /* not changed until the file is closed */
+   b->done = b->ok = false;
+   rp->count++;
+   wrk = rp->threads[rp->next_thread++ % rp->nb_threads];
+   if (!wrk->queue(b)) {
+      b->done = true;                   /* b->ok is false */
+      return write_restore_block(rctx);
+   }
+   return true;
+}
+
 /*
  * In the context of jcr, write data to bfd.
  * We write buflen bytes in buf at addr. addr is updated in place.
@@ -1508,6 +2166,14 @@ int32_t extract_data(r_ctx &rctx, POOLMEM *buf, int32_t buflen)
       Dmsg2(130, "Encryption writing full block, %u bytes, remaining %u bytes in buffer\n", wsize, cipher_ctx->buf_len);
    }
 
+   if (rctx.pipe && (flags & FO_COMPRESS) && !(flags & FO_WIN32DECOMP) && !rctx.efs) {
+      /* Decompressed and written later, the address is kept with the block */
+      if (!queue_restore_block(rctx, stream, flags, wbuf, wsize)) {
+         goto get_out;
+      }
+      goto crypto_out;
+   }
+
    if ((flags & FO_SPARSE) || (flags & FO_OFFSETS)) {
       if (!sparse_data(jcr, bfd, &rctx.fileAddr, &wbuf, &wsize, flags)) {
          goto get_out;
@@ -1523,10 +2189,11 @@ int32_t extract_data(r_ctx &rctx, POOLMEM *buf, int32_t buflen)
    if (!store_data(rctx, wbuf, wsize, (flags & FO_WIN32DECOMP) != 0)) {
       goto get_out;
    }
-   jcr->JobBytes += wsize;
+   add_restore_bytes(jcr, wsize);
    rctx.fileAddr += wsize;
    Dmsg2(130, "Write %u bytes, JobBytes=%s\n", wsize, edit_uint64(jcr->JobBytes, ec1));
 
+crypto_out:
    /* Clean up crypto buffers */
    if (flags & FO_ENCRYPT) {
       /* Move any remaining data to start of buffer */
@@ -1542,6 +2209,7 @@ int32_t extract_data(r_ctx &rctx, POOLMEM *buf, int32_t buflen)
    return wsize;
 
 get_out:
+   discard_restore_blocks(rctx);
    return -1;
 }
 
@@ -1557,6 +2225,10 @@ static bool close_previous_stream(r_ctx &rctx)
     * close the output file and validate the signature.
     */
    if (rctx.extract) {
+      /* The blocks still decompressed are written before the cipher is flushed */
+      if (!drain_restore_blocks(rctx)) {
+         bclose(&rctx.bfd);
+      }
       if (rctx.size > 0 && !is_bopen(&rctx.bfd)) {
          Jmsg0(rctx.jcr, M_ERROR, 0, _("Logic error: output file should be open\n"));
          Pmsg2(000, "=== logic error size=%d bopen=%d\n", rctx.size,
@@ -1574,6 +2246,19 @@ static bool close_previous_stream(r_ctx &rctx)
          rctx.count = 0;
       }
 
+#ifndef HAVE_WIN32
+      /* A part of a delta chain is written over the previous content,
+       *  the file may be smaller now.
+       */
+      if (!rctx.jcr->plugin && rctx.attr->type == FT_REG &&
+          rctx.attr->delta_seq > 0 && is_bopen(&rctx.bfd) &&
+          ftruncate(rctx.bfd.fid, rctx.attr->statp.st_size) != 0) {
+         berrno be;
+         Qmsg2(rctx.jcr, M_ERROR, 0, _("Cannot truncate %s: ERR=%s\n"),
+               rctx.attr->ofname, be.bstrerror());
+      }
+#endif
+
       if (rctx.jcr->plugin) {
          plugin_set_attributes(rctx.jcr, rctx.attr, &rctx.bfd);
       } else {
@@ -1663,7 +2348,7 @@ again:
    if (!store_data(rctx, wbuf, wsize, (flags & FO_WIN32DECOMP) != 0)) {
       return false;
    }
-   jcr->JobBytes += wsize;
+   add_restore_bytes(jcr, wsize);
    Dmsg2(130, "Flush write %u bytes, JobBytes=%s\n", wsize, edit_uint64(jcr->JobBytes, ec1));
 
    /* Move any remaining data to start of buffer. */
@@ -38,6 +38,74 @@ struct RESTORE_CIPHER_CTX {
    int32_t packet_len;                 /* Total bytes in packet */
 };
 
+/*
+ * A record of a file restored by a writer thread
+ */
+struct RESTORE_RECORD {
+   uint32_t VolSessionId;
+   uint32_t VolSessionTime;
+   int32_t FileIndex;
+   int32_t Stream;                     /* full stream including new bits */
+   uint32_t len;                       /* length of data */
+   char data[1];
+};
+
+/*
+ * A file restored by a writer thread. The job thread creates the
+ *  file and keeps its data records, the writer writes the data and
+ *  sets the attributes.
+ */
+struct RESTORE_FILE {
+   BFILE bfd;                          /* opened by create_file() */
+   RESTORE_RECORD *attr;               /* attributes record */
+   alist *records;                     /* data records */
+   uint32_t size;                      /* bytes in the data records */
+};
+
+/*
+ * Context of a restore writer thread
+ */
+struct RESTORE_WRITER {
+   JCR *jcr;
+   ATTR *attr;                         /* attributes of the current file */
+   POOLMEM *compress_buf;              /* decompression buffer */
+   int32_t compress_buf_size;          /* length of decompression buffer */
+};
+
+/*
+ * A compressed block decompressed by a restore decompression thread
+ */
+struct RESTORE_BLOCK {
+   const char *fname;                  /* file name for the messages */
+   int32_t stream;                     /* stream less new bits */
+   int flags;                          /* FO_SPARSE, FO_OFFSETS */
+   POOLMEM *data;                      /* compressed data, may start with an address */
+   uint32_t len;                       /* length of data */
+   POOLMEM *buf;                       /* decompression buffer */
+   int32_t buf_size;                   /* length of decompression buffer */
+   char *wbuf;                         /* decompressed data */
+   uint32_t wsize;                     /* its length */
+   bool done;                          /* set by the thread, under the pipe mutex */
+   bool ok;                            /* set if decompressed */
+};
+
+/*
+ * Decompression threads of a restore, the blocks are a ring
+ *  written in order by the job thread
+ */
+struct RESTORE_PIPE {
+   JCR *jcr;
+   pthread_mutex_t mutex;
+   pthread_cond_t cond;                /* signaled when a block is done */
+   worker **threads;                   /* decompression threads */
+   int nb_threads;
+   int next_thread;                    /* round robin */
+   RESTORE_BLOCK *blocks;              /* ring of blocks */
+   int nb_blocks;
+   int first;                          /* oldest block queued */
+   int count;                          /* number of blocks queued */
+};
+
 /*
  * Restore context
  */
@@ -61,6 +129,14 @@ struct r_ctx {
    alist *delayed_streams;             /* streams that should be restored as last */
    worker *efs;                        /* Windows EFS worker thread */
    int32_t count;                      /* Debug count */
+   worker **writers;                   /* restore writer threads (if any) */
+   int nb_writers;                     /* number of writer threads */
+   RESTORE_FILE *rfile;                /* file being read for a writer */
+   alist *replay;                      /* records given back to the job thread */
+   RESTORE_RECORD *replay_rec;         /* record being replayed */
+   POOLMEM *replay_hdr;                /* its record header */
+   bool replay_data;                   /* set when its data is next */
+   RESTORE_PIPE *pipe;                 /* decompression threads (if any) */
 
    SIGNATURE *sig;                     /* Cryptographic signature (if any) for file */
    CRYPTO_SESSION *cs;                 /* Cryptographic session data (if any) for file */
@@ -27,7 +27,7 @@
 #include "filed.h"
 
 static int verify_file(JCR *jcr, FF_PKT *ff_pkt, bool);
-static int read_digest(BFILE *bfd, DIGEST *digest, JCR *jcr);
+static int read_digest(BFILE *bfd, DIGEST *digest, JCR *jcr, bool keep_data);
 
 /*
  * Find all the requested files and send attributes
@@ -215,7 +215,7 @@ static int verify_file(JCR *jcr, FF_PKT *ff_pkt, bool top_level)
     * First we initialise, then we read files, other streams and Finder Info.
     */
    if (ff_pkt->type != FT_LNKSAVED && (S_ISREG(ff_pkt->statp.st_mode) &&
-            ff_pkt->flags & (FO_MD5|FO_SHA1|FO_SHA256|FO_SHA512))) {
+            ff_pkt->flags & (FO_MD5|FO_SHA1|FO_SHA256|FO_SHA512|FO_XXH128))) {
       /*
        * Create our digest context. If this fails, the digest will be set to NULL
        * and not used.
@@ -235,6 +235,10 @@ static int verify_file(JCR *jcr, FF_PKT *ff_pkt, bool top_level)
       } else if (ff_pkt->flags & FO_SHA512) {
          digest = crypto_digest_new(jcr, CRYPTO_DIGEST_SHA512);
          digest_stream = STREAM_SHA512_DIGEST;
+
+      } else if (ff_pkt->flags & FO_XXH128) {
+         digest = crypto_digest_new(jcr, CRYPTO_DIGEST_XXH128);
+         digest_stream = STREAM_XXH128_DIGEST;
       }
 
       /* Did digest initialization fail? */
@@ -285,7 +289,12 @@ good_rtn:
  * Compute message digest for the file specified by ff_pkt.
  * In case of errors we need the job control record and file name.
  */
-int digest_file(JCR *jcr, FF_PKT *ff_pkt, DIGEST *digest)
+/*
+ * Compute the digest of a file. With keep_data, the data fork
+ *  is also copied to jcr->accurate_data, so an accurate backup
+ *  can send a changed file without reading it a second time.
+ */
+int digest_file(JCR *jcr, FF_PKT *ff_pkt, DIGEST *digest, bool keep_data)
 {
    BFILE bfd;
    bool do_digest = true;
@@ -313,7 +322,7 @@ int digest_file(JCR *jcr, FF_PKT *ff_pkt, DIGEST *digest)
                ff_pkt->fname, be.bstrerror());
          return 1;
       }
-      read_digest(&bfd, digest, jcr);
+      read_digest(&bfd, digest, jcr, keep_data);
       bclose(&bfd);
    }
 
@@ -330,7 +339,7 @@ int digest_file(JCR *jcr, FF_PKT *ff_pkt, DIGEST *digest)
          }
          return 1;
       } 
-      read_digest(&bfd, digest, jcr);
+      read_digest(&bfd, digest, jcr, false);
       bclose(&bfd);
    } 
    if (digest && ff_pkt->flags & FO_HFSPLUS) {
@@ -344,7 +353,7 @@ int digest_file(JCR *jcr, FF_PKT *ff_pkt, DIGEST *digest)
  * Read message digest of bfd, updating digest
  * In case of errors we need the job control record and file name.
  */
-static int read_digest(BFILE *bfd, DIGEST *digest, JCR *jcr)
+static int read_digest(BFILE *bfd, DIGEST *digest, JCR *jcr, bool keep_data)
 {
    char  *buf;
    int64_t n;
@@ -360,7 +369,22 @@ static int read_digest(BFILE *bfd, DIGEST *digest, JCR *jcr)
    if (ff_pkt->flags & FO_SPARSE) {
       bufsiz -= OFFSET_FADDR_SIZE;
    }
+   if (keep_data) {
+      jcr->accurate_data_len = 0;
+   }
    while ((n=bread(bfd, buf, bufsiz)) > 0) {
+      /* Keep the data as it was read, holes included */
+      if (keep_data) {
+         if (jcr->accurate_data_len + n > (int64_t)me->max_accurate_buffer_size) {
+            jcr->accurate_data_len = 0;      /* the file grew, read it again later */
+            keep_data = false;
+         } else {
+            jcr->accurate_data = check_pool_memory_size(jcr->accurate_data,
+                                                        jcr->accurate_data_len + n);
+            memcpy(jcr->accurate_data + jcr->accurate_data_len, buf, n);
+            jcr->accurate_data_len += n;
+         }
+      }
       /* Check for sparse blocks */
       if (ff_pkt->flags & FO_SPARSE) {
          bool allZeros = false;
@@ -390,6 +414,9 @@ static int read_digest(BFILE *bfd, DIGEST *digest, JCR *jcr)
    free(buf);
    if (n < 0) {
       berrno be;
+      if (keep_data) {
+         jcr->accurate_data_len = 0;
+      }
       be.set_errno(bfd->berrno);
       Dmsg2(100, "Error reading file %s: ERR=%s\n", jcr->last_fname, be.bstrerror());
       Jmsg(jcr, M_ERROR, 1, _("Error reading file %s: ERR=%s\n"),
@@ -165,6 +165,10 @@ void v_ctx::scan_fileset()
             digesttype = CRYPTO_DIGEST_SHA512;
             return;
          }
+         if (fo->flags & FO_XXH128) {
+            digesttype = CRYPTO_DIGEST_XXH128;
+            return;
+         }
       }
    }
    digesttype = CRYPTO_DIGEST_NONE;
@@ -434,6 +438,11 @@ void do_verify_volume(JCR *jcr)
          digest_code = "SHA512";
          break;
 
+      case STREAM_XXH128_DIGEST:
+         bin_to_base64(digest, sizeof(digest), (char *)bmsg->rbuf, CRYPTO_DIGEST_XXH128_SIZE, true);
+         digest_code = "XXH128";
+         break;
+
       default:
          *digest = 0;
          break;
@@ -64,5 +64,7 @@
 #define FO_PLUGIN        (1<<29)      /* Plugin data stream -- return to plugin on restore */
 #define FO_OFFSETS       (1<<30)      /* Keep I/O file offsets */
 #define FO_DEDUPLICATION (1ULL<<31)   /* Do deduplication */
+#define FO_CHANGED_BLOCKS (1ULL<<32)  /* Send only the blocks changed since the last backup */
+#define FO_XXH128        (1ULL<<33)   /* Do XXH128 checksum (not cryptographic) */
 
 #endif /* __BFILEOPTSS_H */
@@ -408,6 +408,234 @@ void encode_stat(char *buf, struct stat *statp, int stat_size, int32_t LinkFI, i
   #endif
 #endif
 
+/*
+ * Compact stat packet
+ *
+ *  The packet starts with COMPACT_STAT_MARK, followed by the same
+ *  17 fields as the space separated packet, in the same order
+ *  and without separator:
+ *
+ *   st_dev, st_ino, st_mode, st_nlink, st_uid, st_gid, st_rdev,
+ *   st_size, st_blksize, st_blocks, st_atime, st_mtime, st_ctime,
+ *   LinkFI, st_flags, data_stream, st_fattrs
+ *
+ *  Some fields are stored as the difference with a predicted value
+ *  (st_nlink - 1, st_blksize - 4096, st_blocks - (st_size + 511) / 512,
+ *  st_atime - st_mtime and st_ctime - st_mtime). Each number is zigzag
+ *  encoded to keep small negative numbers short, then written 5 bits
+ *  per base64 digit, least significant bits first. The digits 'A' to
+ *  'f' (0-31) end a number, the digits 'g' to '/' (32-63) are followed
+ *  by more digits.
+ *
+ *  A typical packet is about 40% shorter, and it is decoded in a single
+ *  pass with one table lookup per digit. The conversion is done on the
+ *  fields and not on a struct stat, so the packets of a File daemon
+ *  running on another platform are not altered. Only the catalog may
+ *  use this form, the File daemons and the Volumes still use the
+ *  space separated packet.
+ *
+ *  External programs that read the LStat column directly, for example
+ *  with the base64_decode_lstat() SQL function, do not know this form.
+ *  They should use the .bvfs_decode_lstat command, that reads both.
+ */
+#define COMPACT_STAT_MARK    '.'
+#define STAT_FIELDS          17
+#define BAD                  0xFF
+
+static const char compact_digits[] =
+   "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static const uint8_t compact_map[256] = {
+   BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD,
+   BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD,
+   BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD,  62, BAD, BAD, BAD,  63,
+    52,  53,  54,  55,  56,  57,  58,  59,  60,  61, BAD, BAD, BAD, BAD, BAD, BAD,
+   BAD,   0,   1,   2,   3,   4,   5,   6,   7,   8,   9,  10,  11,  12,  13,  14,
+    15,  16,  17,  18,  19,  20,  21,  22,  23,  24,  25, BAD, BAD, BAD, BAD, BAD,
+   BAD,  26,  27,  28,  29,  30,  31,  32,  33,  34,  35,  36,  37,  38,  39,  40,
+    41,  42,  43,  44,  45,  46,  47,  48,  49,  50,  51, BAD, BAD, BAD, BAD, BAD,
+   BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD,
+   BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD,
+   BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD,
+   BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD,
+   BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD,
+   BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD,
+   BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD,
+   BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD,
+};
+
+static inline char *compact_put(char *p, int64_t val)
+{
+   uint64_t u = ((uint64_t)val << 1) ^ (uint64_t)(val >> 63);
+
+   while (u >= 32) {
+      *p++ = compact_digits[32 + (u & 0x1F)];
+      u >>= 5;
+   }
+   *p++ = compact_digits[u];
+   return p;
+}
+
+/* Stops on any unexpected character, a truncated packet gives zeros */
+static inline char *compact_get(char *p, int64_t *val)
+{
+   uint64_t u = 0;
+   uint8_t d;
+   int shift = 0;
+
+   while ((d = compact_map[(uint8_t)*p]) != BAD) {
+      p++;
+      u |= (uint64_t)(d & 0x1F) << shift;
+      shift += 5;
+      if (d < 32 || shift > 60) {
+         break;
+      }
+   }
+   *val = (int64_t)(u >> 1) ^ -(int64_t)(u & 1);
+   return p;
+}
+
+#undef BAD
+
+/* Decode the fields of a compact packet */
+static void decode_compact_fields(char *buf, int64_t *v)
+{
+   char *p = buf + 1;                 /* skip mark */
+
+   for (int i = 0; i < STAT_FIELDS; i++) {
+      p = compact_get(p, &v[i]);
+   }
+   v[3] += 1;                         /* st_nlink */
+   v[8] += 4096;                      /* st_blksize */
+   v[9] += (v[7] + 511) / 512;        /* st_blocks */
+   v[10] += v[11];                    /* st_atime */
+   v[12] += v[11];                    /* st_ctime */
+}
+
+/* Decode the fields of a space separated packet, missing ones are 0 */
+static void decode_stat_fields(char *buf, int64_t *v)
+{
+   char *p = buf;
+   int i = 0;
+
+   while (i < STAT_FIELDS && *p) {
+      p += from_base64(&v[i++], p);
+      if (*p == ' ') {
+         p++;
+      }
+   }
+   while (i < STAT_FIELDS) {
+      v[i++] = 0;
+   }
+}
+
+bool is_compact_stat(const char *buf)
+{
+   return buf && *buf == COMPACT_STAT_MARK;
+}
+
+/*
+ * Convert a space separated stat packet to the compact form.
+ *  buf must be at least MAXSTRING bytes.
+ *  Returns the length of the compact packet.
+ */
+int compact_stat(char *lstat, char *buf)
+{
+   int64_t v[STAT_FIELDS];
+   char *p = buf;
+
+   if (is_compact_stat(lstat)) {
+      bstrncpy(buf, lstat, MAXSTRING);
+      return strlen(buf);
+   }
+   decode_stat_fields(lstat, v);
+   *p++ = COMPACT_STAT_MARK;
+   for (int i = 0; i < STAT_FIELDS; i++) {
+      switch (i) {
+      case 3:                         /* st_nlink */
+         p = compact_put(p, v[i] - 1);
+         break;
+      case 8:                         /* st_blksize */
+         p = compact_put(p, v[i] - 4096);
+         break;
+      case 9:                         /* st_blocks */
+         p = compact_put(p, v[i] - (v[7] + 511) / 512);
+         break;
+      case 10:                        /* st_atime */
+      case 12:                        /* st_ctime */
+         p = compact_put(p, v[i] - v[11]);
+         break;
+      default:
+         p = compact_put(p, v[i]);
+         break;
+      }
+   }
+   *p = 0;
+   return p - buf;
+}
+
+/*
+ * Return the stat packet in the space separated form for the
+ *  programs that do not know the compact form. buf must be at
+ *  least MAXSTRING bytes, it is used only when needed.
+ */
+char *uncompact_stat(char *lstat, char *buf)
+{
+   int64_t v[STAT_FIELDS];
+   char *p = buf;
+   int nb = STAT_FIELDS;
+
+   if (!is_compact_stat(lstat)) {
+      return lstat;
+   }
+   decode_compact_fields(lstat, v);
+   if (v[16] == 0) {
+      nb--;                           /* st_fattrs is sent only by Windows */
+   }
+   for (int i = 0; i < nb; i++) {
+      if (i > 0) {
+         *p++ = ' ';
+      }
+      p += to_base64(v[i], p);
+   }
+   *p = 0;
+   return buf;
+}
+
+/*
+ * Fill the stat packet from the fields of a compact packet
+ * returns: data_stream
+ */
+static int decode_compact_stat(char *buf, struct stat *statp, int32_t *LinkFI)
+{
+   int64_t v[STAT_FIELDS];
+
+   decode_compact_fields(buf, v);
+   plug(statp->st_dev, v[0]);
+   plug(statp->st_ino, v[1]);
+   plug(statp->st_mode, v[2]);
+   plug(statp->st_nlink, v[3]);
+   plug(statp->st_uid, v[4]);
+   plug(statp->st_gid, v[5]);
+   plug(statp->st_rdev, v[6]);
+   plug(statp->st_size, v[7]);
+#ifndef HAVE_MINGW
+   plug(statp->st_blksize, v[8]);
+   plug(statp->st_blocks, v[9]);
+#endif
+   plug(statp->st_atime, v[10]);
+   plug(statp->st_mtime, v[11]);
+   plug(statp->st_ctime, v[12]);
+   *LinkFI = (int32_t)v[13];
+#ifdef HAVE_CHFLAGS
+   plug(statp->st_flags, v[14]);
+#endif
+#ifdef HAVE_MINGW
+   plug(statp->st_fattrs, v[16]);
+#endif
+   return (int)v[15];
+}
+
 /*
  * Decode a stat packet from base64 characters
  * returns: data_stream
@@ -425,6 +653,10 @@ int decode_stat(char *buf, struct stat *statp, int stat_size, int32_t *LinkFI)
     */
    ASSERT(stat_size == (int)sizeof(struct stat));
 
+   if (*p == COMPACT_STAT_MARK) {
+      return decode_compact_stat(buf, statp, LinkFI);
+   }
+
    p += from_base64(&val, p);
    plug(statp->st_dev, val);
    p++;
@@ -527,6 +759,12 @@ int32_t decode_LinkFI(char *buf, struct stat *statp, int stat_size)
     */
    ASSERT(stat_size == (int)sizeof(struct stat));
 
+   if (*p == COMPACT_STAT_MARK) {
+      int32_t LinkFI;
+      decode_compact_stat(buf, statp, &LinkFI);
+      return LinkFI;
+   }
+
    skip_nonspaces(&p);                /* st_dev */
    p++;                               /* skip space */
    skip_nonspaces(&p);                /* st_ino */
@@ -574,7 +812,6 @@ int32_t decode_LinkFI(char *buf, struct stat *statp, int stat_size)
  */
 bool set_attributes(JCR *jcr, ATTR *attr, BFILE *ofd)
 {
-   mode_t old_mask;
    bool ok = true;
    boffset_t fsize;
 
@@ -610,7 +847,12 @@ bool set_attributes(JCR *jcr, ATTR *attr, BFILE *ofd)
     */
 #endif /* HAVE_WIN32 */
 
-   old_mask = umask(0);
+   /*
+    * Note, the umask is process wide and this function is called
+    *  by the restore writer threads at the same time as the job
+    *  thread creates files. chmod()/fchmod() do not use the umask,
+    *  so we must not change it here.
+    */
    if (is_bopen(ofd)) {
       char ec1[50], ec2[50];
       fsize = blseek(ofd, 0, SEEK_END);
@@ -694,7 +936,6 @@ bail_out:
       bclose(ofd);
    }
    pm_strcpy(attr->ofname, "*none*");
-   umask(old_mask);
    return ok;
 }
 
@@ -126,6 +126,8 @@ const char *stream_to_ascii(int stream)
          return _("SHA256 digest");
       case STREAM_SHA512_DIGEST:
          return _("SHA512 digest");
+      case STREAM_XXH128_DIGEST:
+         return _("XXH128 digest");
       case STREAM_SIGNED_DIGEST:
          return _("Signed digest");
       case STREAM_ENCRYPTED_FILE_DATA:
@@ -401,6 +403,7 @@ bool is_restore_stream_supported(int stream)
    case STREAM_SHA256_DIGEST:
    case STREAM_SHA512_DIGEST:
 #endif
+   case STREAM_XXH128_DIGEST:
 #ifdef HAVE_CRYPTO
    case STREAM_SIGNED_DIGEST:
    case STREAM_ENCRYPTED_FILE_DATA:
@@ -956,6 +959,7 @@ bool is_restore_stream_supported(int stream)
    case STREAM_SHA256_DIGEST:
    case STREAM_SHA512_DIGEST:
 #endif
+   case STREAM_XXH128_DIGEST:
 #ifdef HAVE_CRYPTO
    case STREAM_SIGNED_DIGEST:
    case STREAM_ENCRYPTED_FILE_DATA:
@@ -73,6 +73,7 @@ int create_file(JCR *jcr, ATTR *attr, BFILE *bfd, int replace)
    gid_t gid;
    int pnl;
    bool exists = false;
+   bool delta_part;
    struct stat mstatp;
 
    bfd->reparse_point = false;
@@ -111,10 +112,23 @@ int create_file(JCR *jcr, ATTR *attr, BFILE *bfd, int replace)
    }
 #endif
 
+   /*
+    * A part of a delta chain (e.g. changed blocks) is written over the
+    *  file restored from the previous parts. It is possible only if this
+    *  Job restored them (see restore.c), whatever the Replace option.
+    */
+   delta_part = !jcr->plugin && attr->type == FT_REG && attr->delta_seq > 0;
+   if (delta_part && !path_list_lookup(jcr, attr->ofname)) {
+      Qmsg1(jcr, M_ERROR, 0, _("Cannot restore the changed blocks of %s. "
+            "The previous parts of this file were not restored by this Job.\n"),
+            attr->ofname);
+      return CF_ERROR;
+   }
+
    Dmsg2(400, "Replace=%c %d\n", (char)replace, replace);
    if (lstat(attr->ofname, &mstatp) == 0) {
       exists = true;
-      switch (replace) {
+      switch (delta_part ? REPLACE_ALWAYS : replace) {
       case REPLACE_IFNEWER:
          /* Set attributes if we created this directory */
          if (attr->type == FT_DIREND && path_list_lookup(jcr, attr->ofname)) {
@@ -160,6 +174,27 @@ int create_file(JCR *jcr, ATTR *attr, BFILE *bfd, int replace)
        *  we may blow away a FIFO that is being used to read the
        *  restore data, or we may blow away a partition definition.
        */
+      if (delta_part) {
+         if (!exists || !S_ISREG(mstatp.st_mode)) {
+            Qmsg1(jcr, M_ERROR, 0, _("Cannot restore the changed blocks of %s. "
+                  "The file was removed or replaced during the restore.\n"), attr->ofname);
+            return CF_ERROR;
+         }
+         Dmsg2(400, "Open delta_seq=%d %s\n", attr->delta_seq, attr->ofname);
+         if (is_bopen(bfd)) {
+            Qmsg1(jcr, M_ERROR, 0, _("bpkt already open fid=%d\n"), bfd->fid);
+            bclose(bfd);
+         }
+         set_fattrs(bfd, &attr->statp);
+         if ((bopen(bfd, attr->ofname, O_WRONLY | O_BINARY, 0)) < 0) {
+            berrno be;
+            be.set_errno(bfd->berrno);
+            Qmsg2(jcr, M_ERROR, 0, _("Could not open %s: ERR=%s\n"),
+                  attr->ofname, be.bstrerror());
+            return CF_ERROR;
+         }
+         return CF_EXTRACT;
+      }
       if (exists && attr->type != FT_RAW && attr->type != FT_FIFO) {
          /* Get rid of old copy */
          Dmsg1(400, "unlink %s\n", attr->ofname);
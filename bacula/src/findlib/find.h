@@ -188,6 +188,9 @@ struct FF_PKT {
    bool null_output_device;           /* using null output device */
    bool incremental;                  /* incremental save */
    bool no_read;                      /* Do not read this file when using Plugin */
+   bool plugin_read_buf;              /* Plugin gives us its own buffers (IO_READ_BUF) */
+   struct bextent *extents;           /* Plugin gives us the ranges to read */
+   int32_t nb_extents;                /* Number of ranges in extents */
    char VerifyOpts[20];
    char AccurateOpts[20];
    char BaseJobOpts[20];
@@ -66,7 +66,8 @@ static bool path_list_init(JCR *jcr)
 }
 
 /* Add a path to the hash when we create a directory
- * with the replace=NEVER option
+ * with the replace=NEVER option, or when we restore the
+ * first part of a changed block chain
  */
 bool path_list_add(JCR *jcr, uint32_t len, char *fname)
 {
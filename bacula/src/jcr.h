@@ -150,6 +150,8 @@ struct save_pkt;
 struct bpContext;
 class HashBlockDict;
 class HashList;
+class GetMsg;
+struct RECORD_QUEUE;
 class DedupFiledInterface;
 class DedupStoredInterfaceBase;
 
@@ -240,6 +242,7 @@ public:
    dlist *msg_queue;                  /* Queued messages */
    pthread_mutex_t msg_queue_mutex;   /* message queue mutex */
    bool dequeuing_msgs;               /* Set when dequeuing messages */
+   bool queue_helper_msgs;            /* Queue the Jmsg of the other threads of the job */
    alist job_end_push;                /* Job end pushed calls */
    POOLMEM *VolumeName;               /* Volume name desired -- pool_memory */
    POOLMEM *errmsg;                   /* edited error message */
@@ -478,6 +481,10 @@ public:
    DedupFiledInterface *dedup;        /* help the FD to do deduplication */
    bool dedup_use_cache;              /* use client cache */
    VSSClient *pVSSClient;             /* VSS handler */
+   alist *cbt_pending;                /* Changed block tracking files to commit */
+   POOLMEM *accurate_data;            /* File data read by the accurate checksum */
+   int32_t accurate_data_len;         /* Length of the data, 0 if none */
+   ino_t accurate_data_ino;           /* Inode of the file read */
 #endif /* FILE_DAEMON */
 
 
@@ -493,6 +500,9 @@ public:
    DCR *read_dcr;                     /* device context for reading */
    DCR *dcr;                          /* device context record */
    alist *dcrs;                       /* list of dcrs open */
+   GetMsg *qfd;                       /* messages read from the FD during append */
+   RECORD_QUEUE *read_queue;          /* records read ahead during a Virtual Full */
+   pthread_mutex_t *dir_mutex;        /* Director exchanges shared with a helper thread */
    POOLMEM *job_name;                 /* base Job name (not unique) */
    POOLMEM *fileset_name;             /* FileSet */
    POOLMEM *fileset_md5;              /* MD5 for FileSet */
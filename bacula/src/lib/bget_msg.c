@@ -166,3 +166,271 @@ int GetMsg::bget_msg(bmessage **pbmsg)
    m_is_stop = bsock->is_stop() || bsock->is_error();
    return bmsg->ret;
 }
+
+/* Messages smaller than this are copied into a small buffer */
+#define BUFMSG_SMALL_SIZE  1024
+#define BUFMSG_RING_SIZE   16384
+
+BufferedMsg::BufferedMsg(JCR *a_jcr, BSOCK *a_bsock, const char *a_rec_header,
+                         int32_t a_bufsize, int32_t a_max_bytes):
+      GetMsg(a_jcr, a_bsock, a_rec_header, a_bufsize),
+      m_thread_started(false),
+      m_quit(false),
+      m_max_bytes(a_max_bytes),
+      m_bytes(0),
+      m_first(0),
+      m_count(0),
+      m_current(NULL),
+      m_full_waits(0),
+      m_empty_waits(0),
+      m_max_used(0)
+{
+   m_ring = (bmessage **)malloc(BUFMSG_RING_SIZE * sizeof(bmessage *));
+   m_free_small = New(alist(10, not_owned_by_alist));
+   m_free_large = New(alist(10, not_owned_by_alist));
+}
+
+BufferedMsg::~BufferedMsg()
+{
+   bmessage *m;
+
+   wait_read_sock(true);
+   while (m_count > 0) {
+      delete m_ring[m_first];
+      m_first = (m_first + 1) % BUFMSG_RING_SIZE;
+      m_count--;
+   }
+   free(m_ring);
+   while ((m = (bmessage *)m_free_small->pop()) != NULL) {
+      delete m;
+   }
+   while ((m = (bmessage *)m_free_large->pop()) != NULL) {
+      delete m;
+   }
+   delete m_free_small;
+   delete m_free_large;
+   if (m_current) {
+      delete m_current;
+   }
+}
+
+extern "C" void *bufmsg_read_thread(void *arg)
+{
+   BufferedMsg *qfd = (BufferedMsg *)arg;
+   return qfd->do_read_sock_thread();
+}
+
+int BufferedMsg::start_read_sock()
+{
+   int stat;
+
+   if ((stat = pthread_create(&m_thread, NULL, bufmsg_read_thread, (void *)this)) != 0) {
+      berrno be;
+      Jmsg1(jcr, M_WARNING, 0, _("Cannot start the network read thread. ERR=%s\n"),
+            be.bstrerror(stat));
+      return stat;              /* bget_msg() will read the socket itself */
+   }
+   m_thread_started = true;
+   return 0;
+}
+
+/*
+ * Read the messages from the socket and queue them until the
+ *  final EOD, an error, or until we are asked to quit.
+ */
+void *BufferedMsg::do_read_sock_thread()
+{
+   bmessage *m;
+   bool header = true;          /* next message is a stream header */
+   bool last, quit, small;
+   int32_t size;
+
+   set_jcr_in_tsd(jcr);
+   for (;;) {
+      P(mutex);
+      while (!m_quit && (m_count == BUFMSG_RING_SIZE || m_bytes >= m_max_bytes)) {
+         m_full_waits++;
+         pthread_cond_wait(&cond, &mutex);
+      }
+      quit = m_quit;
+      V(mutex);
+      if (quit) {
+         break;
+      }
+
+      bsock->msglen = 0;
+      int ret = ::bget_msg(bsock);
+
+      /* Small messages and signals are copied, the others get the socket buffer */
+      small = bsock->msglen < BUFMSG_SMALL_SIZE;
+      P(mutex);
+      if (small) {
+         m = (bmessage *)m_free_small->pop();
+      } else {
+         m = (bmessage *)m_free_large->pop();
+      }
+      V(mutex);
+      if (small) {
+         if (!m) {
+            m = New(bmessage(BUFMSG_SMALL_SIZE + 1));
+         }
+         if (bsock->msglen > 0) {
+            memcpy(m->msg, bsock->msg, bsock->msglen + 1);
+         } else {
+            m->msg[0] = 0;
+         }
+      } else {
+         if (!m) {
+            m = new_msg();
+         }
+         m->swap(bsock);
+      }
+      m->ret = ret;
+      m->status = bmessage::bm_ready;
+      m->rbuflen = m->msglen = m->origlen = bsock->msglen;
+      m->rbuf = m->msg;
+      m->jobbytes = 0;
+      m->dedup_size = 0;
+
+      /* Follow the session to know when the other side is done */
+      last = false;
+      if (ret > 0) {
+         header = false;
+      } else if (!header && (ret == 0 || (ret == BNET_SIGNAL && bsock->msglen == BNET_EOD))) {
+         header = true;
+      } else {
+         last = true;           /* final EOD, error or unexpected signal */
+      }
+
+      size = sizeof_pool_memory(m->msg);
+      P(mutex);
+      m_ring[(m_first + m_count) % BUFMSG_RING_SIZE] = m;
+      m_count++;
+      m_bytes += size;
+      if (m_bytes > m_max_used) {
+         m_max_used = m_bytes;
+      }
+      if (last) {
+         m_is_stop = bsock->is_stop() || bsock->is_error();
+         m_is_done = true;
+      }
+      pthread_cond_broadcast(&cond);
+      V(mutex);
+      if (last) {
+         break;
+      }
+   }
+   P(mutex);
+   m_is_done = true;
+   pthread_cond_broadcast(&cond);
+   V(mutex);
+   return NULL;
+}
+
+/*
+ * Return the next message read by the thread, the message
+ *  returned by the previous call is recycled.
+ */
+int BufferedMsg::bget_msg(bmessage **pbmsg)
+{
+   bmessage *m;
+   struct timespec to;
+   bool waited = false;
+
+   if (!m_thread_started || pbmsg) {
+      return GetMsg::bget_msg(pbmsg);
+   }
+   P(mutex);
+   if (m_current) {
+      if (sizeof_pool_memory(m_current->msg) <= BUFMSG_SMALL_SIZE + 1) {
+         m_free_small->append(m_current);
+      } else {
+         m_free_large->append(m_current);
+      }
+      m_current = NULL;
+   }
+   while (m_count == 0 && !m_is_done) {
+      if (jcr->is_job_canceled()) {
+         break;
+      }
+      if (!waited) {
+         m_empty_waits++;
+         waited = true;
+      }
+      to.tv_sec = time(NULL) + 1;
+      to.tv_nsec = 0;
+      pthread_cond_timedwait(&cond, &mutex, &to);
+   }
+   if (m_count == 0) {
+      V(mutex);
+      bmsg = bmsg_aux;
+      bmsg->ret = BNET_HARDEOF;
+      msg = bmsg->msg;
+      msglen = 0;
+      m_is_stop = true;
+      return BNET_HARDEOF;
+   }
+   m = m_ring[m_first];
+   m_first = (m_first + 1) % BUFMSG_RING_SIZE;
+   m_count--;
+   m_bytes -= sizeof_pool_memory(m->msg);
+   pthread_cond_broadcast(&cond);
+   V(mutex);
+
+   m_current = bmsg = m;
+   msglen = m->msglen;
+   msg = m->msg;
+   return m->ret;
+}
+
+int BufferedMsg::get_status(POOLMEM *&buf)
+{
+   char b1[50], b2[50], b3[50];
+   int len;
+
+   P(mutex);
+   len = Mmsg(buf, _("    NetQueue: Bytes=%s MaxUsed=%s Limit=%s FullWaits=%u EmptyWaits=%u\n"),
+              edit_uint64_with_commas(m_bytes, b1),
+              edit_uint64_with_commas(m_max_used, b2),
+              edit_uint64_with_commas(m_max_bytes, b3),
+              m_full_waits, m_empty_waits);
+   V(mutex);
+   return len;
+}
+
+/*
+ * Wait for the end of the read thread. With emergency_quit, the
+ *  thread is stopped even if the other side did not send all its
+ *  data, the read in progress is interrupted.
+ */
+void *BufferedMsg::wait_read_sock(int emergency_quit)
+{
+   struct timespec to;
+
+   if (!m_thread_started) {
+      return NULL;
+   }
+   P(mutex);
+   if (emergency_quit) {
+      m_quit = true;
+   }
+   pthread_cond_broadcast(&cond);
+   while (!m_is_done) {
+      if (m_quit) {
+         bsock->set_timed_out();
+         pthread_kill(m_thread, TIMEOUT_SIGNAL);
+      }
+      to.tv_sec = time(NULL) + 1;
+      to.tv_nsec = 0;
+      pthread_cond_timedwait(&cond, &mutex, &to);
+   }
+   V(mutex);
+   pthread_join(m_thread, NULL);
+   m_thread_started = false;
+   if (emergency_quit) {
+      bsock->clear_timed_out();
+   }
+   Dmsg4(100, "Network read queue: max_used=%d full_waits=%u empty_waits=%u quit=%d\n",
+         m_max_used, m_full_waits, m_empty_waits, m_quit);
+   return NULL;
+}
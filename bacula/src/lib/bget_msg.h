@@ -109,6 +109,9 @@ public:
 
    bmessage *new_msg() { return New(bmessage(bufsize)); };
 
+   /* used by the status command, returns the length of the text in buf */
+   virtual int get_status(POOLMEM *&/*buf*/) { return 0; };
+
    /* used by inherited classes to commit any pending operations at the end */
    virtual int commit(POOLMEM *&/*errmsg*/, uint32_t /*jobid*/) { return 0; };
 
@@ -119,6 +122,44 @@ public:
 
 };
 
+/*
+ * GetMsg with a thread that reads the messages of an append session
+ *  (stream header, data, EOD for each stream, then a final EOD) ahead
+ *  of the consumer, so the socket is drained while the consumer writes
+ *  to the device. The thread waits when the messages waiting in the
+ *  queue use more than max_bytes of memory.
+ */
+class BufferedMsg: public GetMsg
+{
+public:
+   pthread_t m_thread;
+   bool m_thread_started;
+   bool m_quit;                   /* set to stop the read thread */
+   int32_t m_max_bytes;           /* memory limit of the queue */
+   int32_t m_bytes;               /* memory used by the queue */
+   bmessage **m_ring;             /* messages read, not yet consumed */
+   int32_t m_first;
+   int32_t m_count;
+   alist *m_free_small;           /* consumed messages to reuse */
+   alist *m_free_large;
+   bmessage *m_current;           /* message returned by bget_msg() */
+
+   /* Statistics */
+   uint32_t m_full_waits;         /* read thread waited for the consumer */
+   uint32_t m_empty_waits;        /* consumer waited for the read thread */
+   int32_t m_max_used;            /* highest memory used by the queue */
+
+   BufferedMsg(JCR *a_jcr, BSOCK *a_bsock, const char *a_rec_header,
+               int32_t a_bufsize, int32_t a_max_bytes);
+   virtual ~BufferedMsg();
+
+   virtual int bget_msg(bmessage **pbmsg=NULL);
+   virtual void *do_read_sock_thread(void);
+   virtual int start_read_sock();
+   virtual void *wait_read_sock(int emergency_quit);
+   virtual int get_status(POOLMEM *&buf);
+};
+
 /* Call this function to release the memory associated with the message queue
  * The reading thread is using the BufferedMsgBase to work, so we need to free
  * the memory only when the main thread and the reading thread agree
@@ -37,6 +37,9 @@
 #include "lz4.h"
 #include <netdb.h>
 #include <netinet/tcp.h>
+#ifndef HAVE_WIN32
+#include <sys/uio.h>
+#endif
 
 #define BSOCK_DEBUG_LVL    900
 
@@ -100,6 +103,9 @@ void BSOCK::init()
    timeout = BSOCK_TIMEOUT;
    m_spool_fd = NULL;
    cmsg = get_pool_memory(PM_BSOCK);
+   m_wbuf = NULL;
+   m_wbuf_len = 0;
+   m_coalesce = 0;
 }
 
 /*
@@ -112,6 +118,10 @@ void BSOCK::_destroy()
       free_pool_memory(cmsg);
       cmsg = NULL;
    }
+   if (m_wbuf) {
+      free_pool_memory(m_wbuf);
+      m_wbuf = NULL;
+   }
 };
 
 #if 0
@@ -369,8 +379,12 @@ bool BSOCK::send(int aflags)
    /* send data packet */
    timer_start = watchdog_time;  /* start timer */
    clear_timed_out();
-   /* Full I/O done in one write */
-   rc = write_nbytes((char *)hdrptr, pktsiz);
+   /* Full I/O done in one write, or kept with the next messages */
+   if (m_coalesce > 0 && !is_spooling()) {
+      rc = coalesce((char *)hdrptr, pktsiz);
+   } else {
+      rc = write_nbytes((char *)hdrptr, pktsiz);
+   }
    if (chk_dbglvl(DT_NETWORK|1900)) dump_bsock_msg(m_fd, *pout_msg_no, "SEND", rc, msglen, m_flags, save_msg, save_msglen);
    timer_start = 0;         /* clear timer */
    if (rc != pktsiz) {
@@ -439,6 +453,10 @@ int32_t BSOCK::recv()
    if (errors || is_terminated() || is_closed()) {
       return BNET_HARDEOF;
    }
+   /* The other end may be waiting for what we kept before answering */
+   if (m_wbuf_len > 0 && !flush()) {
+      return BNET_HARDEOF;
+   }
    if (m_use_locking) {
       pP(pm_rmutex);
       locked = true;
@@ -810,6 +828,10 @@ bool BSOCK::comm_compress()
 void BSOCK::close()
 {
    Dmsg1(BSOCK_DEBUG_LVL, "0x%p BSOCK::close()\n", this);
+   if (m_wbuf_len > 0 && !is_closed() && !errors) {
+      flush();
+   }
+   m_wbuf_len = 0;
    BSOCKCORE::close();
    return;
 }
@@ -841,6 +863,155 @@ int32_t BSOCK::write_nbytes(char *ptr, int32_t nbytes)
    return BSOCKCORE::write_nbytes(ptr, nbytes);
 }
 
+/*
+ * Write two buffers to the network, with a single writev() when
+ *  the connection is not encrypted.
+ */
+int32_t BSOCK::write_vnbytes(char *ptr1, int32_t nbytes1, char *ptr2, int32_t nbytes2)
+{
+#ifndef HAVE_WIN32
+   struct iovec iov[2], *v = iov;
+   int cnt = 2;
+   int32_t nleft, nwritten;
+
+   if (tls == NULL && !is_spooling()) {
+      iov[0].iov_base = ptr1;
+      iov[0].iov_len = nbytes1;
+      iov[1].iov_base = ptr2;
+      iov[1].iov_len = nbytes2;
+      nleft = nbytes1 + nbytes2;
+      while (nleft > 0) {
+         do {
+            errno = 0;
+            nwritten = writev(m_fd, v, cnt);
+            if (is_timed_out() || is_terminated()) {
+               return -1;
+            }
+         } while (nwritten == -1 && errno == EINTR);
+         /* Non-blocking connection, wait and try again */
+         if (nwritten == -1 && errno == EAGAIN) {
+            fd_wait_data(m_fd, WAIT_WRITE, 1, 0);
+            continue;
+         }
+         if (nwritten <= 0) {
+            return -1;                /* error */
+         }
+         nleft -= nwritten;
+         if (use_bwlimit()) {
+            control_bwlimit(nwritten);
+         }
+         /* Skip what was written */
+         while (cnt > 0 && nwritten >= (int32_t)v->iov_len) {
+            nwritten -= v->iov_len;
+            v++;
+            cnt--;
+         }
+         if (cnt > 0) {
+            v->iov_base = (char *)v->iov_base + nwritten;
+            v->iov_len -= nwritten;
+         }
+      }
+      return nbytes1 + nbytes2;
+   }
+#endif
+   if (write_nbytes(ptr1, nbytes1) != nbytes1) {
+      return -1;
+   }
+   if (write_nbytes(ptr2, nbytes2) != nbytes2) {
+      return -1;
+   }
+   return nbytes1 + nbytes2;
+}
+
+/*
+ * Keep a packet in the coalescing buffer. When it does not fit,
+ *  the buffer and the packet are written together.
+ * Called with the write lock held.
+ *  Returns: nbytes on success
+ *           -1 on error
+ */
+int32_t BSOCK::coalesce(char *ptr, int32_t nbytes)
+{
+   int32_t len = m_wbuf_len;
+
+   if (len + nbytes <= m_coalesce) {
+      memcpy(m_wbuf + len, ptr, nbytes);
+      m_wbuf_len += nbytes;
+      return nbytes;
+   }
+   if (len == 0) {
+      return write_nbytes(ptr, nbytes);
+   }
+   m_wbuf_len = 0;
+   if (write_vnbytes(m_wbuf, len, ptr, nbytes) != len + nbytes) {
+      return -1;
+   }
+   return nbytes;
+}
+
+/*
+ * Write the coalescing buffer. Called with the write lock held.
+ */
+bool BSOCK::flush_wbuf()
+{
+   int32_t rc, len = m_wbuf_len;
+
+   if (len == 0) {
+      return true;
+   }
+   m_wbuf_len = 0;
+   timer_start = watchdog_time;  /* start timer */
+   clear_timed_out();
+   rc = write_nbytes(m_wbuf, len);
+   timer_start = 0;         /* clear timer */
+   if (rc != len) {
+      errors++;
+      b_errno = errno ? errno : EIO;
+      if (!m_suppress_error_msgs) {
+         Qmsg5(m_jcr, M_ERROR, 0,
+               _("Write error sending %d bytes to %s:%s:%d: ERR=%s\n"),
+               len, m_who, m_host, m_port, this->bstrerror());
+      }
+      return false;
+   }
+   return true;
+}
+
+/*
+ * Write the messages kept by the coalescing mode
+ *  Returns: false on failure
+ *           true  on success
+ */
+bool BSOCK::flush()
+{
+   bool ok;
+
+   if (m_use_locking) pP(pm_wmutex);
+   ok = flush_wbuf();
+   if (m_use_locking) pV(pm_wmutex);
+   return ok;
+}
+
+/*
+ * With a size > 0, the small messages sent are kept in a buffer of
+ *  that size and written together when the buffer is full, on flush(),
+ *  before a recv() and when the socket is closed. A size of 0 writes
+ *  the buffer and turns the mode off.
+ */
+void BSOCK::set_coalescing(int32_t size)
+{
+   if (m_use_locking) pP(pm_wmutex);
+   flush_wbuf();
+   if (size > 0) {
+      if (!m_wbuf) {
+         m_wbuf = get_pool_memory(PM_BSOCK);
+      }
+      m_wbuf = check_pool_memory_size(m_wbuf, size);
+   }
+   m_coalesce = size;
+   if (m_use_locking) pV(pm_wmutex);
+}
+
 /*
  * This is a non-class BSOCK "constructor"  because we want to
  *   call the Bacula smartalloc routines instead of new.
@@ -888,6 +1059,10 @@ BSOCK *dup_bsock(BSOCK *osock)
    bsock->msg = msg;
    bsock->cmsg = cmsg;
    bsock->errmsg = errmsg;
+   /* The coalescing buffer belongs to the original */
+   bsock->m_wbuf = NULL;
+   bsock->m_wbuf_len = 0;
+   bsock->m_coalesce = 0;
    if (osock->who()) {
       bsock->set_who(bstrdup(osock->who()));
    }
@@ -961,6 +1136,46 @@ int main()
    ok(bs != NULL && bs->jcr() == jcr,
          "Default initialization");
 
+   /* Coalescing mode, the messages are kept until the buffer is full */
+   int sv[2];
+   if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == 0) {
+      BSOCK *cs = New(BSOCK(sv[0]));
+      char rbuf[4096];
+      int32_t len = strlen(data);
+      cs->set_jcr(jcr);
+      cs->set_coalescing(1024);
+      ok(cs->is_coalescing(), "Coalescing mode set");
+      for (int i = 0; i < 10; i++) {
+         cs->fsend("%s", data);
+      }
+      fcntl(sv[1], F_SETFL, O_NONBLOCK);
+      rc = read(sv[1], rbuf, sizeof(rbuf));
+      ok(rc < 0 && errno == EAGAIN, "Messages kept in the buffer");
+      ok(cs->flush(), "Flush the buffer");
+      rc = read(sv[1], rbuf, sizeof(rbuf));
+      ok(rc == 10 * (len + 4), "All messages written by flush");
+      ok(ntohl(*(int32_t *)(rbuf + 9 * (len + 4))) == (uint32_t)len &&
+         memcmp(rbuf + 9 * (len + 4) + 4, data, len) == 0, "Message framing");
+
+      /* A message larger than the buffer is written with the pending ones */
+      cs->fsend("%s", data);
+      cs->msg = check_pool_memory_size(cs->msg, 2000);
+      memset(cs->msg, 'a', 1500);
+      cs->msglen = 1500;
+      ok(cs->send(), "Send a large message");
+      rc = read(sv[1], rbuf, sizeof(rbuf));
+      ok(rc == len + 4 + 1500 + 4 && rbuf[rc - 1] == 'a', "Large message written at once");
+
+      cs->signal(BNET_EOD);
+      cs->set_coalescing(0);
+      rc = read(sv[1], rbuf, sizeof(rbuf));
+      ok(rc == 4 && (int32_t)ntohl(*(int32_t *)rbuf) == BNET_EOD, "Buffer written when turned off");
+      ok(!cs->is_coalescing(), "Coalescing mode cleared");
+      cs->close();
+      delete cs;
+      close(sv[1]);
+   }
+
    Pmsg0(0, "Preparing fork\n");
    pid = fork();
    if (0 == pid){
@@ -48,6 +48,9 @@ class BSOCK: public BSOCKCORE {
 public:
    FILE *m_spool_fd;                  /* spooling file */
    POOLMEM *cmsg;                     /* Compress buffer */
+   POOLMEM *m_wbuf;                   /* messages waiting to be written */
+   int32_t m_wbuf_len;                /* bytes in m_wbuf */
+   int32_t m_coalesce;                /* coalescing buffer size, 0 if off */
                                       /* tlspsk_XX are not always used */
    int tlspsk_local;                  /* the "tlspsk=%d" to send via the hello */
    int tlspsk_remote;                 /* the "tlspsk=%d" received from the hello */
@@ -68,6 +71,9 @@ private:
    void init();
    void _destroy();
    int32_t write_nbytes(char *ptr, int32_t nbytes);
+   int32_t write_vnbytes(char *ptr1, int32_t nbytes1, char *ptr2, int32_t nbytes2);
+   int32_t coalesce(char *ptr, int32_t nbytes);
+   bool flush_wbuf();
 
 public:
    BSOCK();
@@ -81,6 +87,8 @@ public:
    void close();              /* close connection and destroy packet */
    bool comm_compress();               /* in bsock.c */
    bool despool(void update_attr_spool_size(ssize_t size), ssize_t tsize);
+   void set_coalescing(int32_t size);  /* in bsock.c */
+   bool flush();                       /* in bsock.c */
 #if 0
    bool authenticate_director(const char *name, const char *password,
            TLS_CONTEXT *tls_ctx, char *response, int response_len);
@@ -88,6 +96,7 @@ public:
 
    /* Inline functions */
    bool is_spooling() const { return m_spool; };
+   bool is_coalescing() const { return m_coalesce > 0; };
    bool can_compress() const { return m_compress; };
    void set_data_end(int32_t FileIndex) {
           if (m_spool && FileIndex > m_FileIndex) {
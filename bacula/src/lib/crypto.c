@@ -276,6 +276,7 @@ struct Digest {
    crypto_digest_t type;
    JCR *jcr;
    EVP_MD_CTX *ctx;
+   XXH128Context *xxh128;       /* XXH128 is not provided by OpenSSL */
 };
 
 /* Message Signature Structure */
@@ -599,8 +600,16 @@ DIGEST *crypto_digest_new(JCR *jcr, crypto_digest_t type)
    digest = (DIGEST *)malloc(sizeof(DIGEST));
    digest->type = type;
    digest->jcr = jcr;
+   digest->xxh128 = NULL;
    Dmsg1(150, "crypto_digest_new jcr=%p\n", jcr);
 
+   if (type == CRYPTO_DIGEST_XXH128) {
+      digest->ctx = NULL;
+      digest->xxh128 = (XXH128Context *)malloc(sizeof(XXH128Context));
+      XXH128Init(digest->xxh128);
+      return digest;
+   }
+
    /* Initialize the OpenSSL message digest context */
    digest->ctx = EVP_MD_CTX_new();
    if (!digest->ctx) {
@@ -651,6 +660,10 @@ err:
  */
 bool crypto_digest_update(DIGEST *digest, const uint8_t *data, uint32_t length)
 {
+   if (digest->xxh128) {
+      XXH128Update(digest->xxh128, data, length);
+      return true;
+   }
    if (EVP_DigestUpdate(digest->ctx, data, length) == 0) {
       Dmsg0(150, "digest update failed\n");
       openssl_post_errors(digest->jcr, M_ERROR, _("OpenSSL digest update failed"));
@@ -669,6 +682,12 @@ bool crypto_digest_update(DIGEST *digest, const uint8_t *data, uint32_t length)
  */
 bool crypto_digest_finalize(DIGEST *digest, uint8_t *dest, uint32_t *length)
 {
+   if (digest->xxh128) {
+      assert(*length >= CRYPTO_DIGEST_XXH128_SIZE);
+      *length = CRYPTO_DIGEST_XXH128_SIZE;
+      XXH128Final(digest->xxh128, dest);
+      return true;
+   }
    if (!EVP_DigestFinal(digest->ctx, dest, (unsigned int *)length)) {
       Dmsg0(150, "digest finalize failed\n");
       openssl_post_errors(digest->jcr, M_ERROR, _("OpenSSL digest finalize failed"));
@@ -683,7 +702,12 @@ bool crypto_digest_finalize(DIGEST *digest, uint8_t *dest, uint32_t *length)
  */
 void crypto_digest_free(DIGEST *digest)
 {
-  EVP_MD_CTX_free(digest->ctx);
+  if (digest->ctx) {
+     EVP_MD_CTX_free(digest->ctx);
+  }
+  if (digest->xxh128) {
+     free(digest->xxh128);
+  }
   free(digest);
 }
 
@@ -1385,6 +1409,7 @@ struct Digest {
    union {
       SHA1Context sha1;
       MD5Context md5;
+      XXH128Context xxh128;
    };
 };
 
@@ -1408,6 +1433,9 @@ DIGEST *crypto_digest_new(JCR *jcr, crypto_digest_t type)
    case CRYPTO_DIGEST_SHA1:
       SHA1Init(&digest->sha1);
       break;
+   case CRYPTO_DIGEST_XXH128:
+      XXH128Init(&digest->xxh128);
+      break;
    default:
       Jmsg1(jcr, M_ERROR, 0, _("Unsupported digest type=%d specified\n"), type);
       free(digest);
@@ -1433,6 +1461,9 @@ bool crypto_digest_update(DIGEST *digest, const uint8_t *data, uint32_t length)
          return false;
       }
       break;
+   case CRYPTO_DIGEST_XXH128:
+      XXH128Update(&digest->xxh128, data, length);
+      return true;
    default:
       return false;
    }
@@ -1460,6 +1491,11 @@ bool crypto_digest_finalize(DIGEST *digest, uint8_t *dest, uint32_t *length)
          return false;
       }
       break;
+   case CRYPTO_DIGEST_XXH128:
+      assert(*length >= CRYPTO_DIGEST_XXH128_SIZE);
+      *length = CRYPTO_DIGEST_XXH128_SIZE;
+      XXH128Final(&digest->xxh128, dest);
+      return true;
    default:
       return false;
    }
@@ -1533,6 +1569,8 @@ const char *crypto_digest_name(DIGEST *digest)
       return "SHA256";
    case CRYPTO_DIGEST_SHA512:
       return "SHA512";
+   case CRYPTO_DIGEST_XXH128:
+      return "XXH128";
    case CRYPTO_DIGEST_NONE:
       return "None";
    default:
@@ -1556,6 +1594,8 @@ crypto_digest_t crypto_digest_stream_type(int stream)
       return CRYPTO_DIGEST_SHA256;
    case STREAM_SHA512_DIGEST:
       return CRYPTO_DIGEST_SHA512;
+   case STREAM_XXH128_DIGEST:
+      return CRYPTO_DIGEST_XXH128;
    default:
       return CRYPTO_DIGEST_NONE;
    }
@@ -58,6 +58,7 @@
 #endif
 #include "md5.h"
 #include "sha1.h"
+#include "xxh128.h"
 #include "tree.h"
 #include "watchdog.h"
 #include "btimers.h"
@@ -1550,8 +1550,12 @@ Jmsg(JCR *jcr, int type, utime_t mtime, const char *fmt,...)
        return;
     }
 
-    /* The watchdog thread can't use Jmsg directly, we always queued it */
-    if (is_watchdog()) {
+    /* The watchdog thread can't use Jmsg directly, we always queued it.
+     *  The same for the helper threads of a job when the job thread
+     *  is talking to the Director at the same time.
+     */
+    if (is_watchdog() || (jcr && jcr->queue_helper_msgs &&
+                          !pthread_equal(pthread_self(), jcr->my_thread_id))) {
        va_start(arg_ptr, fmt);
        bvsnprintf(rbuf,  sizeof(rbuf), fmt, arg_ptr);
        va_end(arg_ptr);
@@ -1798,6 +1802,7 @@ void Qmsg(JCR *jcr, int type, utime_t mtime, const char *fmt,...)
    int len, maxlen;
    POOLMEM *pool_buf;
    MQUEUE_ITEM *item, *last_item;
+   bool helper;
 
    pool_buf = get_pool_memory(PM_EMSG);
 
@@ -1824,6 +1829,9 @@ void Qmsg(JCR *jcr, int type, utime_t mtime, const char *fmt,...)
    if (jcr && type==M_FATAL) {
       jcr->setJobStatus(JS_FatalError);
     }
+   /* A helper thread of the job waits for the end of the dequeuing */
+   helper = jcr && jcr->queue_helper_msgs &&
+            !pthread_equal(pthread_self(), jcr->my_thread_id);
 
    /* Display the message in trace if it's important, we may not
     * have the director connection for a long time
@@ -1831,7 +1839,7 @@ void Qmsg(JCR *jcr, int type, utime_t mtime, const char *fmt,...)
    Dmsg1((type == M_ERROR || type == M_FATAL) ? 0 : 50, "%s", item->msg);
 
    /* If no jcr or no queue or dequeuing send to syslog */
-   if (!jcr || !jcr->msg_queue || jcr->dequeuing_msgs) {
+   if (!jcr || !jcr->msg_queue || (jcr->dequeuing_msgs && !helper)) {
       syslog(LOG_DAEMON|LOG_ERR, "%s", item->msg);
       if (!dequeuing_daemon_msgs) { /* Avoid recursion with self generated network errors */
          P(daemon_msg_queue_mutex);
@@ -376,6 +376,7 @@ void             free_tls_connection     (TLS_CONNECTION *tls);
 bool             get_tls_require         (TLS_CONTEXT *ctx);
 bool             get_tls_enable          (TLS_CONTEXT *ctx);
 bool             get_tls_psk_context     (TLS_CONTEXT *ctx);
+bool             set_tls_kernel_offload  (TLS_CONTEXT *ctx, bool enable);
 
 
 /* util.c */
@@ -473,6 +473,31 @@ bool get_tls_enable(TLS_CONTEXT *ctx)
    return ctx->tls_enable;
 }
 
+/*
+ * Ask OpenSSL to hand the record encryption of the connections of this
+ *  context to the kernel (Linux kTLS) once the handshake is done.
+ *  A connection stays in userspace when the kernel or the negotiated
+ *  cipher cannot do it, SSL_read() and SSL_write() work in both cases.
+ *
+ *  Returns: true if this OpenSSL knows about kTLS
+ *           false otherwise
+ */
+bool set_tls_kernel_offload(TLS_CONTEXT *ctx, bool enable)
+{
+#ifdef SSL_OP_ENABLE_KTLS
+   if (ctx) {
+      if (enable) {
+         SSL_CTX_set_options(ctx->openssl, SSL_OP_ENABLE_KTLS);
+      } else {
+         SSL_CTX_clear_options(ctx->openssl, SSL_OP_ENABLE_KTLS);
+      }
+   }
+   return true;
+#else
+   return false;
+#endif
+}
+
 
 /*
  * Verifies a list of common names against the certificate
@@ -735,6 +760,14 @@ static inline bool openssl_bsock_session_start(BSOCK *bsock, bool server)
       switch (SSL_get_error(tls->openssl, err)) {
       case SSL_ERROR_NONE:
          stat = true;
+#ifdef SSL_OP_ENABLE_KTLS
+         if (SSL_get_options(tls->openssl) & SSL_OP_ENABLE_KTLS) {
+            Dmsg3(DT_NETWORK|50, "kTLS send=%d recv=%d with %s\n",
+                  BIO_get_ktls_send(SSL_get_wbio(tls->openssl)) ? 1 : 0,
+                  BIO_get_ktls_recv(SSL_get_rbio(tls->openssl)) ? 1 : 0,
+                  bsock->who());
+         }
+#endif
          goto cleanup;
       case SSL_ERROR_ZERO_RETURN:
          /* TLS connection was cleanly shut down */
@@ -1012,6 +1045,11 @@ bool get_tls_enable(TLS_CONTEXT *ctx)
    return false;
 }
 
+bool set_tls_kernel_offload(TLS_CONTEXT *ctx, bool enable)
+{
+   return false;
+}
+
 TLS_CONTEXT *new_psk_context(const char *unused_shared_key)
 {
    (void)unused_shared_key;
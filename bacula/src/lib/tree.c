@@ -31,10 +31,17 @@
 #define MAX_PAGES 2400
 #define MAX_BUF_SIZE (MAX_PAGES * B_PAGE_SIZE)  /* approx 10MB */
 
+/* Delta parts of a node, kept in root->deltas */
+struct s_delta_entry {
+   hlink link;
+   struct delta_list *list;
+};
+
 /* Forward referenced subroutines */
 static TREE_NODE *search_and_insert_tree_node(char *fname, int type,
                TREE_ROOT *root, TREE_NODE *parent);
 static char *tree_alloc(TREE_ROOT *root, int size);
+static char *tree_intern_name(TREE_ROOT *root, const char *fname);
 
 /*
  * NOTE !!!!! we turn off Debug messages for performance reasons.
@@ -65,16 +72,60 @@ static void malloc_buf(TREE_ROOT *root, int size)
    Dmsg2(200, "malloc buf size=%d rem=%d\n", size, mem->rem);
 }
 
+/* Smallest power of 2 above count, used to size the hash tables */
+static uint32_t tree_hash_size(uint64_t count)
+{
+   uint32_t size = 1024;
+   while (size < count && size < 0x80000000) {
+      size <<= 1;
+   }
+   return size;
+}
+
+/*
+ * Create a new tree node. The nodes are allocated by chunks
+ *  of TREE_CHUNK_NODES, this runs much faster than using
+ *  malloc() for each of the nodes.
+ */
+static TREE_NODE *new_tree_node(TREE_ROOT *root)
+{
+   TREE_NODE *node;
+   uint32_t index = root->nb_nodes;
+   uint32_t chunk = index >> TREE_CHUNK_BITS;
+
+   if (chunk >= root->nb_chunks) {
+      if (root->nb_chunks == root->max_chunks) {
+         root->max_chunks = root->max_chunks ? root->max_chunks * 2 : 16;
+         root->chunks = (struct s_tree_chunk **)realloc(root->chunks,
+                                root->max_chunks * sizeof(struct s_tree_chunk *));
+      }
+      root->chunks[chunk] = (struct s_tree_chunk *)malloc(sizeof(struct s_tree_chunk));
+      bmemset(root->chunks[chunk]->extract, 0, sizeof(root->chunks[chunk]->extract));
+      bmemset(root->chunks[chunk]->extract_dir, 0, sizeof(root->chunks[chunk]->extract_dir));
+      root->total_size += sizeof(struct s_tree_chunk);
+      root->blocks++;
+      root->nb_chunks++;
+   }
+   root->nb_nodes++;
+   node = tree_node(root, index);
+   bmemset(node, 0, sizeof(TREE_NODE));
+   node->index = index;
+   node->delta_seq = -1;
+   node->can_access = 1;
+   tree_set_extract(root, node, false);
+   tree_set_extract_dir(root, node, false);
+   return node;
+}
 
 /*
  * Note, we allocate a big buffer in the tree root
- *  from which we allocate nodes. This runs more
- *  than 100 times as fast as directly using malloc()
- *  for each of the nodes.
+ *  from which we allocate the file names and the
+ *  delta parts.
  */
 TREE_ROOT *new_tree(int count)
 {
    TREE_ROOT *root;
+   TREE_NODE *node;
    uint32_t size;
 
    if (count < 1000) {                /* minimum tree size */
@@ -82,84 +133,191 @@ TREE_ROOT *new_tree(int count)
    }
    root = (TREE_ROOT *)malloc(sizeof(TREE_ROOT));
    bmemset(root, 0, sizeof(TREE_ROOT));
-   /* Assume filename + node  = 40 characters average length */
-   size = count * (BALIGN(sizeof(TREE_NODE)) + 40);
+   /* Assume 20 characters per file name, many of them are shared */
+   size = count * 20;
    if (count > 1000000 || size > (MAX_BUF_SIZE / 2)) {
       size = MAX_BUF_SIZE;
    }
    Dmsg2(400, "count=%d size=%d\n", count, size);
    malloc_buf(root, size);
+   root->lookup_mask = tree_hash_size((uint64_t)count * 2) - 1;
+   root->lookup = (uint32_t *)calloc(root->lookup_mask + 1, sizeof(uint32_t));
+   root->names_mask = tree_hash_size(count / 2) - 1;
+   root->names = (char **)calloc(root->names_mask + 1, sizeof(char *));
    root->cached_path_len = -1;
    root->cached_path = get_pool_memory(PM_FNAME);
-   root->type = TN_ROOT;
-   root->fname = "";
-   root->can_access = 1;
    HL_ENTRY* entry = NULL;
    root->hardlinks.init(entry, &entry->link, 0);
+   struct s_delta_entry *delta = NULL;
+   root->deltas.init(delta, &delta->link, 0);
+
+   node = new_tree_node(root);        /* the root is the node 0 */
+   node->type = TN_ROOT;
+   node->fname = tree_intern_name(root, "");
    return root;
 }
 
 /*
- * Create a new tree node.
+ * Allocate bytes in the tree structure. The file names
+ *  are not aligned, the other items are.
  */
-static TREE_NODE *new_tree_node(TREE_ROOT *root)
+static char *tree_alloc_bytes(TREE_ROOT *root, int asize)
 {
-   TREE_NODE *node;
-   int size = sizeof(TREE_NODE);
-   node = (TREE_NODE *)tree_alloc(root, size);
-   bmemset(node, 0, size);
-   node->delta_seq = -1;
-   node->can_access = 1;
-   return node;
+   char *buf;
+
+   if (root->mem->rem < asize) {
+      uint32_t mb_size;
+      if (root->total_size >= (MAX_BUF_SIZE / 2)) {
+         mb_size = MAX_BUF_SIZE;
+      } else {
+         mb_size = MAX_BUF_SIZE / 2;
+      }
+      if ((uint32_t)asize > mb_size / 2) {
+         mb_size = asize + sizeof(struct s_mem);
+      }
+      malloc_buf(root, mb_size);
+   }
+   root->mem->rem -= asize;
+   buf = root->mem->mem;
+   root->mem->mem += asize;
+   return buf;
+}
+
+static char *tree_alloc(TREE_ROOT *root, int size)
+{
+   return tree_alloc_bytes(root, BALIGN(size));
+}
+
+/* FNV-1a */
+static uint32_t tree_hash_name(const char *name)
+{
+   uint32_t hash = 2166136261U;
+   for (const unsigned char *p = (const unsigned char *)name; *p; p++) {
+      hash = (hash ^ *p) * 16777619U;
+   }
+   return hash;
+}
+
+/* The names are interned, so the lookup can compare the pointers */
+static uint32_t tree_hash_child(uint32_t parent, const char *fname)
+{
+   uint64_t key = ((uint64_t)parent << 32) ^ (uint64_t)(intptr_t)fname;
+   return (uint32_t)((key * 0x9E3779B97F4A7C15ULL) >> 32);
+}
+
+static void grow_names(TREE_ROOT *root)
+{
+   uint32_t old_size = root->names_mask + 1;
+   char **old = root->names;
+   uint32_t i, j;
+
+   root->names_mask = old_size * 2 - 1;
+   root->names = (char **)calloc(root->names_mask + 1, sizeof(char *));
+   for (i = 0; i < old_size; i++) {
+      if (old[i]) {
+         for (j = tree_hash_name(old[i]) & root->names_mask; root->names[j];
+              j = (j + 1) & root->names_mask) { }
+         root->names[j] = old[i];
+      }
+   }
+   free(old);
 }
 
 /*
- * This routine can be called to release the
- *  previously allocated tree node.
+ * Return the single copy of a file name, a directory tree
+ *  uses the same few names over and over.
  */
-static void free_tree_node(TREE_ROOT *root)
+static char *tree_intern_name(TREE_ROOT *root, const char *fname)
 {
-   int asize = BALIGN(sizeof(TREE_NODE));
-   root->mem->rem += asize;
-   root->mem->mem -= asize;
+   uint32_t i;
+   int len;
+   char *name;
+
+   for (i = tree_hash_name(fname) & root->names_mask; root->names[i];
+        i = (i + 1) & root->names_mask) {
+      if (strcmp(root->names[i], fname) == 0) {
+         return root->names[i];
+      }
+   }
+   len = strlen(fname) + 1;
+   name = tree_alloc_bytes(root, len);
+   memcpy(name, fname, len);
+   root->names[i] = name;
+   if (++root->nb_names > (root->names_mask / 4) * 3) {
+      grow_names(root);
+   }
+   return name;
 }
 
-void tree_remove_node(TREE_ROOT *root, TREE_NODE *node)
+static void grow_lookup(TREE_ROOT *root)
 {
-   int asize = BALIGN(sizeof(TREE_NODE));
-   node->parent->child.remove(node);
-   if ((root->mem->mem - asize) == (char *)node) {
-      free_tree_node(root);
-   } else {
-      Dmsg0(0, "Can't release tree node\n");
+   TREE_NODE *node;
+   uint32_t i, j;
+
+   free(root->lookup);
+   root->lookup_mask = root->lookup_mask * 2 + 1;
+   root->lookup = (uint32_t *)calloc(root->lookup_mask + 1, sizeof(uint32_t));
+   for (i = 1; i < root->nb_nodes; i++) {
+      node = tree_node(root, i);
+      for (j = tree_hash_child(node->parent, node->fname) & root->lookup_mask;
+           root->lookup[j]; j = (j + 1) & root->lookup_mask) { }
+      root->lookup[j] = i;
    }
 }
 
-/*
- * Allocate bytes for filename in tree structure.
- *  Keep the pointers properly aligned by allocating
- *  sizes that are aligned.
+/* Remove a node from the lookup table, linear probing needs
+ *  to move back the entries that follow it.
  */
-static char *tree_alloc(TREE_ROOT *root, int size)
+static void lookup_remove(TREE_ROOT *root, TREE_NODE *node)
 {
-   char *buf;
-   int asize = BALIGN(size);
+   uint32_t mask = root->lookup_mask;
+   uint32_t i, j, k;
+   TREE_NODE *n;
 
-   if (root->mem->rem < asize) {
-      uint32_t mb_size;
-      if (root->total_size >= (MAX_BUF_SIZE / 2)) {
-         mb_size = MAX_BUF_SIZE;
-      } else {
-         mb_size = MAX_BUF_SIZE / 2;
+   for (i = tree_hash_child(node->parent, node->fname) & mask;
+        root->lookup[i] && root->lookup[i] != node->index; i = (i + 1) & mask) { }
+   if (!root->lookup[i]) {
+      return;
+   }
+   for (j = (i + 1) & mask; root->lookup[j]; j = (j + 1) & mask) {
+      n = tree_node(root, root->lookup[j]);
+      k = tree_hash_child(n->parent, n->fname) & mask;
+      /* Move it back if its home slot is not between i and j */
+      if ((i <= j) ? (k <= i || k > j) : (k <= i && k > j)) {
+         root->lookup[i] = root->lookup[j];
+         i = j;
       }
-      malloc_buf(root, mb_size);
    }
-   root->mem->rem -= asize;
-   buf = root->mem->mem;
-   root->mem->mem += asize;
-   return buf;
+   root->lookup[i] = 0;
 }
 
+/*
+ * This routine can be called to release the
+ *  node that was just inserted.
+ */
+void tree_remove_node(TREE_ROOT *root, TREE_NODE *node)
+{
+   TREE_NODE *parent, *prev;
+
+   if (node->index + 1 != root->nb_nodes || !root->lookup) {
+      Dmsg0(0, "Can't release tree node\n");
+      return;
+   }
+   lookup_remove(root, node);
+   parent = tree_node(root, node->parent);
+   if (parent->child == node->index) {
+      parent->child = node->sibling;
+   } else {
+      for (prev = tree_node(root, parent->child); prev->sibling != node->index; ) {
+         prev = tree_node(root, prev->sibling);
+      }
+      prev->sibling = node->sibling;
+   }
+   if (root->cached_parent == node) {
+      root->cached_path_len = -1;
+   }
+   root->nb_nodes--;
+}
 
 /* This routine frees the whole tree */
 void free_tree(TREE_ROOT *root)
@@ -168,17 +326,34 @@ void free_tree(TREE_ROOT *root)
    uint32_t freed_blocks = 0;
 
    root->hardlinks.destroy();
+   root->deltas.destroy();
    for (mem=root->mem; mem; ) {
       rel = mem;
       mem = mem->next;
       free(rel);
       freed_blocks++;
    }
+   for (uint32_t i = 0; i < root->nb_chunks; i++) {
+      free(root->chunks[i]);
+      freed_blocks++;
+   }
+   if (root->chunks) {
+      free(root->chunks);
+   }
+   if (root->children) {
+      free(root->children);
+   }
+   if (root->lookup) {
+      free(root->lookup);
+   }
+   if (root->names) {
+      free(root->names);
+   }
    if (root->cached_path) {
       free_pool_memory(root->cached_path);
       root->cached_path = NULL;
    }
-   Dmsg3(100, "Total size=%u blocks=%u freed_blocks=%u\n", root->total_size, root->blocks, freed_blocks);
+   Dmsg3(100, "Total size=%llu blocks=%u freed_blocks=%u\n", root->total_size, root->blocks, freed_blocks);
    free(root);
    garbage_collect_memory();
    return;
@@ -190,11 +365,31 @@ void tree_add_delta_part(TREE_ROOT *root, TREE_NODE *node,
 {
    struct delta_list *elt =
       (struct delta_list*) tree_alloc(root, sizeof(struct delta_list));
+   struct s_delta_entry *entry =
+      (struct s_delta_entry *)root->deltas.lookup((uint64_t)node->index);
 
-   elt->next = node->delta_list;
+   if (!entry) {
+      entry = (struct s_delta_entry *)root->deltas.hash_malloc(sizeof(struct s_delta_entry));
+      entry->list = NULL;
+      root->deltas.insert((uint64_t)node->index, entry);
+   }
+   elt->next = entry->list;
    elt->JobId = JobId;
    elt->FileIndex = FileIndex;
-   node->delta_list = elt;
+   entry->list = elt;
+   node->has_delta = true;
+}
+
+/* Return the delta parts for this node, the most recent first */
+struct delta_list *tree_delta_list(TREE_ROOT *root, TREE_NODE *node)
+{
+   struct s_delta_entry *entry;
+
+   if (!node->has_delta) {
+      return NULL;
+   }
+   entry = (struct s_delta_entry *)root->deltas.lookup((uint64_t)node->index);
+   return entry ? entry->list : NULL;
 }
 
 /*
@@ -251,7 +446,7 @@ TREE_NODE *insert_tree_node(char *path, char *fname, int type,
    } else {
       fname = path;
       if (!parent) {
-         parent = (TREE_NODE *)root;
+         parent = tree_root_node(root);
          type = TN_DIR_NLS;
       }
       Dmsg1(100, "No / found: %s\n", path);
@@ -280,7 +475,7 @@ TREE_NODE *make_tree_path(char *path, TREE_ROOT *root)
    Dmsg1(100, "make_tree_path: %s\n", path);
    if (*path == 0) {
       Dmsg0(100, "make_tree_path: parent=*root*\n");
-      return (TREE_NODE *)root;
+      return tree_root_node(root);
    }
    p = (char *)last_path_separator(path);           /* get last dir component of path */
    if (p) {
@@ -290,17 +485,17 @@ TREE_NODE *make_tree_path(char *path, TREE_ROOT *root)
       *p = '/';                       /* restore full name */
    } else {
       fname = path;
-      parent = (TREE_NODE *)root;
+      parent = tree_root_node(root);
       type = TN_DIR_NLS;
    }
    node = search_and_insert_tree_node(fname, type, root, parent);
    return node;
 }
 
-static int node_compare(void *item1, void *item2)
+static int node_compare(const void *item1, const void *item2)
 {
-   TREE_NODE *tn1 = (TREE_NODE *)item1;
-   TREE_NODE *tn2 = (TREE_NODE *)item2;
+   TREE_NODE *tn1 = *(TREE_NODE **)item1;
+   TREE_NODE *tn2 = *(TREE_NODE **)item2;
    if (tn1->fname[0] > tn2->fname[0]) {
       return 1;
    } else if (tn1->fname[0] < tn2->fname[0]) {
@@ -315,41 +510,96 @@ static int node_compare(void *item1, void *item2)
 static TREE_NODE *search_and_insert_tree_node(char *fname, int type,
                TREE_ROOT *root, TREE_NODE *parent)
 {
-   TREE_NODE *node, *found_node;
+   TREE_NODE *node;
+   char *name;
+   uint32_t i;
+
+   ASSERT(root->lookup != NULL);      /* tree_build_children() not yet called */
+   name = tree_intern_name(root, fname);
+   for (i = tree_hash_child(parent->index, name) & root->lookup_mask; root->lookup[i];
+        i = (i + 1) & root->lookup_mask) {
+      node = tree_node(root, root->lookup[i]);
+      if (node->fname == name && node->parent == parent->index) {
+         node->inserted = false;      /* already in list */
+         return node;
+      }
+   }
+   /* It was not found, insert it */
    node = new_tree_node(root);
-   node->fname = fname;
-   found_node = (TREE_NODE *)parent->child.insert(node, node_compare);
-   if (found_node != node) {          /* already in list */
-      free_tree_node(root);           /* free node allocated above */
-      found_node->inserted = false;
-      return found_node;
-   }
-   /* It was not found, but is now inserted */
-   node->fname_len = strlen(fname);
-   node->fname = tree_alloc(root, node->fname_len + 1);
-   strcpy(node->fname, fname);
-   node->parent = parent;
+   node->fname = name;
+   node->parent = parent->index;
    node->type = type;
-   /* Maintain a linear chain of nodes */
-   if (!root->first) {
-      root->first = node;
-      root->last = node;
-   } else {
-      root->last->next = node;
-      root->last = node;
+   node->sibling = parent->child;
+   parent->child = node->index;
+   root->lookup[i] = node->index;
+   if (root->nb_nodes > (root->lookup_mask / 4) * 3) {
+      grow_lookup(root);
    }
    node->inserted = true;             /* inserted into tree */
    return node;
+}
+
+/*
+ * Once all the files are inserted, store the children of each node
+ *  sorted by name in a single array, and release the memory used
+ *  to build the tree. No node can be inserted after this call.
+ */
+void tree_build_children(TREE_ROOT *root)
+{
+   TREE_NODE *node, *child;
+   TREE_NODE **sorted = NULL;
+   uint32_t max_sorted = 0;
+   uint32_t pos = 1;                  /* 0 means no child */
+   uint32_t nb, i, j, c;
 
+   if (root->children) {
+      return;                         /* already done */
+   }
+   root->children = (uint32_t *)malloc((root->nb_nodes + 1) * sizeof(uint32_t));
+   root->children[0] = 0;
+
+   /* A parent is always inserted before its children, so the sibling
+    *  chain is used before being replaced by nb_child
+    */
+   for (i = 0; i < root->nb_nodes; i++) {
+      node = tree_node(root, i);
+      nb = 0;
+      for (c = node->child; c; c = child->sibling) {
+         child = tree_node(root, c);
+         if (nb == max_sorted) {
+            max_sorted = max_sorted ? max_sorted * 2 : 1024;
+            sorted = (TREE_NODE **)realloc(sorted, max_sorted * sizeof(TREE_NODE *));
+         }
+         sorted[nb++] = child;
+      }
+      if (nb > 1) {
+         qsort(sorted, nb, sizeof(TREE_NODE *), node_compare);
+      }
+      node->child = nb ? pos : 0;
+      node->nb_child = nb;
+      for (j = 0; j < nb; j++) {
+         root->children[pos++] = sorted[j]->index;
+      }
+   }
+   if (sorted) {
+      free(sorted);
+   }
+   free(root->lookup);
+   root->lookup = NULL;
+   free(root->names);
+   root->names = NULL;
+   root->cached_path_len = -1;
+   Dmsg3(100, "Tree nodes=%u names=%u size=%llu\n", root->nb_nodes, root->nb_names,
+         root->total_size);
 }
 
-int tree_getpath(TREE_NODE *node, char *buf, int buf_size)
+int tree_getpath(TREE_ROOT *root, TREE_NODE *node, char *buf, int buf_size)
 {
    if (!node) {
       buf[0] = 0;
       return 1;
    }
-   tree_getpath(node->parent, buf, buf_size);
+   tree_getpath(root, tree_parent(root, node), buf, buf_size);
    /*
     * Fixup for Win32. If we have a Win32 directory and
     *    there is only a / in the buffer, remove it since
@@ -380,7 +630,10 @@ TREE_NODE *tree_cwd(char *path, TREE_ROOT *root, TREE_NODE *node)
    }
    /* Handle relative path */
    if (path[0] == '.' && path[1] == '.' && (IsPathSeparator(path[2]) || path[2] == '\0')) {
-      TREE_NODE *parent = node->parent ? node->parent : node;
+      TREE_NODE *parent = tree_parent(root, node);
+      if (!parent) {
+         parent = node;
+      }
       if (path[2] == 0) {
          return parent;
       } else {
@@ -389,7 +642,7 @@ TREE_NODE *tree_cwd(char *path, TREE_ROOT *root, TREE_NODE *node)
    }
    if (IsPathSeparator(path[0])) {
       Dmsg0(100, "Doing absolute lookup.\n");
-      return tree_relcwd(path+1, root, (TREE_NODE *)root);
+      return tree_relcwd(path+1, root, tree_root_node(root));
    }
    Dmsg0(100, "Doing relative lookup.\n");
    return tree_relcwd(path, root, node);
@@ -417,7 +670,7 @@ TREE_NODE *tree_relcwd(char *path, TREE_ROOT *root, TREE_NODE *node)
       len = strlen(path);
    }
    Dmsg2(100, "tree_relcwd: len=%d path=%s\n", len, path);
-   foreach_child(cd, node) {
+   foreach_child(root, cd, node) {
       Dmsg1(100, "tree_relcwd: test cd=%s\n", cd->fname);
       if (cd->fname[0] == path[0] && len == (int)strlen(cd->fname)
           && strncmp(cd->fname, path, len) == 0) {
@@ -447,158 +700,116 @@ TREE_NODE *tree_relcwd(char *path, TREE_ROOT *root, TREE_NODE *node)
    return tree_relcwd(p+1, root, cd);
 }
 
+#ifndef TEST_PROGRAM
+#define TEST_PROGRAM_A
+#endif
 
+#ifdef TEST_PROGRAM
+#include "unittests.h"
 
-#ifdef BUILD_TEST_PROGRAM
-
-void FillDirectoryTree(char *path, TREE_ROOT *root, TREE_NODE *parent);
-
-static uint32_t FileIndex = 0;
-/*
- * Simple test program for tree routines
- */
-int main(int argc, char *argv[])
-{
-    TREE_ROOT *root;
-    TREE_NODE *node;
-    char buf[MAXPATHLEN];
-
-    root = new_tree();
-    root->fname = tree_alloc(root, 1);
-    *root->fname = 0;
-    root->fname_len = 0;
-
-    FillDirectoryTree("/home/kern/bacula/k", root, NULL);
-
-    for (node = first_tree_node(root); node; node=next_tree_node(node)) {
-       tree_getpath(node, buf, sizeof(buf));
-       Dmsg2(100, "%d: %s\n", node->FileIndex, buf);
-    }
-
-    node = (TREE_NODE *)root;
-    Pmsg0(000, "doing cd /home/kern/bacula/k/techlogs\n");
-    node = tree_cwd("/home/kern/bacula/k/techlogs", root, node);
-    if (node) {
-       tree_getpath(node, buf, sizeof(buf));
-       Dmsg2(100, "findex=%d: cwd=%s\n", node->FileIndex, buf);
-    }
-
-    Pmsg0(000, "doing cd /home/kern/bacula/k/src/testprogs\n");
-    node = tree_cwd("/home/kern/bacula/k/src/testprogs", root, node);
-    if (node) {
-       tree_getpath(node, buf, sizeof(buf));
-       Dmsg2(100, "findex=%d: cwd=%s\n", node->FileIndex, buf);
-    } else {
-       Dmsg0(100, "testprogs not found.\n");
-    }
-
-    free_tree((TREE_NODE *)root);
-
-    return 0;
-}
+#define NDIRS  500
+#define NFILES 400                    /* more than TREE_CHUNK_NODES files */
 
-void FillDirectoryTree(char *path, TREE_ROOT *root, TREE_NODE *parent)
+int main()
 {
-   TREE_NODE *newparent = NULL;
-   TREE_NODE *node;
-   struct stat statbuf;
-   DIR *dp;
-   POOL_MEM dname(PM_FNAME);
-   char pathbuf[MAXPATHLEN];
-   char file[MAXPATHLEN];
-   int type;
-   int i;
-
-   Dmsg1(100, "FillDirectoryTree: %s\n", path);
-   dp = opendir(path);
-   if (!dp) {
-      return;
-   }
-   while (readdir(dp, dname.addr()) != 0) {
-      if (strcmp(dname.c_str(), ".") == 0 || strcmp(dname.c_str(), "..") == 0) {
-         continue;
-      }
-      bstrncpy(file, dname.c_str(), sizeof(file));
-      snprintf(pathbuf, MAXPATHLEN-1, "%s/%s", path, file);
-      if (lstat(pathbuf, &statbuf) < 0) {
-         berrno be;
-         printf("lstat() failed. ERR=%s\n", be.bstrerror(errno));
-         continue;
-      }
-//      printf("got file=%s, pathbuf=%s\n", file, pathbuf);
-      type = TN_FILE;
-      if (S_ISLNK(statbuf.st_mode))
-         type =  TN_FILE;  /* link */
-      else if (S_ISREG(statbuf.st_mode))
-         type = TN_FILE;
-      else if (S_ISDIR(statbuf.st_mode)) {
-         type = TN_DIR;
-      } else if (S_ISCHR(statbuf.st_mode))
-         type = TN_FILE; /* char dev */
-      else if (S_ISBLK(statbuf.st_mode))
-         type = TN_FILE; /* block dev */
-      else if (S_ISFIFO(statbuf.st_mode))
-         type = TN_FILE; /* fifo */
-      else if (S_ISSOCK(statbuf.st_mode))
-         type = TN_FILE; /* sock */
-      else {
-         type = TN_FILE;
-         printf("Unknown file type: 0x%x\n", statbuf.st_mode);
+   Unittests tree_test("tree_test");
+   TREE_ROOT *root;
+   TREE_NODE *node, *node2, *child, *prev;
+   char path[200], fname[50], buf[500];
+   int i, j, count;
+   bool check;
+
+   root = new_tree(0);                /* make the hash tables grow */
+   ok(root && root->nb_nodes == 1, "Create the tree");
+
+   for (i = 0; i < NDIRS; i++) {
+      for (j = NFILES - 1; j >= 0; j--) {
+         bsnprintf(path, sizeof(path), "/home/user%d/dir%d/", i % 10, i);
+         bsnprintf(fname, sizeof(fname), "file%03d", j);
+         node = insert_tree_node(path, fname, TN_FILE, root, NULL);
+         node->type = TN_FILE;
+         node->FileIndex = i * NFILES + j + 1;
       }
-
-      Dmsg2(100, "Doing: %d %s\n", type, pathbuf);
-      node = new_tree_node(root);
-      node->FileIndex = ++FileIndex;
-      parent = insert_tree_node(pathbuf, node, root, parent);
-      if (S_ISDIR(statbuf.st_mode) && !S_ISLNK(statbuf.st_mode)) {
-         Dmsg2(100, "calling fill. pathbuf=%s, file=%s\n", pathbuf, file);
-         FillDirectoryTree(pathbuf, root, node);
+   }
+   /* / home user0..9 dir0..499 files + the root */
+   ok(root->nb_nodes == 1 + 1 + 10 + NDIRS + NDIRS * NFILES, "Check the number of nodes");
+   ok(root->nb_chunks > 1, "Check that several chunks are used");
+   ok(root->nb_names < 2000, "Check that the names are shared");
+
+   bstrncpy(path, "/home/user3/dir13/", sizeof(path));
+   node = insert_tree_node(path, (char *)"file007", TN_FILE, root, NULL);
+   ok(!node->inserted && node->FileIndex == 13 * NFILES + 7 + 1, "Find an existing node");
+   ok(strcmp(path, "/home/user3/dir13/") == 0, "Check that the path is not modified");
+
+   node = insert_tree_node(path, (char *)"deleted", TN_FILE, root, NULL);
+   ok(node->inserted && node->index == root->nb_nodes - 1, "Insert a new node");
+   tree_remove_node(root, node);
+   node = insert_tree_node(path, (char *)"deleted", TN_FILE, root, NULL);
+   ok(node->inserted, "Insert the removed node again");
+   tree_remove_node(root, node);
+
+   node = insert_tree_node(path, (char *)"file002", TN_FILE, root, NULL);
+   tree_add_delta_part(root, node, 1, 10);
+   tree_add_delta_part(root, node, 2, 20);
+   ok(tree_delta_list(root, node) && tree_delta_list(root, node)->JobId == 2 &&
+      tree_delta_list(root, node)->next->FileIndex == 10, "Check the delta parts");
+   ok(tree_delta_list(root, tree_root_node(root)) == NULL, "No delta part on root");
+
+   /* The tree can be browsed while it is loaded */
+   node = tree_cwd(bstrncpy(path, "/home/user3/dir13", sizeof(path)), root, tree_root_node(root));
+   count = 0;
+   if (node) {
+      foreach_child(root, child, node) {
+         count++;
       }
    }
-   closedir(dp);
-}
+   ok(count == NFILES, "List a directory while the tree is loaded");
 
-#ifndef MAXPATHLEN
-#define MAXPATHLEN 2000
-#endif
+   tree_build_children(root);
+   ok(root->lookup == NULL && root->names == NULL, "Release the hash tables");
 
-void print_tree(char *path, TREE_NODE *tree)
-{
-   char buf[MAXPATHLEN];
-   char *termchr;
+   node = tree_cwd(bstrncpy(path, "/home/user3/dir13", sizeof(path)), root, tree_root_node(root));
+   ok(node != NULL && node->nb_child == NFILES, "cd to a directory");
+   tree_getpath(root, node, buf, sizeof(buf));
+   ok(strcmp(buf, "/home/user3/dir13/") == 0, "Get the path of a directory");
 
-   if (!tree) {
-      return;
+   count = 0;
+   check = true;
+   prev = NULL;
+   foreach_child(root, child, node) {
+      if (prev && strcmp(prev->fname, child->fname) >= 0) {
+         check = false;
+      }
+      prev = child;
+      count++;
+   }
+   ok(count == NFILES && check, "Check that the children are sorted");
+   child = first_child(root, node);
+   tree_getpath(root, child, buf, sizeof(buf));
+   ok(strcmp(buf, "/home/user3/dir13/file000") == 0, "Get the path of a file");
+
+   node2 = tree_cwd(bstrncpy(path, "../../user4/dir14", sizeof(path)), root, node);
+   ok(node2 && strcmp(node2->fname, "dir14") == 0, "cd to a relative path");
+   node2 = tree_cwd(bstrncpy(path, "/home/user*/dir2?", sizeof(path)), root, node);
+   ok(node2 && strcmp(node2->fname, "dir20") == 0, "cd with wildcards");
+   ok(tree_cwd(bstrncpy(path, "/home/user3/dir14", sizeof(path)), root, node) == NULL, "cd to a missing directory");
+   ok(tree_cwd(bstrncpy(path, "file001", sizeof(path)), root, node) == NULL, "cd to a file");
+   ok(tree_cwd(bstrncpy(path, "..", sizeof(path)), root, tree_root_node(root)) == tree_root_node(root), "cd .. on root");
+
+   tree_set_extract(root, child, true);
+   tree_set_extract_dir(root, node, true);
+   count = 0;
+   for (node2 = first_tree_node(root); node2; node2 = next_tree_node(root, node2)) {
+      if (tree_extract(root, node2) || tree_extract_dir(root, node2)) {
+         count++;
+      }
    }
-   switch (tree->type) {
-   case TN_DIR_NLS:
-   case TN_DIR:
-   case TN_NEWDIR:
-      termchr = "/";
-      break;
-   case TN_ROOT:
-   case TN_FILE:
-   default:
-      termchr = "";
-      break;
-   }
-   Pmsg3(-1, "%s/%s%s\n", path, tree->fname, termchr);
-   switch (tree->type) {
-   case TN_FILE:
-   case TN_NEWDIR:
-   case TN_DIR:
-   case TN_DIR_NLS:
-      bsnprintf(buf, sizeof(buf), "%s/%s", path, tree->fname);
-      print_tree(buf, first_child(tree));
-      break;
-   case TN_ROOT:
-      print_tree(path, first_child(tree));
-      break;
-   default:
-      Pmsg1(000, "Unknown node type %d\n", tree->type);
-   }
-   print_tree(path, tree->sibling_);
-   return;
-}
+   ok(count == 2 && tree_extract(root, child) && !tree_extract_dir(root, child) &&
+      tree_extract_dir(root, node) && !tree_extract(root, node), "Check the marks");
+   tree_set_extract(root, child, false);
+   ok(!tree_extract(root, child), "Clear a mark");
 
+   free_tree(root);
+   return report();
+}
 #endif
@@ -32,16 +32,15 @@ struct s_mem {
    char first[1];                     /* first byte */
 };
 
-#define USE_DLIST
-
-#define foreach_child(var, list) \
-    for((var)=NULL; (*((TREE_NODE **)&(var))=(TREE_NODE*)(list->child.next(var))); )
-
-#define tree_node_has_child(node) \
-        ((node)->child.size() > 0)
-
-#define first_child(node) \
-        ((TREE_NODE *)(node->child.first())
+/*
+ * The nodes are stored in chunks of TREE_CHUNK_NODES entries that
+ *  never move, a node is known by its 32 bit index and the root is
+ *  the node 0. The extract marks are kept in a bitmap next to the
+ *  nodes of each chunk.
+ */
+#define TREE_CHUNK_BITS  16
+#define TREE_CHUNK_NODES (1 << TREE_CHUNK_BITS)
+#define TREE_CHUNK_MASK  (TREE_CHUNK_NODES - 1)
 
 struct delta_list {
    struct delta_list *next;
@@ -52,63 +51,58 @@ struct delta_list {
 /*
  * Keep this node as small as possible because
  *   there is one for each file.
+ *
+ * While the tree is loaded, the children of a node are chained
+ *  with sibling. tree_build_children() then stores them sorted by
+ *  name in root->children[child .. child+nb_child-1].
  */
 struct s_tree_node {
-   /* KEEP sibling as the first member to avoid having to
-    *  do initialization of child */
-   rblink sibling;
-   rblist child;
-   char *fname;                       /* file name */
+   char *fname;                       /* file name, shared with other nodes */
+   uint32_t index;                    /* index of this node */
+   uint32_t parent;                   /* index of the parent node */
+   uint32_t child;                    /* first child, 0 if none */
+   union {
+      uint32_t sibling;               /* next child of the parent (load) */
+      uint32_t nb_child;              /* number of children (built) */
+   };
    int32_t FileIndex;                 /* file index */
    uint32_t JobId;                    /* JobId */
    int32_t delta_seq;                 /* current delta sequence */
-   uint16_t fname_len;                /* filename length */
    int type: 8;                       /* node type */
-   unsigned int extract: 1;           /* extract item */
-   unsigned int extract_dir: 1;       /* extract dir entry only */
    unsigned int hard_link: 1;         /* set if have hard link */
    unsigned int soft_link: 1;         /* set if is soft link */
    unsigned int inserted: 1;          /* set when node newly inserted */
    unsigned int loaded: 1;            /* set when the dir is in the tree */
    unsigned int can_access: 1;        /* Can access to this node */
-   struct s_tree_node *parent;
-   struct s_tree_node *next;          /* next hash of FileIndex */
-   struct delta_list *delta_list;     /* delta parts for this node */
+   unsigned int has_delta: 1;         /* delta parts in root->deltas */
 };
 typedef struct s_tree_node TREE_NODE;
 
+struct s_tree_chunk {
+   uint64_t extract[TREE_CHUNK_NODES / 64];     /* extract item */
+   uint64_t extract_dir[TREE_CHUNK_NODES / 64]; /* extract dir entry only */
+   TREE_NODE nodes[TREE_CHUNK_NODES];
+};
+
 struct s_tree_root {
-   /* KEEP sibling as the first member to avoid having to
-    *  do initialization of child */
-   rblink sibling;
-   rblist child;
-   const char *fname;                 /* file name */
-   int32_t FileIndex;                 /* file index */
-   uint32_t JobId;                    /* JobId */
-   int32_t delta_seq;                 /* current delta sequence */
-   uint16_t fname_len;                /* filename length */
-   unsigned int type: 8;              /* node type */
-   unsigned int extract: 1;           /* extract item */
-   unsigned int extract_dir: 1;       /* extract dir entry only */
-   unsigned int hard_link: 1;         /* set if have hard link */
-   unsigned int soft_link: 1;         /* set if is soft link */
-   unsigned int inserted: 1;          /* set when newly inserted */
-   unsigned int loaded: 1;            /* set when the dir is in the tree */
-   unsigned int can_access: 1;        /* Can access to this node */
-   struct s_tree_node *parent;
-   struct s_tree_node *next;          /* next hash of FileIndex */
-   struct delta_list *delta_list;     /* delta parts for this node */
-
-   /* The above ^^^ must be identical to a TREE_NODE structure */
-   struct s_tree_node *first;         /* first entry in the tree */
-   struct s_tree_node *last;          /* last entry in tree */
-   struct s_mem *mem;                 /* tree memory */
-   uint32_t total_size;               /* total bytes allocated */
+   struct s_tree_chunk **chunks;      /* node storage */
+   uint32_t nb_chunks;                /* chunks allocated */
+   uint32_t max_chunks;               /* size of the chunks array */
+   uint32_t nb_nodes;                 /* nodes in use, including the root */
+   uint32_t *children;                /* sorted children, see tree_build_children() */
+   uint32_t *lookup;                  /* (parent, fname) -> node while loading */
+   uint32_t lookup_mask;              /* size of lookup - 1 */
+   char **names;                      /* interned file names while loading */
+   uint32_t names_mask;               /* size of names - 1 */
+   uint32_t nb_names;                 /* number of interned names */
+   struct s_mem *mem;                 /* file names and delta parts */
+   uint64_t total_size;               /* total bytes allocated */
    uint32_t blocks;                   /* total mallocs */
    int cached_path_len;               /* length of cached path */
    char *cached_path;                 /* cached current path */
    TREE_NODE *cached_parent;          /* cached parent for above path */
    htable hardlinks;                  /* references to first occurrence of hardlinks */
+   htable deltas;                     /* delta parts of the nodes */
 };
 typedef struct s_tree_root TREE_ROOT;
 
@@ -127,17 +121,107 @@ typedef struct s_hl_entry HL_ENTRY;
 #define TN_DIR_NLS 4                  /* directory -- no leading slash -- win32 */
 #define TN_FILE    5                  /* file entry */
 
+static inline TREE_NODE *tree_node(TREE_ROOT *root, uint32_t index)
+{
+   return &root->chunks[index >> TREE_CHUNK_BITS]->nodes[index & TREE_CHUNK_MASK];
+}
+
+#define tree_root_node(root) tree_node((root), 0)
+
+/* Return NULL for the root */
+static inline TREE_NODE *tree_parent(TREE_ROOT *root, TREE_NODE *node)
+{
+   return node->index == 0 ? NULL : tree_node(root, node->parent);
+}
+
+#define tree_node_has_child(node) \
+        ((node)->child != 0)
+
+/* Return the i-th child of a node, NULL after the last one.
+ *  Valid only once tree_build_children() has been called.
+ */
+static inline TREE_NODE *tree_child(TREE_ROOT *root, TREE_NODE *node, uint32_t i)
+{
+   if (node->child == 0 || i >= node->nb_child) {
+      return NULL;
+   }
+   return tree_node(root, root->children[node->child + i]);
+}
+
+/* Return the i-th child of a node, prev is the (i-1)-th one.
+ *  While the tree is loaded, the sibling chain is followed, so
+ *  the children come in the reverse order of their insertion.
+ */
+static inline TREE_NODE *tree_next_child(TREE_ROOT *root, TREE_NODE *node,
+                                         TREE_NODE *prev, uint32_t i)
+{
+   uint32_t next;
+
+   if (root->children) {
+      return tree_child(root, node, i);
+   }
+   next = prev ? prev->sibling : node->child;
+   return next ? tree_node(root, next) : NULL;
+}
+
+#define foreach_child(root, var, node) \
+    for (uint32_t _fc = 0; \
+         ((var) = tree_next_child((root), (node), _fc ? (var) : NULL, _fc)) != NULL; _fc++)
+
+#define first_child(root, node) tree_next_child((root), (node), NULL, 0)
+
+/* Extract marks */
+static inline uint64_t *tree_mark_word(uint64_t *bitmap, TREE_NODE *node)
+{
+   return &bitmap[(node->index & TREE_CHUNK_MASK) >> 6];
+}
+
+#define tree_mark_bit(node) ((uint64_t)1 << ((node)->index & 63))
+#define tree_chunk_of(root, node) ((root)->chunks[(node)->index >> TREE_CHUNK_BITS])
+
+static inline bool tree_extract(TREE_ROOT *root, TREE_NODE *node)
+{
+   return (*tree_mark_word(tree_chunk_of(root, node)->extract, node) & tree_mark_bit(node)) != 0;
+}
+
+static inline bool tree_extract_dir(TREE_ROOT *root, TREE_NODE *node)
+{
+   return (*tree_mark_word(tree_chunk_of(root, node)->extract_dir, node) & tree_mark_bit(node)) != 0;
+}
+
+static inline void tree_set_extract(TREE_ROOT *root, TREE_NODE *node, bool extract)
+{
+   uint64_t *w = tree_mark_word(tree_chunk_of(root, node)->extract, node);
+   if (extract) {
+      *w |= tree_mark_bit(node);
+   } else {
+      *w &= ~tree_mark_bit(node);
+   }
+}
+
+static inline void tree_set_extract_dir(TREE_ROOT *root, TREE_NODE *node, bool extract)
+{
+   uint64_t *w = tree_mark_word(tree_chunk_of(root, node)->extract_dir, node);
+   if (extract) {
+      *w |= tree_mark_bit(node);
+   } else {
+      *w &= ~tree_mark_bit(node);
+   }
+}
+
 /* External interface */
 TREE_ROOT *new_tree(int count);
 TREE_NODE *insert_tree_node(char *path, char *fname, int type,
                             TREE_ROOT *root, TREE_NODE *parent);
 TREE_NODE *make_tree_path(char *path, TREE_ROOT *root);
+void tree_build_children(TREE_ROOT *root);
 TREE_NODE *tree_cwd(char *path, TREE_ROOT *root, TREE_NODE *node);
 TREE_NODE *tree_relcwd(char *path, TREE_ROOT *root, TREE_NODE *node);
 void tree_add_delta_part(TREE_ROOT *root, TREE_NODE *node,
                          JobId_t JobId, int32_t FileIndex);
+struct delta_list *tree_delta_list(TREE_ROOT *root, TREE_NODE *node);
 void free_tree(TREE_ROOT *root);
-int tree_getpath(TREE_NODE *node, char *buf, int buf_size);
+int tree_getpath(TREE_ROOT *root, TREE_NODE *node, char *buf, int buf_size);
 void tree_remove_node(TREE_ROOT *root, TREE_NODE *node);
 
 /*
@@ -145,5 +229,6 @@ void tree_remove_node(TREE_ROOT *root, TREE_NODE *node);
  *   traversed in the order the entries were inserted into the
  *   tree.
  */
-#define first_tree_node(r) (r)->first
-#define next_tree_node(n)  (n)->next
+#define first_tree_node(r) ((r)->nb_nodes > 1 ? tree_node((r), 1) : NULL)
+#define next_tree_node(r, n) \
+   ((n)->index + 1 < (r)->nb_nodes ? tree_node((r), (n)->index + 1) : NULL)
@@ -235,6 +235,38 @@ int report()
    return err > 0;
 }
 
+/*
+ * Micro benchmark. Call fct(arg) in a loop during about duration ms,
+ *  print the number of calls per second and the throughput if size
+ *  (bytes processed by each call) is given.
+ *  Returns the number of calls per second.
+ */
+int64_t bench(const char *label, void (*fct)(void *arg), void *arg, int duration, uint64_t size)
+{
+   btime_t start, now, end;
+   uint64_t nb = 0;
+   int64_t rate;
+
+   start = get_current_btime();
+   end = start + (btime_t)duration * 1000;
+   do {
+      for (int i = 0; i < 16; i++) {   /* do not measure the clock */
+         fct(arg);
+      }
+      nb += 16;
+      now = get_current_btime();
+   } while (now < end);
+
+   rate = (int64_t)(nb * 1000000 / MAX(now - start, 1));
+   if (size > 0) {
+      Pmsg3(-1, "%s: %lld calls/s %lld MB/s\n", label, rate,
+            (int64_t)(rate * size / (1024 * 1024)));
+   } else {
+      Pmsg2(-1, "%s: %lld calls/s\n", label, rate);
+   }
+   return rate;
+}
+
 void terminate(int sig) {};
 
 /*
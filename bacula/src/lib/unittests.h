@@ -63,6 +63,7 @@ void prolog(const char *name, bool lmgr=false, bool motd=true);
 void epilog();
 int unittest_get_nb_tests();
 int unittest_get_nb_errors();
+int64_t bench(const char *label, void (*fct)(void *arg), void *arg, int duration, uint64_t size=0);
 
 /* The class based approach for C++ geeks */
 class Unittests
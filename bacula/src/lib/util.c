@@ -36,8 +36,14 @@ bool is_null(const void *ptr)
    return ptr == NULL;
 }
 
-/* Return true of buffer has all zero bytes */
-bool is_buf_zero(const char *buf, int len)
+/*
+ * Return true of buffer has all zero bytes
+ *
+ * is_buf_zero() is called on every block of a sparse file, so we use
+ *  the widest vector instructions available on the CPU, the function
+ *  is selected at the first call.
+ */
+static bool is_buf_zero_generic(const char *buf, int len)
 {
    uint64_t *ip;
    const char *p;
@@ -65,6 +71,122 @@ bool is_buf_zero(const char *buf, int len)
    return true;
 }
 
+#if defined(__GNUC__) && defined(__x86_64__)
+#define HAVE_ZERO_SSE2
+#define HAVE_ZERO_AVX2
+#include <immintrin.h>
+
+/* SSE2 is always available on x86_64, check 64 bytes per loop */
+static bool is_buf_zero_sse2(const char *buf, int len)
+{
+   const char *end = buf + (len & ~63);
+   __m128i v;
+
+   if (buf[0] != 0) {
+      return false;
+   }
+   if (len < 64) {
+      return is_buf_zero_generic(buf, len);
+   }
+   for ( ; buf < end; buf += 64) {
+      v = _mm_or_si128(
+         _mm_or_si128(_mm_loadu_si128((const __m128i *)buf),
+                      _mm_loadu_si128((const __m128i *)(buf + 16))),
+         _mm_or_si128(_mm_loadu_si128((const __m128i *)(buf + 32)),
+                      _mm_loadu_si128((const __m128i *)(buf + 48))));
+      if (_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128())) != 0xFFFF) {
+         return false;
+      }
+   }
+   return (len & 63) == 0 || is_buf_zero_generic(buf, len & 63);
+}
+
+/* AVX2 is checked at runtime, 128 bytes per loop */
+__attribute__((target("avx2")))
+static bool is_buf_zero_avx2(const char *buf, int len)
+{
+   const char *end = buf + (len & ~127);
+   __m256i v;
+
+   if (buf[0] != 0) {
+      return false;
+   }
+   if (len < 128) {
+      return is_buf_zero_sse2(buf, len);
+   }
+   for ( ; buf < end; buf += 128) {
+      v = _mm256_or_si256(
+         _mm256_or_si256(_mm256_loadu_si256((const __m256i *)buf),
+                         _mm256_loadu_si256((const __m256i *)(buf + 32))),
+         _mm256_or_si256(_mm256_loadu_si256((const __m256i *)(buf + 64)),
+                         _mm256_loadu_si256((const __m256i *)(buf + 96))));
+      if (!_mm256_testz_si256(v, v)) {
+         return false;
+      }
+   }
+   return (len & 127) == 0 || is_buf_zero_sse2(buf, len & 127);
+}
+#endif
+
+#if defined(__GNUC__) && defined(__aarch64__)
+#define HAVE_ZERO_NEON
+#include <arm_neon.h>
+
+/* NEON is always available on aarch64, check 64 bytes per loop */
+static bool is_buf_zero_neon(const char *buf, int len)
+{
+   const char *end = buf + (len & ~63);
+   uint8x16_t v;
+
+   if (buf[0] != 0) {
+      return false;
+   }
+   if (len < 64) {
+      return is_buf_zero_generic(buf, len);
+   }
+   for ( ; buf < end; buf += 64) {
+      v = vorrq_u8(vorrq_u8(vld1q_u8((const uint8_t *)buf),
+                            vld1q_u8((const uint8_t *)(buf + 16))),
+                   vorrq_u8(vld1q_u8((const uint8_t *)(buf + 32)),
+                            vld1q_u8((const uint8_t *)(buf + 48))));
+      if (vmaxvq_u8(v) != 0) {
+         return false;
+      }
+   }
+   return (len & 63) == 0 || is_buf_zero_generic(buf, len & 63);
+}
+#endif
+
+static bool is_buf_zero_select(const char *buf, int len);
+static bool (*is_buf_zero_fct)(const char *buf, int len) = is_buf_zero_select;
+
+/*
+ * Called only the first time, all the functions give the same result,
+ *  so it does not matter if two threads do the selection at the same time.
+ */
+static bool is_buf_zero_select(const char *buf, int len)
+{
+   is_buf_zero_fct = is_buf_zero_generic;
+#ifdef HAVE_ZERO_SSE2
+   is_buf_zero_fct = is_buf_zero_sse2;
+#endif
+#ifdef HAVE_ZERO_AVX2
+   __builtin_cpu_init();
+   if (__builtin_cpu_supports("avx2")) {
+      is_buf_zero_fct = is_buf_zero_avx2;
+   }
+#endif
+#ifdef HAVE_ZERO_NEON
+   is_buf_zero_fct = is_buf_zero_neon;
+#endif
+   return is_buf_zero_fct(buf, len);
+}
+
+bool is_buf_zero(const char *buf, int len)
+{
+   return is_buf_zero_fct(buf, len);
+}
+
 /*
  * Subroutine that cannot be suppressed by GCC 6.0
  */
@@ -1097,3 +1219,96 @@ bool is_offset_stream(int stream)
    }
    return false;
 }
+
+#ifdef TEST_PROGRAM
+#include "unittests.h"
+
+struct zero_bench {
+   bool (*fct)(const char *buf, int len);
+   const char *buf;
+   int len;
+   volatile bool ret;
+};
+
+static void do_zero_bench(void *arg)
+{
+   zero_bench *z = (zero_bench *)arg;
+   z->ret = z->fct(z->buf, z->len);
+}
+
+int main(int argc, char **argv)
+{
+   Unittests t("util_test");
+   const int size = 64 * 1024;
+   char *buf = (char *)malloc(size + 64);
+   zero_bench z;
+   struct {
+      const char *name;
+      bool (*fct)(const char *buf, int len);
+   } impl[] = {
+      {"generic", is_buf_zero_generic},
+#ifdef HAVE_ZERO_SSE2
+      {"sse2",    is_buf_zero_sse2},
+#endif
+#ifdef HAVE_ZERO_AVX2
+      {"avx2",    __builtin_cpu_supports("avx2") ? is_buf_zero_avx2 : NULL},
+#endif
+#ifdef HAVE_ZERO_NEON
+      {"neon",    is_buf_zero_neon},
+#endif
+      {NULL,      NULL}
+   };
+   int lens[] = {1, 7, 8, 63, 64, 65, 127, 128, 129, 1000, 4096, size - 8, size};
+   int nb_lens = sizeof(lens) / sizeof(lens[0]);
+   bool good;
+
+   memset(buf, 0, size + 64);
+   ok(is_buf_zero(buf, size), "is_buf_zero() on a zero buffer");
+   buf[size - 1] = 1;
+   nok(is_buf_zero(buf, size), "is_buf_zero() with the last byte set");
+   buf[size - 1] = 0;
+
+   /* Every implementation must find a byte set at any position, at any alignment */
+   for (int i = 0; impl[i].name; i++) {
+      if (!impl[i].fct) {
+         continue;
+      }
+      good = true;
+      for (int align = 0; align < 16; align++) {
+         for (int l = 0; l < nb_lens; l++) {
+            int len = lens[l];
+            char *p = buf + align;
+            if (!impl[i].fct(p, len)) {
+               good = false;
+            }
+            for (int pos = 0; pos < len; pos += (len < 256) ? 1 : 61) {
+               p[pos] = (char)0x80;
+               if (impl[i].fct(p, len)) {
+                  good = false;
+               }
+               p[pos] = 0;
+            }
+            p[len] = 1;         /* Just after the buffer, must be ignored */
+            if (!impl[i].fct(p, len)) {
+               good = false;
+            }
+            p[len] = 0;
+         }
+      }
+      ok(good, impl[i].name);
+   }
+
+   /* Micro benchmark on a block of zeros, the worst case */
+   for (int i = 0; impl[i].name; i++) {
+      if (!impl[i].fct) {
+         continue;
+      }
+      z.fct = impl[i].fct;
+      z.buf = buf;
+      z.len = size;
+      bench(impl[i].name, do_zero_bench, &z, 200, size);
+   }
+   free(buf);
+   return report();
+}
+#endif /* TEST_PROGRAM */
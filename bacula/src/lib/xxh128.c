@@ -0,0 +1,498 @@
+/*
+   Bacula(R) - The Network Backup Solution
+
+   Copyright (C) 2000-2020 Kern Sibbald
+
+   The original author of Bacula is Kern Sibbald, with contributions
+   from many others, a complete list can be found in the file AUTHORS.
+
+   You may use this file and others of this release according to the
+   license defined in the LICENSE file, which includes the Affero General
+   Public License, v3.0 ("AGPLv3") and some additional permissions and
+   terms pursuant to its AGPLv3 Section 7.
+
+   This notice must be preserved when any source code is
+   conveyed and/or propagated.
+
+   Bacula(R) is a registered trademark of Kern Sibbald.
+*/
+/*
+ * This code implements the 128 bit variant of the XXH3 hash
+ *  (XXH3_128bits() with the default secret and a zero seed) of
+ *  the xxHash library by Yann Collet.  It is a portable scalar
+ *  version of the algorithm, the result is the canonical (big
+ *  endian) form of the hash, identical to the one printed by
+ *  "xxhsum -H2".
+ *
+ * XXH128 is not a cryptographic digest.  It is much faster than
+ *  MD5 or SHA, and is meant to detect changes and corruptions
+ *  of the data, not to resist an attacker.
+ *
+ * To compute the hash of a chunk of bytes, declare an
+ *  XXH128Context structure, pass it to XXH128Init, call
+ *  XXH128Update as needed on buffers full of bytes, and then
+ *  call XXH128Final, which will fill a supplied 16-byte array
+ *  with the digest.
+ */
+
+#include "bacula.h"
+
+#define PRIME32_1  0x9E3779B1U
+#define PRIME32_2  0x85EBCA77U
+#define PRIME32_3  0xC2B2AE3DU
+#define PRIME64_1  0x9E3779B185EBCA87ULL
+#define PRIME64_2  0xC2B2AE3D27D4EB4FULL
+#define PRIME64_3  0x165667B19E3779F9ULL
+#define PRIME64_4  0x85EBCA77C2B2AE63ULL
+#define PRIME64_5  0x27D4EB2F165667C5ULL
+#define PRIME_MX1  0x165667919E3779F9ULL
+#define PRIME_MX2  0x9FB21C651E98DF25ULL
+
+#define STRIPE_LEN           64    /* bytes consumed by one accumulation */
+#define SECRET_CONSUME_RATE   8    /* secret bytes used by each stripe */
+#define SECRET_SIZE         192
+#define SECRET_LIMIT        (SECRET_SIZE - STRIPE_LEN)
+#define STRIPES_PER_BLOCK   (SECRET_LIMIT / SECRET_CONSUME_RATE)
+#define SECRET_LASTACC_START  7
+#define SECRET_MERGEACCS_START 11
+#define SECRET_SIZE_MIN     136
+#define MIDSIZE_MAX         240    /* longest input of the short hashes */
+#define MIDSIZE_STARTOFFSET   3
+#define MIDSIZE_LASTOFFSET   17
+
+/* Default secret of XXH3 */
+static const uint8_t kSecret[SECRET_SIZE] = {
+   0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+   0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+   0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+   0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+   0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+   0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+   0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+   0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+   0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+   0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+   0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+   0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+};
+
+struct xxh_u128 {
+   uint64_t low64;
+   uint64_t high64;
+};
+
+/* Little endian reads, the compiler turns them into simple loads */
+static inline uint32_t read_le32(const uint8_t *p)
+{
+   return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+          ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline uint64_t read_le64(const uint8_t *p)
+{
+   return (uint64_t)read_le32(p) | ((uint64_t)read_le32(p + 4) << 32);
+}
+
+static inline uint32_t swap32(uint32_t x)
+{
+   return ((x << 24) & 0xff000000) | ((x << 8) & 0x00ff0000) |
+          ((x >> 8) & 0x0000ff00) | ((x >> 24) & 0x000000ff);
+}
+
+static inline uint64_t swap64(uint64_t x)
+{
+   return ((uint64_t)swap32((uint32_t)x) << 32) | swap32((uint32_t)(x >> 32));
+}
+
+static inline uint32_t rotl32(uint32_t x, int r)
+{
+   return (x << r) | (x >> (32 - r));
+}
+
+static inline xxh_u128 mult64to128(uint64_t a, uint64_t b)
+{
+   xxh_u128 r;
+#ifdef __SIZEOF_INT128__
+   unsigned __int128 p = (unsigned __int128)a * b;
+   r.low64 = (uint64_t)p;
+   r.high64 = (uint64_t)(p >> 64);
+#else
+   uint64_t lo_lo = (a & 0xFFFFFFFF) * (b & 0xFFFFFFFF);
+   uint64_t hi_lo = (a >> 32) * (b & 0xFFFFFFFF);
+   uint64_t lo_hi = (a & 0xFFFFFFFF) * (b >> 32);
+   uint64_t hi_hi = (a >> 32) * (b >> 32);
+   uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xFFFFFFFF) + lo_hi;
+   r.high64 = (hi_lo >> 32) + (cross >> 32) + hi_hi;
+   r.low64 = (cross << 32) | (lo_lo & 0xFFFFFFFF);
+#endif
+   return r;
+}
+
+static inline uint64_t mul128_fold64(uint64_t a, uint64_t b)
+{
+   xxh_u128 r = mult64to128(a, b);
+   return r.low64 ^ r.high64;
+}
+
+static inline uint64_t xxh64_avalanche(uint64_t h)
+{
+   h ^= h >> 33;
+   h *= PRIME64_2;
+   h ^= h >> 29;
+   h *= PRIME64_3;
+   h ^= h >> 32;
+   return h;
+}
+
+static inline uint64_t avalanche(uint64_t h)
+{
+   h ^= h >> 37;
+   h *= PRIME_MX1;
+   h ^= h >> 32;
+   return h;
+}
+
+static inline uint64_t mix16B(const uint8_t *in, const uint8_t *secret)
+{
+   return mul128_fold64(read_le64(in) ^ read_le64(secret),
+                        read_le64(in + 8) ^ read_le64(secret + 8));
+}
+
+static inline xxh_u128 mix32B(xxh_u128 acc, const uint8_t *in1, const uint8_t *in2,
+                              const uint8_t *secret)
+{
+   acc.low64  += mix16B(in1, secret);
+   acc.low64  ^= read_le64(in2) + read_le64(in2 + 8);
+   acc.high64 += mix16B(in2, secret + 16);
+   acc.high64 ^= read_le64(in1) + read_le64(in1 + 8);
+   return acc;
+}
+
+/*
+ * Hash of the inputs up to MIDSIZE_MAX bytes
+ */
+static xxh_u128 hash_short(const uint8_t *in, uint32_t len)
+{
+   const uint8_t *secret = kSecret;
+   xxh_u128 h;
+
+   if (len == 0) {
+      h.low64 = xxh64_avalanche(read_le64(secret + 64) ^ read_le64(secret + 72));
+      h.high64 = xxh64_avalanche(read_le64(secret + 80) ^ read_le64(secret + 88));
+
+   } else if (len <= 3) {
+      uint32_t combinedl = ((uint32_t)in[0] << 16) | ((uint32_t)in[len >> 1] << 24) |
+                           (uint32_t)in[len - 1] | (len << 8);
+      uint32_t combinedh = rotl32(swap32(combinedl), 13);
+      uint64_t bitflipl = read_le32(secret) ^ read_le32(secret + 4);
+      uint64_t bitfliph = read_le32(secret + 8) ^ read_le32(secret + 12);
+      h.low64 = xxh64_avalanche((uint64_t)combinedl ^ bitflipl);
+      h.high64 = xxh64_avalanche((uint64_t)combinedh ^ bitfliph);
+
+   } else if (len <= 8) {
+      uint64_t input64 = read_le32(in) + ((uint64_t)read_le32(in + len - 4) << 32);
+      uint64_t bitflip = read_le64(secret + 16) ^ read_le64(secret + 24);
+      /* Shift len to the left to ensure it is even */
+      h = mult64to128(input64 ^ bitflip, PRIME64_1 + ((uint64_t)len << 2));
+      h.high64 += h.low64 << 1;
+      h.low64 ^= h.high64 >> 3;
+      h.low64 ^= h.low64 >> 35;
+      h.low64 *= PRIME_MX2;
+      h.low64 ^= h.low64 >> 28;
+      h.high64 = avalanche(h.high64);
+
+   } else if (len <= 16) {
+      uint64_t bitflipl = read_le64(secret + 32) ^ read_le64(secret + 40);
+      uint64_t bitfliph = read_le64(secret + 48) ^ read_le64(secret + 56);
+      uint64_t input_lo = read_le64(in);
+      uint64_t input_hi = read_le64(in + len - 8);
+      xxh_u128 m = mult64to128(input_lo ^ input_hi ^ bitflipl, PRIME64_1);
+      m.low64 += (uint64_t)(len - 1) << 54;
+      input_hi ^= bitfliph;
+      m.high64 += input_hi + (uint64_t)(uint32_t)input_hi * (PRIME32_2 - 1);
+      m.low64 ^= swap64(m.high64);
+      h = mult64to128(m.low64, PRIME64_2);
+      h.high64 += m.high64 * PRIME64_2;
+      h.low64 = avalanche(h.low64);
+      h.high64 = avalanche(h.high64);
+
+   } else {
+      xxh_u128 acc;
+      acc.low64 = len * PRIME64_1;
+      acc.high64 = 0;
+      if (len <= 128) {
+         if (len > 32) {
+            if (len > 64) {
+               if (len > 96) {
+                  acc = mix32B(acc, in + 48, in + len - 64, secret + 96);
+               }
+               acc = mix32B(acc, in + 32, in + len - 48, secret + 64);
+            }
+            acc = mix32B(acc, in + 16, in + len - 32, secret + 32);
+         }
+         acc = mix32B(acc, in, in + len - 16, secret);
+
+      } else {
+         uint32_t i;
+         for (i = 32; i < 160; i += 32) {
+            acc = mix32B(acc, in + i - 32, in + i - 16, secret + i - 32);
+         }
+         acc.low64 = avalanche(acc.low64);
+         acc.high64 = avalanche(acc.high64);
+         for (i = 160; i <= len; i += 32) {
+            acc = mix32B(acc, in + i - 32, in + i - 16,
+                         secret + MIDSIZE_STARTOFFSET + i - 160);
+         }
+         acc = mix32B(acc, in + len - 16, in + len - 32,
+                      secret + SECRET_SIZE_MIN - MIDSIZE_LASTOFFSET - 16);
+      }
+      h.low64 = acc.low64 + acc.high64;
+      h.high64 = acc.low64 * PRIME64_1 + acc.high64 * PRIME64_4 +
+                 (uint64_t)len * PRIME64_2;
+      h.low64 = avalanche(h.low64);
+      h.high64 = (uint64_t)0 - avalanche(h.high64);
+   }
+   return h;
+}
+
+/*
+ * Long inputs: eight accumulators fed by stripes of 64 bytes,
+ *  scrambled after each block of STRIPES_PER_BLOCK stripes.
+ */
+static inline void accumulate_512(uint64_t *acc, const uint8_t *in, const uint8_t *secret)
+{
+   for (int i = 0; i < 8; i++) {
+      uint64_t data_val = read_le64(in + 8 * i);
+      uint64_t data_key = data_val ^ read_le64(secret + 8 * i);
+      acc[i ^ 1] += data_val;
+      acc[i] += (data_key & 0xFFFFFFFF) * (data_key >> 32);
+   }
+}
+
+static inline void scramble_acc(uint64_t *acc, const uint8_t *secret)
+{
+   for (int i = 0; i < 8; i++) {
+      uint64_t a = acc[i];
+      a ^= a >> 47;
+      a ^= read_le64(secret + 8 * i);
+      a *= PRIME32_1;
+      acc[i] = a;
+   }
+}
+
+static void accumulate(uint64_t *acc, const uint8_t *in, const uint8_t *secret,
+                       uint32_t nb_stripes)
+{
+   for (uint32_t n = 0; n < nb_stripes; n++) {
+      accumulate_512(acc, in + n * STRIPE_LEN, secret + n * SECRET_CONSUME_RATE);
+   }
+}
+
+static const uint8_t *consume_stripes(uint64_t *acc, uint32_t *stripes_so_far,
+                                      const uint8_t *in, uint64_t nb_stripes)
+{
+   const uint8_t *secret = kSecret + *stripes_so_far * SECRET_CONSUME_RATE;
+
+   if (nb_stripes >= STRIPES_PER_BLOCK - *stripes_so_far) {
+      uint32_t n = STRIPES_PER_BLOCK - *stripes_so_far;
+      do {
+         accumulate(acc, in, secret, n);
+         scramble_acc(acc, kSecret + SECRET_LIMIT);
+         in += n * STRIPE_LEN;
+         nb_stripes -= n;
+         n = STRIPES_PER_BLOCK;
+         secret = kSecret;
+      } while (nb_stripes >= STRIPES_PER_BLOCK);
+      *stripes_so_far = 0;
+   }
+   if (nb_stripes > 0) {
+      accumulate(acc, in, secret, (uint32_t)nb_stripes);
+      in += nb_stripes * STRIPE_LEN;
+      *stripes_so_far += (uint32_t)nb_stripes;
+   }
+   return in;
+}
+
+static uint64_t merge_accs(const uint64_t *acc, const uint8_t *secret, uint64_t start)
+{
+   uint64_t result = start;
+   for (int i = 0; i < 4; i++) {
+      result += mul128_fold64(acc[2 * i] ^ read_le64(secret + 16 * i),
+                              acc[2 * i + 1] ^ read_le64(secret + 16 * i + 8));
+   }
+   return avalanche(result);
+}
+
+void XXH128Init(XXH128Context *ctx)
+{
+   ctx->acc[0] = PRIME32_3;
+   ctx->acc[1] = PRIME64_1;
+   ctx->acc[2] = PRIME64_2;
+   ctx->acc[3] = PRIME64_3;
+   ctx->acc[4] = PRIME64_4;
+   ctx->acc[5] = PRIME32_2;
+   ctx->acc[6] = PRIME64_5;
+   ctx->acc[7] = PRIME32_1;
+   ctx->total_len = 0;
+   ctx->stripes = 0;
+   ctx->buffered = 0;
+}
+
+/*
+ * The last bytes are always kept in the buffer, the final
+ *  stripe of a long input is hashed by XXH128Final().
+ */
+void XXH128Update(XXH128Context *ctx, const uint8_t *in, uint32_t len)
+{
+   const uint8_t *end = in + len;
+
+   ctx->total_len += len;
+   if (len <= XXH128_BUFFER_SIZE - ctx->buffered) {
+      memcpy(ctx->buffer + ctx->buffered, in, len);
+      ctx->buffered += len;
+      return;
+   }
+   if (ctx->buffered) {
+      uint32_t load = XXH128_BUFFER_SIZE - ctx->buffered;
+      memcpy(ctx->buffer + ctx->buffered, in, load);
+      in += load;
+      consume_stripes(ctx->acc, &ctx->stripes, ctx->buffer,
+                      XXH128_BUFFER_SIZE / STRIPE_LEN);
+      ctx->buffered = 0;
+   }
+   if (end - in > XXH128_BUFFER_SIZE) {
+      uint64_t nb_stripes = (uint64_t)(end - 1 - in) / STRIPE_LEN;
+      in = consume_stripes(ctx->acc, &ctx->stripes, in, nb_stripes);
+      /* Keep the last stripe, it may be needed by the final one */
+      memcpy(ctx->buffer + XXH128_BUFFER_SIZE - STRIPE_LEN, in - STRIPE_LEN, STRIPE_LEN);
+   }
+   memcpy(ctx->buffer, in, end - in);
+   ctx->buffered = (uint32_t)(end - in);
+}
+
+void XXH128Final(XXH128Context *ctx, uint8_t digest[XXH128HashSize])
+{
+   xxh_u128 h;
+
+   if (ctx->total_len > MIDSIZE_MAX) {
+      uint64_t acc[8];
+      uint8_t last_stripe[STRIPE_LEN];
+      const uint8_t *last;
+
+      memcpy(acc, ctx->acc, sizeof(acc));
+      if (ctx->buffered >= STRIPE_LEN) {
+         uint32_t stripes = ctx->stripes;
+         consume_stripes(acc, &stripes, ctx->buffer, (ctx->buffered - 1) / STRIPE_LEN);
+         last = ctx->buffer + ctx->buffered - STRIPE_LEN;
+      } else {
+         uint32_t catchup = STRIPE_LEN - ctx->buffered;
+         memcpy(last_stripe, ctx->buffer + XXH128_BUFFER_SIZE - catchup, catchup);
+         memcpy(last_stripe + catchup, ctx->buffer, ctx->buffered);
+         last = last_stripe;
+      }
+      accumulate_512(acc, last, kSecret + SECRET_LIMIT - SECRET_LASTACC_START);
+      h.low64 = merge_accs(acc, kSecret + SECRET_MERGEACCS_START,
+                           ctx->total_len * PRIME64_1);
+      h.high64 = merge_accs(acc, kSecret + SECRET_SIZE - sizeof(acc) - SECRET_MERGEACCS_START,
+                            ~(ctx->total_len * PRIME64_2));
+   } else {
+      h = hash_short(ctx->buffer, (uint32_t)ctx->total_len);
+   }
+
+   /* Canonical form, high part first, big endian */
+   for (int i = 0; i < 8; i++) {
+      digest[i] = (uint8_t)(h.high64 >> (56 - 8 * i));
+      digest[8 + i] = (uint8_t)(h.low64 >> (56 - 8 * i));
+   }
+}
+
+#ifndef TEST_PROGRAM
+#define TEST_PROGRAM_A
+#endif
+
+#ifdef TEST_PROGRAM
+#include "unittests.h"
+
+/* Generated with XXH3_128bits() of the xxHash library */
+static struct {
+   uint32_t len;
+   const char *hash;
+} vectors[] = {
+   {      0, "99aa06d3014798d86001c324468d497f" },
+   {      1, "a6cd5e9392000f6ac44bdff4074eecdb" },
+   {      3, "95c705060a313bf8a1c4a8259b827291" },
+   {      4, "afbf64f9281b8de2fde8d93ae8794d8e" },
+   {      8, "2761698c33953c430234362aaf47b71a" },
+   {      9, "0d39db6431d37a74895c8a562da51412" },
+   {     16, "29be75b0bbbb5284aafffcec5df2cb27" },
+   {     17, "db7e8f77961e47fd878751509ecfdb8b" },
+   {     65, "b6dfa5aac5c63dc2f5b4ade8de9a76a3" },
+   {    128, "ba44fd018231af4cbbe087d879edcc78" },
+   {    129, "522c922743fd67f1b8075934107218e5" },
+   {    240, "4f49ccc8526aa7ad407883ea5ef95b9a" },
+   {    241, "50b62ee1ee6455a7bc424a2c480dd281" },
+   {    256, "20d618055259b36c2d040b1ab40f0d78" },
+   {    257, "06d2f2dce7891e45d0515fbec69efb50" },
+   {   1024, "53bd178b75ab292e1fd15e7d36f5e1bc" },
+   {   1025, "d1ad5f4a3cce4374fe08e5a874d23fd2" },
+   {   4095, "c05aa920790861e82e148632549b04d3" },
+   { 100000, "18580bb0190de1db1d43ec753d462301" },
+   { 299999, "869cd99f0626a1d617361870fdc2d844" },
+};
+
+#define TEST_DATA_SIZE 300000
+
+static void hash_to_hex(uint8_t *digest, char *hex)
+{
+   for (int i = 0; i < XXH128HashSize; i++) {
+      sprintf(hex + 2 * i, "%02x", digest[i]);
+   }
+}
+
+int main()
+{
+   Unittests xxh128_test("xxh128_test");
+   uint8_t *data = (uint8_t *)malloc(TEST_DATA_SIZE);
+   uint8_t digest[XXH128HashSize];
+   char hex[2 * XXH128HashSize + 1];
+   XXH128Context ctx;
+   char label[100];
+
+   for (uint32_t i = 0; i < TEST_DATA_SIZE; i++) {
+      data[i] = (uint8_t)((i * 2654435761U) >> 13);
+   }
+
+   /* One update with all the data */
+   for (uint32_t i = 0; i < sizeof(vectors)/sizeof(vectors[0]); i++) {
+      XXH128Init(&ctx);
+      XXH128Update(&ctx, data, vectors[i].len);
+      XXH128Final(&ctx, digest);
+      hash_to_hex(digest, hex);
+      bsnprintf(label, sizeof(label), "Hash of %u bytes", vectors[i].len);
+      is(hex, vectors[i].hash, label);
+   }
+
+   /* The same data sent in pieces of various sizes */
+   const uint32_t pieces[] = { 1, 7, 63, 64, 65, 255, 256, 257, 1000, 65536 };
+   for (uint32_t p = 0; p < sizeof(pieces)/sizeof(pieces[0]); p++) {
+      for (uint32_t i = 0; i < sizeof(vectors)/sizeof(vectors[0]); i++) {
+         uint32_t done = 0;
+         XXH128Init(&ctx);
+         while (done < vectors[i].len) {
+            uint32_t len = MIN(pieces[p], vectors[i].len - done);
+            XXH128Update(&ctx, data + done, len);
+            done += len;
+         }
+         XXH128Final(&ctx, digest);
+         hash_to_hex(digest, hex);
+         if (strcmp(hex, vectors[i].hash) != 0) {
+            break;
+         }
+      }
+      bsnprintf(label, sizeof(label), "Hash with updates of %u bytes", pieces[p]);
+      is(hex, vectors[sizeof(vectors)/sizeof(vectors[0]) - 1].hash, label);
+   }
+   free(data);
+   return report();
+}
+#endif /* TEST_PROGRAM */
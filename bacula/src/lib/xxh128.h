@@ -0,0 +1,44 @@
+/*
+   Bacula(R) - The Network Backup Solution
+
+   Copyright (C) 2000-2020 Kern Sibbald
+
+   The original author of Bacula is Kern Sibbald, with contributions
+   from many others, a complete list can be found in the file AUTHORS.
+
+   You may use this file and others of this release according to the
+   license defined in the LICENSE file, which includes the Affero General
+   Public License, v3.0 ("AGPLv3") and some additional permissions and
+   terms pursuant to its AGPLv3 Section 7.
+
+   This notice must be preserved when any source code is
+   conveyed and/or propagated.
+
+   Bacula(R) is a registered trademark of Kern Sibbald.
+*/
+/*
+ * Bacula XXH128 definitions -- see xxh128.c
+ */
+
+#ifndef __BXXH128_H
+#define __BXXH128_H
+
+#define XXH128HashSize 16
+
+#define XXH128_BUFFER_SIZE 256    /* input kept between two updates */
+
+struct XXH128Context {
+   uint64_t acc[8];                  /* accumulators */
+   uint64_t total_len;               /* bytes hashed so far */
+   uint32_t stripes;                 /* stripes done in the current block */
+   uint32_t buffered;                /* bytes in buffer */
+   uint8_t  buffer[XXH128_BUFFER_SIZE];
+};
+
+typedef struct XXH128Context XXH128Context;
+
+extern void XXH128Init(XXH128Context *ctx);
+extern void XXH128Update(XXH128Context *ctx, const uint8_t *buf, uint32_t len);
+extern void XXH128Final(XXH128Context *ctx, uint8_t digest[XXH128HashSize]);
+
+#endif /* !__BXXH128_H */
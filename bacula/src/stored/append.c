@@ -151,6 +151,9 @@ bool do_append_data(JCR *jcr)
    GetMsg *qfd = dcr->dev->get_msg_queue(jcr, fd, DEDUP_MAX_MSG_SIZE);
 
    qfd->start_read_sock();
+   jcr->lock();
+   jcr->qfd = qfd;
+   jcr->unlock();
 
    for (last_file_index = 0; ok && !jcr->is_job_canceled(); ) {
       /* assume no server side deduplication at first */
@@ -235,6 +238,11 @@ fi_checked:
 
          /* Debug code: check if we must hangup or blowup */
          if (handle_hangup_blowup(jcr, jcr->JobFiles, jcr->JobBytes)) {
+            qfd->wait_read_sock(true);
+            jcr->lock();
+            jcr->qfd = NULL;
+            jcr->unlock();
+            free_GetMsg(qfd);
             fd->close();
             return false;
          }
@@ -394,6 +402,9 @@ fi_checked:
    }
    /* Must keep the dedup connection alive (and the "last" hashes buffer)
     * until the last block has been written into the volume for the vacuum */
+   jcr->lock();
+   jcr->qfd = NULL;
+   jcr->unlock();
    free_GetMsg(qfd);
 
    flush_jobmedia_queue(jcr);
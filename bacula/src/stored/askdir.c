@@ -57,6 +57,28 @@ static char OK_create[] = "1000 OK CreateJobMedia\n";
 
 static bthread_mutex_t vol_info_mutex = BTHREAD_MUTEX_PRIORITY(PRIO_SD_VOL_INFO);
 
+/*
+ * When a helper thread of the Job (the read thread of a Virtual Full)
+ *  uses the Director connection, jcr->dir_mutex is held by the job
+ *  thread while it talks to the Director, and by the helper thread
+ *  around each of its exchanges.
+ */
+static bool lock_dir_exchange(JCR *jcr)
+{
+   if (jcr->dir_mutex && !pthread_equal(pthread_self(), jcr->my_thread_id)) {
+      P(*jcr->dir_mutex);
+      return true;
+   }
+   return false;
+}
+
+static void unlock_dir_exchange(JCR *jcr, bool locked)
+{
+   if (locked) {
+      V(*jcr->dir_mutex);
+   }
+}
+
 #ifdef needed
 
 Note: if you turn this on, be sure to add the Recycle Flag
@@ -285,6 +307,7 @@ bool dir_get_volume_info(DCR *dcr,
 
    JCR *jcr = dcr->jcr;
    BSOCK *dir = jcr->dir_bsock;
+   bool locked = lock_dir_exchange(jcr);
 
    P(vol_info_mutex);
    dcr->setVolCatName(VolumeName);
@@ -295,6 +318,7 @@ bool dir_get_volume_info(DCR *dcr,
    unbash_spaces(dcr->getVolCatName());
    bool ok = do_get_volume_info(dcr);
    V(vol_info_mutex);
+   unlock_dir_exchange(jcr, locked);
    return ok;
 }
 
@@ -449,6 +473,7 @@ bool dir_update_volume_info(DCR *dcr, bool label, bool update_LastWritten,
    char ed1[50], ed2[50], ed3[50], ed4[50], ed5[50], ed6[50], ed7[50], ed8[50];
    int InChanger, Enabled, Recycle;
    bool ok = false;
+   bool locked;
    POOL_MEM VolumeName;
 
    /* If system job, do not update catalog, except if we explicitly force it. */
@@ -458,6 +483,7 @@ bool dir_update_volume_info(DCR *dcr, bool label, bool update_LastWritten,
    }
 
    /* Lock during Volume update */
+   locked = lock_dir_exchange(jcr);
    P(vol_info_mutex);
    dev->Lock_VolCatInfo();
 
@@ -569,6 +595,7 @@ bool dir_update_volume_info(DCR *dcr, bool label, bool update_LastWritten,
 bail_out:
    dev->Unlock_VolCatInfo();
    V(vol_info_mutex);
+   unlock_dir_exchange(jcr, locked);
    return ok;
 }
 
@@ -38,6 +38,7 @@ extern bool parse_sd_config(CONFIG *config, const char *configfile, int exit_cod
 
 static void do_extract(char *fname);
 static bool record_cb(DCR *dcr, DEV_RECORD *rec);
+static BSR *make_index_bsr(const char *fname);
 
 static DEVICE *dev = NULL;
 static DCR *dcr;
@@ -59,6 +60,7 @@ static POOLMEM *compress_buf;
 static int prog_name_msg = 0;
 static int win32_data_msg = 0;
 static char *VolumeName = NULL;
+static char *indexName = NULL;        /* select the files from a Volume index */
 
 static char *wbuf;                    /* write buffer address */
 static uint32_t wsize;                /* write size */
@@ -87,6 +89,7 @@ PROG_COPYRIGHT
 "       -t              read data from volume, do not write anything\n"
 "       -v              verbose\n"
 "       -V <volumes>    specify Volume names (separated by |)\n"
+"       -x <file>       read only the selected files, found in the Volume index\n"
 "       -?              print this message\n\n"), 2000, BDEMO, VERSION, BDATE);
    exit(1);
 }
@@ -116,7 +119,7 @@ int main (int argc, char *argv[])
    ff = init_find_files();
    binit(&bfd);
 
-   while ((ch = getopt(argc, argv, "Ttb:c:d:e:i:pvV:?")) != -1) {
+   while ((ch = getopt(argc, argv, "Ttb:c:d:e:i:pvV:x:?")) != -1) {
       switch (ch) {
       case 't':
          skip_extract = true;
@@ -199,6 +202,10 @@ int main (int argc, char *argv[])
          VolumeName = optarg;
          break;
 
+      case 'x':                    /* Volume index */
+         indexName = optarg;
+         break;
+
       case '?':
       default:
          usage();
@@ -213,6 +220,11 @@ int main (int argc, char *argv[])
       usage();
    }
 
+   if (indexName && bsr) {
+      Pmsg0(0, _("A Volume index cannot be used with a bootstrap file.\n"));
+      usage();
+   }
+
    if (configfile == NULL) {
       configfile = bstrdup(CONFIG_FILE);
    }
@@ -276,6 +288,14 @@ static void do_extract(char *devname)
    jcr->where = bstrdup(where);
    attr = new_attr(jcr);
 
+   /* Only the blocks of the selected files are read */
+   if (indexName) {
+      if ((bsr = make_index_bsr(indexName)) == NULL) {
+         exit(1);
+      }
+      jcr->bsr = bsr;
+   }
+
    compress_buf = get_memory(compress_buf_size);
    curr_fname = get_pool_memory(PM_FNAME);
    *curr_fname = 0;
@@ -306,6 +326,155 @@ static void do_extract(char *devname)
    return;
 }
 
+/*
+ * Files selected in a Volume index, by Job session. The data of a file
+ *  is between the block of its attributes and the block of the next
+ *  record of the session, consecutive files are put in one range.
+ */
+struct INDEX_SESSION {
+   uint32_t VolSessionId;
+   uint32_t VolSessionTime;
+   int32_t  FileIndex;                /* file being read, 0 if none */
+   uint64_t StartAddr;                /* its first block */
+   int32_t  FirstIndex;               /* files of the range, 0 if none */
+   int32_t  LastIndex;
+   uint64_t RangeStart;               /* blocks of the range */
+   uint64_t RangeEnd;
+};
+
+#define INDEX_END_ADDR ((uint64_t)0x7fffffffffffffffLL)
+
+static void flush_index_range(FILE *fp, const char *Volume, INDEX_SESSION *s, int *nb)
+{
+   if (s->FirstIndex == 0) {
+      return;
+   }
+   fprintf(fp, "Volume=\"%s\"\n"
+               "VolSessionId=%u\n"
+               "VolSessionTime=%u\n"
+               "VolAddr=%llu-%llu\n"
+               "FileIndex=%d-%d\n",
+           Volume, s->VolSessionId, s->VolSessionTime,
+           (unsigned long long)s->RangeStart, (unsigned long long)s->RangeEnd,
+           s->FirstIndex, s->LastIndex);
+   s->FirstIndex = s->LastIndex = 0;
+   (*nb)++;
+}
+
+static void end_index_file(FILE *fp, const char *Volume, INDEX_SESSION *s,
+                           uint64_t EndAddr, int *nb)
+{
+   if (s->FileIndex == 0) {
+      return;
+   }
+   if (s->FirstIndex && s->FileIndex == s->LastIndex + 1 && s->StartAddr <= s->RangeEnd) {
+      s->LastIndex = s->FileIndex;
+      s->RangeEnd = EndAddr;
+   } else {
+      flush_index_range(fp, Volume, s, nb);
+      s->FirstIndex = s->LastIndex = s->FileIndex;
+      s->RangeStart = s->StartAddr;
+      s->RangeEnd = EndAddr;
+   }
+   s->FileIndex = 0;
+}
+
+/*
+ * Create the bootstrap of the files of the include/exclude lists
+ *  with their positions in the Volume index, so the blocks of the
+ *  other files are not read.
+ */
+static BSR *make_index_bsr(const char *fname)
+{
+   VOL_INDEX *vi;
+   DEV_RECORD *rec;
+   INDEX_SESSION *s;
+   alist sessions(10, owned_by_alist);
+   POOL_MEM bsr_name(PM_FNAME);
+   BSR *root = NULL;
+   FILE *fp = NULL;
+   const char *Volume = dev->VolHdr.VolumeName;
+   int nb = 0;
+
+   if ((vi = open_vol_index(jcr, fname)) == NULL) {
+      return NULL;
+   }
+   if (strcmp(vi->VolumeName, Volume) != 0) {
+      Pmsg3(0, _("Volume index %s is for Volume \"%s\", not \"%s\".\n"),
+            fname, vi->VolumeName, Volume);
+      free_vol_index(vi);
+      return NULL;
+   }
+   Mmsg(bsr_name, "%s/bextract-%d.bsr", working_directory, (int)getpid());
+   if ((fp = bfopen(bsr_name.c_str(), "w")) == NULL) {
+      berrno be;
+      Pmsg2(0, _("Could not create bootstrap file %s. ERR=%s\n"),
+            bsr_name.c_str(), be.bstrerror());
+      free_vol_index(vi);
+      return NULL;
+   }
+   rec = new_record();
+   while (read_vol_index_record(jcr, vi, rec)) {
+      if (rec->FileIndex <= 0 && rec->FileIndex != SOS_LABEL && rec->FileIndex != EOS_LABEL) {
+         continue;
+      }
+      s = NULL;
+      foreach_alist(s, &sessions) {
+         if (s->VolSessionId == rec->VolSessionId && s->VolSessionTime == rec->VolSessionTime) {
+            break;
+         }
+      }
+      if (!s) {
+         s = (INDEX_SESSION *)malloc(sizeof(INDEX_SESSION));
+         bmemset(s, 0, sizeof(INDEX_SESSION));
+         s->VolSessionId = rec->VolSessionId;
+         s->VolSessionTime = rec->VolSessionTime;
+         sessions.append(s);
+      }
+      if (s->FileIndex != 0 && s->FileIndex != rec->FileIndex) {
+         end_index_file(fp, Volume, s, rec->Addr, &nb);
+      }
+      if (rec->FileIndex == EOS_LABEL) {
+         flush_index_range(fp, Volume, s, &nb);
+         continue;
+      }
+      if (rec->FileIndex > 0 && s->FileIndex == 0 &&
+          (rec->maskedStream == STREAM_UNIX_ATTRIBUTES ||
+           rec->maskedStream == STREAM_UNIX_ATTRIBUTES_EX)) {
+         if (!unpack_attributes_record(jcr, rec->Stream, rec->data, rec->data_len, attr)) {
+            Pmsg1(0, _("Attrib unpack error in Volume index %s.\n"), fname);
+            continue;
+         }
+         if (file_is_included(ff, attr->fname) && !file_is_excluded(ff, attr->fname)) {
+            s->FileIndex = rec->FileIndex;
+            s->StartAddr = rec->StartAddr;
+         }
+      }
+   }
+   /* Sessions that continue after the index, on this Volume or the next one */
+   foreach_alist(s, &sessions) {
+      if (s->FileIndex != 0) {
+         Pmsg3(0, _("File %d of Session %u:%u may continue on the next Volume, only this Volume is read.\n"),
+               s->FileIndex, s->VolSessionId, s->VolSessionTime);
+      }
+      end_index_file(fp, Volume, s, INDEX_END_ADDR, &nb);
+      flush_index_range(fp, Volume, s, &nb);
+   }
+   free_record(rec);
+   fclose(fp);
+   if (!vi->error) {
+      if (nb == 0) {
+         Pmsg1(0, _("No file selected in Volume index %s.\n"), fname);
+      } else {
+         Dmsg2(100, "Bootstrap %s from the Volume index, %d entries\n", bsr_name.c_str(), nb);
+         root = parse_bsr(jcr, bsr_name.c_str());
+      }
+   }
+   unlink(bsr_name.c_str());
+   free_vol_index(vi);
+   return root;
+}
+
 static bool store_data(BFILE *bfd, char *data, const int32_t length)
 {
    if (is_win32_stream(attr->data_stream) && !have_win32_api()) {
@@ -668,6 +837,7 @@ static bool record_cb(DCR *dcr, DEV_RECORD *rec)
    case STREAM_SHA1_DIGEST:
    case STREAM_SHA256_DIGEST:
    case STREAM_SHA512_DIGEST:
+   case STREAM_XXH128_DIGEST:
       break;
 
    case STREAM_SIGNED_DIGEST:
@@ -68,6 +68,7 @@ bool DCR::write_block_to_device(bool final)
    if (!is_dev_locked()) {        /* device already locked? */
       /* note, do not change this to dcr->rLock */
       dev->rLock(false);          /* no, lock it */
+      lock_wait.add(dev->last_lock_wait);
    }
 
    if (!check_for_newvol_or_newfile(dcr)) {
@@ -128,6 +129,7 @@ bool DCR::write_block_to_dev()
    uint32_t checksum;
    uint32_t pad;                      /* padding or zeros written */
    boffset_t pos;
+   btime_t wstart, wtime;             /* time spent in the write */
    char ed1[50];
 
    if (no_tape_write_test) {
@@ -226,6 +228,7 @@ bool DCR::write_block_to_dev()
    stat = 0;
    /* ***FIXME**** remove next line debug */
    pos =  dev->lseek(dcr, 0, SEEK_CUR);
+   wstart = get_current_btime();
    do {
       if (retry > 0 && stat == -1 && errno == EBUSY) {
          berrno be;
@@ -239,6 +242,9 @@ bool DCR::write_block_to_dev()
          block->adata?"Adata":"Ameta", block->BlockAddr, wlen,
          dev->VolHdr.VolumeName);
    } while (stat == -1 && (errno == EBUSY || errno == EIO) && retry++ < 3);
+   wtime = get_current_btime() - wstart;
+   dev->write_latency.add(wtime);
+   dcr->write_latency.add(wtime);
 
    /* ***FIXME*** remove 2 lines debug */
    Dmsg2(100, "Wrote %d bytes at %s\n", wlen, dev->print_addr(ed1, sizeof(ed1), pos));
@@ -329,6 +335,7 @@ bool DCR::write_block_to_dev()
    }
 
    /* We successfully wrote the block, now do housekeeping */
+   uint64_t index_addr = dev->get_full_addr();  /* block address for the Volume index */
    Dmsg2(1300, "VolCatBytes=%lld newVolCatBytes=%lld\n", dev->VolCatInfo.VolCatBytes,
       (dev->VolCatInfo.VolCatBytes+wlen));
    if (!dev->setVolCatAdataBytes(block->BlockAddr + wlen)) {
@@ -391,6 +398,10 @@ bool DCR::write_block_to_dev()
       dir_create_filemedia_record(dcr);
    }
 
+   /* Addresses as they are seen when the block is read back */
+   write_vol_index(dcr, block, index_addr,
+                   dev->is_tape() ? index_addr : index_addr + wlen - 1);
+
    dev->file_addr += wlen;            /* update file address */
    dev->file_size += wlen;
    dev->usage += wlen;                /* update usage counter */
@@ -415,6 +426,7 @@ bool DCR::read_block_from_device(bool check_block_numbers)
 
    Dmsg0(250, "Enter read_block_from_device\n");
    dev->rLock(false);
+   lock_wait.add(dev->last_lock_wait);
    ok = read_block_from_dev(check_block_numbers);
    dev->rUnlock();
    Dmsg1(250, "Leave read_block_from_device. ok=%d\n", ok);
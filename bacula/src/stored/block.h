@@ -166,6 +166,9 @@ struct DEV_BLOCK {
    POOLMEM *rechdr_queue;             /* record header queue */
    POOLMEM *buf;                      /* actual data buffer */
    alist   *filemedia;                /* Filemedia attached to the current block */
+   POOLMEM *vol_index;                /* Volume index records of the block */
+   uint32_t vol_index_len;            /* bytes used in vol_index */
+   bool     vol_index_label;          /* the block has the Volume label */
 };
 
 #define block_is_empty(block) ((block)->read_len == 0)
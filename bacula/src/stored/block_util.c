@@ -200,6 +200,12 @@ DEV_BLOCK *dup_block(DEV_BLOCK *eblock)
       block->filemedia->append(fm2);
    }
 
+   if (eblock->vol_index) {
+      block->vol_index = get_pool_memory(PM_MESSAGE);
+      block->vol_index = check_pool_memory_size(block->vol_index, eblock->vol_index_len + 1);
+      memcpy(block->vol_index, eblock->vol_index, eblock->vol_index_len);
+   }
+
 
    /* bufp might point inside buf */
    if (eblock->bufp &&
@@ -302,6 +308,9 @@ void free_block(DEV_BLOCK *block)
          free_memory(block->rechdr_queue);
       }
       delete block->filemedia;
+      if (block->vol_index) {
+         free_pool_memory(block->vol_index);
+      }
       Dmsg1(999, "=== free_block block %p\n", block);
       free_memory((POOLMEM *)block);
    }
@@ -337,6 +346,8 @@ void empty_block(DEV_BLOCK *block)
    block->RecNum = 0;
    block->BlockAddr = 0;
    block->filemedia->destroy();
+   block->vol_index_len = 0;
+   block->vol_index_label = false;
    block->extra_bytes = 0;
 }
 
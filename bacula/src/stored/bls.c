@@ -44,6 +44,7 @@ static DCR *dcr;
 static bool dump_label = false;
 static bool list_blocks = false;
 static bool list_jobs = false;
+static char *indexName = NULL;               /* read the records from a Volume index */
 static DEV_RECORD *rec;
 static JCR *jcr;
 static SESSION_LABEL sessrec;
@@ -86,6 +87,7 @@ PROG_COPYRIGHT
 "     -L                 dump label\n"
 "     -p                 proceed inspite of errors\n"
 "     -V                 specify Volume names (separated by |)\n"
+"     -x <file>          list from the Volume index file (-j or files)\n"
 "     -E                 Check records to detect errors\n"
 "     -v                 be verbose\n"
 "     -D                 Display dedup reference (to use with -v)\n"
@@ -120,7 +122,7 @@ int main (int argc, char *argv[])
 
    ff = init_find_files();
 
-   while ((ch = getopt(argc, argv, "b:c:d:e:i:jkLpvV:?EDF:")) != -1) {
+   while ((ch = getopt(argc, argv, "b:c:d:e:i:jkLpvV:x:?EDF:")) != -1) {
       switch (ch) {
       case 'b':
          bsrName = optarg;
@@ -211,6 +213,10 @@ int main (int argc, char *argv[])
          VolumeName = optarg;
          break;
 
+      case 'x':                    /* Volume index */
+         indexName = optarg;
+         break;
+
       case 'D':
          dedup = true;
          break;
@@ -237,6 +243,11 @@ int main (int argc, char *argv[])
       usage();
    }
 
+   if (indexName && (bsrName || list_blocks || argc > 1)) {
+      Pmsg0(0, _("A Volume index is used with one device and no bootstrap file, -b and -k cannot be used\n"));
+      usage();
+   }
+
    if (configfile == NULL) {
       configfile = bstrdup(CONFIG_FILE);
    }
@@ -388,7 +399,11 @@ static bool jobs_cb(DCR *dcr, DEV_RECORD *rec)
 /* Do list job records */
 static void do_jobs(char *infname)
 {
-   if (!read_records(dcr, jobs_cb, mount_next_read_volume)) {
+   if (indexName) {
+      if (!read_vol_index_records(dcr, indexName, jobs_cb)) {
+         errors++;
+      }
+   } else if (!read_records(dcr, jobs_cb, mount_next_read_volume)) {
       errors++;
    }
 }
@@ -400,7 +415,11 @@ static void do_ls(char *infname)
       dev->dump_volume_label();
       return;
    }
-   if (!read_records(dcr, record_cb, mount_next_read_volume)) {
+   if (indexName) {
+      if (!read_vol_index_records(dcr, indexName, record_cb)) {
+         errors++;
+      }
+   } else if (!read_records(dcr, record_cb, mount_next_read_volume)) {
       errors++;
    }
    printf("%u files found.\n", num_files);
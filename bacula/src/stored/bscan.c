@@ -46,7 +46,9 @@ static int  create_client_record(BDB *db, CLIENT_DBR *cr);
 static int  create_fileset_record(BDB *db, FILESET_DBR *fsr);
 static int  create_jobmedia_record(BDB *db, JCR *jcr);
 static JCR *create_jcr(JOB_DBR *jr, DEV_RECORD *rec, uint32_t JobId);
-static int update_digest_record(BDB *db, char *digest, DEV_RECORD *rec, int type);
+static int update_digest_record(JCR *mjcr, char *digest, int type);
+static void flush_cached_attribute(JCR *mjcr);
+static void *bscan_writer(void *arg);
 
 
 /* Local variables */
@@ -59,7 +61,6 @@ static POOL_DBR pr;
 static JOB_DBR jr;
 static CLIENT_DBR cr;
 static FILESET_DBR fsr;
-static ATTR_DBR ar;
 static FILE_DBR fr;
 static SESSION_LABEL label;
 static SESSION_LABEL elabel;
@@ -83,6 +84,7 @@ static const char *wd = NULL;
 static bool update_db = false;
 static bool update_vol_info = false;
 static bool list_records = false;
+static char *indexName = NULL;        /* read the records from a Volume index */
 static int ignored_msgs = 0;
 
 static uint64_t currentVolumeSize;
@@ -94,6 +96,27 @@ static int num_media = 0;
 static int num_files = 0;
 
 static CONFIG *config;
+
+/*
+ * The File records are inserted by a writer thread with the batch
+ *  connection of each Job, so the catalog inserts overlap the reading
+ *  of the Volume. The attributes of a file are kept in the Job jcr
+ *  until its digest is read, so the File record is complete when it
+ *  is inserted (no UPDATE per file).
+ */
+#define BSCAN_QUEUE_SIZE 100          /* records waiting for the writer */
+
+struct BSCAN_ITEM {
+   JCR *jcr;                          /* Job of the record, referenced */
+   ATTR_DBR ar;                       /* string pointers set by the writer */
+   int32_t attr;                      /* offsets of the strings in data */
+   int32_t link;
+   int32_t digest;                    /* 0 if no digest */
+   int32_t len;                       /* bytes used in data */
+   char data[1];                      /* fname, attr, link, digest */
+};
+
+static worker *writer = NULL;
 #define CONFIG_FILE "bacula-sd.conf"
 
 char *configfile = NULL;
@@ -122,6 +145,7 @@ PROG_COPYRIGHT
 "       -v                verbose\n"
 "       -V <Volumes>      specify Volume names (separated by |)\n"
 "       -w <dir>          specify working directory (default from conf file)\n"
+"       -x <file>         read the records from the Volume index file\n"
 "       -?                print this message\n\n"),
       2001, BDEMO, VERSION, BDATE);
    exit(1);
@@ -146,7 +170,7 @@ int main (int argc, char *argv[])
 
    OSDependentInit();
 
-   while ((ch = getopt(argc, argv, "b:c:d:D:h:o:k:e:a:mn:pP:rsSt:u:vV:w:?")) != -1) {
+   while ((ch = getopt(argc, argv, "b:c:d:D:h:o:k:e:a:mn:pP:rsSt:u:vV:w:x:?")) != -1) {
       switch (ch) {
       case 'S' :
          showProgress = true;
@@ -249,6 +273,10 @@ int main (int argc, char *argv[])
          wd = optarg;
          break;
 
+      case 'x':                    /* Volume index */
+         indexName = optarg;
+         break;
+
       case '?':
       default:
          usage();
@@ -263,6 +291,23 @@ int main (int argc, char *argv[])
       usage();
    }
 
+   if (indexName) {
+      VOL_INDEX *vi;
+      if (bsr) {
+         Pmsg0(0, _("A Volume index cannot be used with a bootstrap file.\n"));
+         usage();
+      }
+      if ((vi = open_vol_index(NULL, indexName)) == NULL) {
+         exit(1);
+      }
+      /* The Pool and Media records come from the Volume label */
+      if (!(vi->flags & VOL_INDEX_COMPLETE)) {
+         Emsg1(M_ERROR_TERM, 0, _("Volume index %s does not start at the Volume label. Cannot continue.\n"),
+            indexName);
+      }
+      free_vol_index(vi);
+   }
+
    if (configfile == NULL) {
       configfile = bstrdup(CONFIG_FILE);
    }
@@ -399,9 +444,10 @@ static bool bscan_mount_next_read_volume(DCR *dcr)
 
 static void do_scan()
 {
+   JCR *jcr;
+
    attr = new_attr(bjcr);
 
-   bmemset(&ar, 0, sizeof(ar));
    bmemset(&pr, 0, sizeof(pr));
    bmemset(&jr, 0, sizeof(jr));
    bmemset(&cr, 0, sizeof(cr));
@@ -410,9 +456,33 @@ static void do_scan()
 
    /* Detach bscan's jcr as we are not a real Job on the tape */
 
-   read_records(bjcr->read_dcr, record_cb, bscan_mount_next_read_volume);
+   if (update_db) {
+      writer = New(worker(BSCAN_QUEUE_SIZE));
+      if (writer->start(bscan_writer, NULL) != 0) {
+         Pmsg0(000, _("Could not start the catalog writer thread, inserting directly.\n"));
+         delete writer;
+         writer = NULL;
+      }
+   }
+
+   if (indexName) {
+      read_vol_index_records(bjcr->read_dcr, indexName, record_cb);
+   } else {
+      read_records(bjcr->read_dcr, record_cb, bscan_mount_next_read_volume);
+   }
 
    if (update_db) {
+      /* Jobs without End of Session label */
+      foreach_jcr(jcr) {
+         flush_cached_attribute(jcr);
+      }
+      endeach_jcr(jcr);
+      if (writer) {
+         writer->finish_work();
+         writer->stop();
+         delete writer;
+         writer = NULL;
+      }
       db_write_batch_file_records(bjcr); /* used by bulk batch file insert */
    }
    free_attr(attr);
@@ -642,6 +712,9 @@ static bool record_cb(DCR *dcr, DEV_RECORD *rec)
             break;
          }
 
+         /* The last File record of the Job */
+         flush_cached_attribute(mjcr);
+
          /* Do the final update to the Job record */
          update_job_record(db, &jr, &elabel, rec);
 
@@ -677,6 +750,7 @@ static bool record_cb(DCR *dcr, DEV_RECORD *rec)
                if (!mjcr || mjcr->JobId == 0) {
                   continue;
                }
+               flush_cached_attribute(mjcr);
                jr.JobId = mjcr->JobId;
                /* Mark Job as Error Terimined */
                jr.JobStatus = JS_ErrorTerminated;
@@ -809,7 +883,7 @@ static bool record_cb(DCR *dcr, DEV_RECORD *rec)
       if (verbose > 1) {
          Pmsg1(000, _("Got MD5 record: %s\n"), digest);
       }
-      update_digest_record(db, digest, rec, CRYPTO_DIGEST_MD5);
+      update_digest_record(mjcr, digest, CRYPTO_DIGEST_MD5);
       break;
 
    case STREAM_SHA1_DIGEST:
@@ -817,7 +891,7 @@ static bool record_cb(DCR *dcr, DEV_RECORD *rec)
       if (verbose > 1) {
          Pmsg1(000, _("Got SHA1 record: %s\n"), digest);
       }
-      update_digest_record(db, digest, rec, CRYPTO_DIGEST_SHA1);
+      update_digest_record(mjcr, digest, CRYPTO_DIGEST_SHA1);
       break;
 
    case STREAM_SHA256_DIGEST:
@@ -825,7 +899,7 @@ static bool record_cb(DCR *dcr, DEV_RECORD *rec)
       if (verbose > 1) {
          Pmsg1(000, _("Got SHA256 record: %s\n"), digest);
       }
-      update_digest_record(db, digest, rec, CRYPTO_DIGEST_SHA256);
+      update_digest_record(mjcr, digest, CRYPTO_DIGEST_SHA256);
       break;
 
    case STREAM_SHA512_DIGEST:
@@ -833,7 +907,15 @@ static bool record_cb(DCR *dcr, DEV_RECORD *rec)
       if (verbose > 1) {
          Pmsg1(000, _("Got SHA512 record: %s\n"), digest);
       }
-      update_digest_record(db, digest, rec, CRYPTO_DIGEST_SHA512);
+      update_digest_record(mjcr, digest, CRYPTO_DIGEST_SHA512);
+      break;
+
+   case STREAM_XXH128_DIGEST:
+      bin_to_base64(digest, sizeof(digest), (char *)rec->data, CRYPTO_DIGEST_XXH128_SIZE, true);
+      if (verbose > 1) {
+         Pmsg1(000, _("Got XXH128 record: %s\n"), digest);
+      }
+      update_digest_record(mjcr, digest, CRYPTO_DIGEST_XXH128);
       break;
 
    case STREAM_ENCRYPTED_SESSION_DATA:
@@ -958,18 +1040,9 @@ static void bscan_free_jcr(JCR *jcr)
 static int create_file_attributes_record(JCR *mjcr, ATTR *attrs, DEV_RECORD *rec)
 {
    DCR *dcr = mjcr->read_dcr;
-   ar.fname = attrs->fname;
-   ar.link = attrs->lname;
-   ar.ClientId = mjcr->ClientId;
-   ar.JobId = mjcr->JobId;
-   ar.Stream = rec->Stream;
-   ar.DeltaSeq = attrs->delta_seq;
-   if (attrs->type == FT_DELETED) {
-      ar.FileIndex = 0;
-   } else {
-      ar.FileIndex = rec->FileIndex;
-   }
-   ar.attr = attrs->attr;
+   BSCAN_ITEM *item;
+   int32_t len1, len2, len3;
+
    if (dcr->VolFirstIndex == 0) {
       dcr->VolFirstIndex = rec->FileIndex;
    }
@@ -980,16 +1053,108 @@ static int create_file_attributes_record(JCR *mjcr, ATTR *attrs, DEV_RECORD *rec
       return 1;
    }
 
-   if (!db_create_attributes_record(mjcr, mjcr->db, &ar)) {
-      Pmsg1(0, _("Could not create File Attributes record. ERR=%s\n"), db_strerror(mjcr->db));
-      return 0;
+   /* The previous file of this Job did not have a digest */
+   flush_cached_attribute(mjcr);
+
+   len1 = strlen(attrs->fname) + 1;
+   len2 = strlen(attrs->attr) + 1;
+   len3 = strlen(attrs->lname) + 1;
+   if (!mjcr->attr && writer) {
+      mjcr->attr = (POOLMEM *)writer->pop_free_buffer();
+   }
+   if (!mjcr->attr) {
+      mjcr->attr = get_pool_memory(PM_MESSAGE);
    }
-   mjcr->FileId = ar.FileId;
+   mjcr->attr = check_pool_memory_size(mjcr->attr, sizeof(BSCAN_ITEM) + len1 + len2 + len3);
+   item = (BSCAN_ITEM *)mjcr->attr;
+   bmemset(item, 0, sizeof(BSCAN_ITEM));
+   item->ar.ClientId = mjcr->ClientId;
+   item->ar.JobId = mjcr->JobId;
+   item->ar.Stream = rec->Stream;
+   item->ar.DeltaSeq = attrs->delta_seq;
+   if (attrs->type == FT_DELETED) {
+      item->ar.FileIndex = 0;
+   } else {
+      item->ar.FileIndex = rec->FileIndex;
+   }
+   memcpy(item->data, attrs->fname, len1);
+   item->attr = len1;
+   memcpy(item->data + item->attr, attrs->attr, len2);
+   item->link = len1 + len2;
+   memcpy(item->data + item->link, attrs->lname, len3);
+   item->len = len1 + len2 + len3;
+   mjcr->cached_attribute = true;
+   return 1;
+}
 
+/*
+ * Insert a File record, called by the writer thread, or
+ *  directly if the thread cannot be started.
+ */
+static void write_file_record(BSCAN_ITEM *item)
+{
+   JCR *mjcr = item->jcr;
+   ATTR_DBR *ar = &item->ar;
+
+   ar->fname = item->data;
+   ar->attr = item->data + item->attr;
+   ar->link = item->data + item->link;
+   ar->Digest = item->digest ? item->data + item->digest : NULL;
+   if (!db_create_attributes_record(mjcr, mjcr->db, ar)) {
+      Pmsg1(0, _("Could not create File Attributes record. ERR=%s\n"), db_strerror(mjcr->db));
+      return;
+   }
    if (verbose > 1) {
-      Pmsg1(000, _("Created File record: %s\n"), attrs->fname);
+      Pmsg1(000, _("Created File record: %s\n"), ar->fname);
    }
-   return 1;
+}
+
+/*
+ * Send the attributes kept in the Job jcr to the writer. The
+ *  writer holds a reference on the jcr until the record is inserted,
+ *  so the batch of the Job is written when the writer releases the
+ *  last reference (see bscan_free_jcr()).
+ */
+static void flush_cached_attribute(JCR *mjcr)
+{
+   BSCAN_ITEM *item;
+
+   if (!mjcr->cached_attribute) {
+      return;
+   }
+   mjcr->cached_attribute = false;
+   item = (BSCAN_ITEM *)mjcr->attr;
+   item->jcr = mjcr;
+   if (writer) {
+      mjcr->inc_use_count();
+      mjcr->attr = NULL;
+      writer->queue(item);
+   } else {
+      write_file_record(item);
+   }
+}
+
+static void *bscan_writer(void *arg)
+{
+   worker *wrk = (worker *)arg;
+   BSCAN_ITEM *item;
+
+   lmgr_init_thread();
+   wrk->set_running();
+   while (!wrk->is_quit_state()) {
+      if (wrk->is_wait_state()) {
+         wrk->wait();
+         continue;
+      }
+      if ((item = (BSCAN_ITEM *)wrk->dequeue()) == NULL) {
+         continue;
+      }
+      write_file_record(item);
+      free_jcr(item->jcr);
+      wrk->push_free_buffer(item);
+   }
+   lmgr_cleanup_thread();
+   return NULL;
 }
 
 /*
@@ -1375,37 +1540,29 @@ static int create_jobmedia_record(BDB *db, JCR *mjcr)
 }
 
 /*
- * Simulate the database call that updates the MD5/SHA1 record
+ * Add the MD5/SHA1 digest to the attributes of the current file
+ *  of the Job, the File record can then be inserted.
  */
-static int update_digest_record(BDB *db, char *digest, DEV_RECORD *rec, int type)
+static int update_digest_record(JCR *mjcr, char *digest, int type)
 {
-   JCR *mjcr;
+   BSCAN_ITEM *item;
+   int32_t len;
 
-   mjcr = get_jcr_by_session(rec->VolSessionId, rec->VolSessionTime);
-   if (!mjcr) {
-      if (mr.VolJobs > 0) {
-         Pmsg2(000, _("Could not find SessId=%d SessTime=%d for MD5/SHA1 record.\n"),
-                      rec->VolSessionId, rec->VolSessionTime);
-      } else {
-         ignored_msgs++;
-      }
-      return 0;
-   }
-
-   if (!update_db || mjcr->FileId == 0) {
-      free_jcr(mjcr);
+   if (!update_db || !mjcr->cached_attribute) {
       return 1;
    }
-
-   if (!db_add_digest_to_file_record(bjcr, db, mjcr->FileId, digest, type)) {
-      Pmsg1(0, _("Could not add MD5/SHA1 to File record. ERR=%s\n"), db_strerror(db));
-      free_jcr(mjcr);
-      return 0;
-   }
+   len = strlen(digest) + 1;
+   item = (BSCAN_ITEM *)mjcr->attr;
+   mjcr->attr = check_pool_memory_size(mjcr->attr, sizeof(BSCAN_ITEM) + item->len + len);
+   item = (BSCAN_ITEM *)mjcr->attr;
+   item->digest = item->len;
+   memcpy(item->data + item->digest, digest, len);
+   item->len += len;
+   item->ar.DigestType = type;
+   flush_cached_attribute(mjcr);
    if (verbose > 1) {
       Pmsg0(000, _("Updated MD5/SHA1 record\n"));
    }
-   free_jcr(mjcr);
    return 1;
 }
 
@@ -41,6 +41,9 @@
 
 static const int64_t dbglvl = DT_CLOUD|50;
 
+/* Protects the upload_wait histogram of the devices */
+static pthread_mutex_t upload_wait_mutex = PTHREAD_MUTEX_INITIALIZER;
+
 #define ASYNC_TRANSFER 1
 #define NUM_DOWNLOAD_WORKERS  3
 #define NUM_UPLOAD_WORKERS  3
@@ -2447,7 +2450,13 @@ bool cloud_dev::end_of_job(DCR *dcr, uint32_t truncate)
          prefix = "3000 Cloud Upload: ";
       }
       foreach_alist(tpkt, dcr->uploads) {
+         btime_t wait_start = get_current_btime();
          wait_end_of_transfer(dcr, tpkt);
+         btime_t wait_usec = get_current_btime() - wait_start;
+         dcr->upload_wait.add(wait_usec);
+         P(upload_wait_mutex);        /* the device may be locked */
+         upload_wait.add(wait_usec);
+         V(upload_wait_mutex);
          POOL_MEM umsg(PM_MESSAGE);
          tpkt->append_status(umsg);
          Jmsg(dcr->jcr, (tpkt->m_state == TRANS_STATE_ERROR) ? M_ERROR : M_INFO, 0, "%s%s", prefix, umsg.c_str());
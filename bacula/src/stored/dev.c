@@ -171,6 +171,19 @@ void DEVICE::set_mode(int new_mode)
    }
 }
 
+/*
+ * Return the queue used by the append loop to read the FD.
+ *  When a receive queue size is configured, a thread reads
+ *  ahead the network while the job thread writes the blocks.
+ */
+GetMsg *DEVICE::get_msg_queue(JCR *jcr, BSOCK *sock, int32_t bufsize)
+{
+   if (device->max_recv_queue_size > 0) {
+      return New(BufferedMsg(jcr, sock, NULL, bufsize, device->max_recv_queue_size));
+   }
+   return New(GetMsg(jcr, sock, NULL, bufsize));
+}
+
 /*
  * Called to indicate that we have just read an
  *  EOF from the device.
@@ -480,6 +493,26 @@ btime_t DEVICE::get_timer_count()
    return (temp>0)?temp:0;     /* take care of skewed clock */
 }
 
+/* Count one operation in the histogram */
+void LATENCY::add(btime_t usec)
+{
+   btime_t limit = 100;
+   int i;
+
+   if (usec < 0) {
+      usec = 0;                  /* skewed clock */
+   }
+   for (i = 0; i < LATENCY_BUCKETS - 1 && usec >= limit; i++) {
+      limit *= 10;
+   }
+   hist[i]++;
+   count++;
+   total += usec;
+   if (usec > max) {
+      max = usec;
+   }
+}
+
 /* read from fd */
 ssize_t DEVICE::read(void *buf, size_t len)
 {
@@ -616,6 +649,7 @@ void DEVICE::term(DCR *dcr)
    } else {
       close(dcr);
    }
+   close_vol_index(this);
    if (dev_name) {
       free_memory(dev_name);
       dev_name = NULL;
@@ -239,6 +239,21 @@ struct VOLUME_CAT_INFO {
    char VolCatName[MAX_NAME_LENGTH];  /* Desired volume to mount */
 };
 
+/*
+ * Histogram of the duration of an operation, the buckets are
+ *  by power of 10 from less than 100us to 10s and more.
+ */
+#define LATENCY_BUCKETS 7
+
+struct LATENCY {
+   uint64_t count;                    /* number of operations */
+   btime_t  total;                    /* total time (usec) */
+   btime_t  max;                      /* longest operation (usec) */
+   uint64_t hist[LATENCY_BUCKETS];    /* operations by duration */
+
+   void add(btime_t usec);            /* in dev.c */
+};
+
 class DEVRES;                         /* Device resource defined in stored_conf.h */
 class DCR;                            /* forward reference */
 class VOLRES;                         /* forward reference */
@@ -338,6 +353,9 @@ public:
    uint64_t min_free_space;           /* Minimum free disk space */
    int free_space_errno;              /* indicates errno getting freespace */
    bool truncating;                   /* if set, we are currently truncating */
+   int vol_index_fd;                  /* Volume index being written, see vol_index.c */
+   bool vol_index_error;              /* Volume index write error reported */
+   char vol_index_name[MAX_NAME_LENGTH]; /* Volume of vol_index_fd */
 
    utime_t  vol_poll_interval;        /* interval between polling Vol mount */
    DEVRES *device;                    /* pointer to Device Resource */
@@ -374,6 +392,13 @@ public:
    uint64_t last_stat_DevWriteBytes;
    uint64_t last_stat_DevReadBytes;
 
+   /* Updated with the device locked or blocked, see cloud_dev.c for upload_wait */
+   LATENCY write_latency;             /* block writes */
+   LATENCY lock_wait;                 /* waits to lock the device in rLock() */
+   LATENCY despool_time;              /* data spool files written to the device */
+   LATENCY upload_wait;               /* end of job waits for the cloud uploads */
+   btime_t last_lock_wait;            /* wait of the last rLock() (usec) */
+
    devstatmetrics_t devstatmetrics;    /* these are a device metrics for every device */
    bstatcollect *devstatcollector;        /* a pointer to daemon's statcollector */
 
@@ -698,8 +723,7 @@ public:
 
    virtual bool setup_dedup_rehydration_interface(DCR *dcr) { return false; };
    virtual void free_dedup_rehydration_interface(DCR *dcr) { };
-   virtual GetMsg *get_msg_queue(JCR *jcr, BSOCK *sock, int32_t bufsize)
-         { return New(GetMsg(jcr, sock, NULL, bufsize)); };
+   virtual GetMsg *get_msg_queue(JCR *jcr, BSOCK *sock, int32_t bufsize); /* in dev.c */
    virtual void *dedup_get_dedupengine() { return NULL; };
    virtual void dedup_get_status(STATUS_PKT *sp, int options) { };
    virtual bool dedup_cmd(JCR *jcr) { return false; };
@@ -781,6 +805,10 @@ public:
    uint64_t FileMedia_Off;            /* Last File Offset used to generate a FileMedia record */
    uint64_t max_index_size;           /* Max amount of data between two indexes */
    uint64_t index_size;               /* Amount of data without index */
+   LATENCY write_latency;             /* block writes of this job */
+   LATENCY lock_wait;                 /* waits to lock or block the device */
+   LATENCY despool_time;              /* data spool files written to the device */
+   LATENCY upload_wait;               /* end of job waits for the cloud uploads */
 
 
    uint32_t VolFirstIndex;            /* First file index this Volume */
@@ -838,7 +866,8 @@ public:
    bool is_virtual_autochanger();
 
    /* Methods in lock.c */
-   void dblock(int why) { dev->dblock(why); }
+   /* The device stays blocked by us, nobody else can set last_lock_wait */
+   void dblock(int why) { dev->dblock(why); lock_wait.add(dev->last_lock_wait); }
 
    /* Methods in record.c */
    bool write_record(DEV_RECORD *rec);
@@ -209,6 +209,8 @@ void DEVICE::Unlock()
 #ifdef DEV_DEBUG_LOCK
 void DEVICE::dbg_rLock(const char *file, int line, bool locked)
 {
+   btime_t start = get_current_btime();
+
    Dmsg3(sd_dbglvl, "Enter rLock blked=%s from %s:%d\n", print_blocked(),
          file, line);
    if (!locked) {
@@ -234,11 +236,15 @@ void DEVICE::dbg_rLock(const char *file, int line, bool locked)
       }
       num_waiting--;             /* no longer waiting */
    }
+   last_lock_wait = get_current_btime() - start;
+   lock_wait.add(last_lock_wait);
 }
 #else /* DEV_DEBUG_LOCK */
 
 void DEVICE::rLock(bool locked)
 {
+   btime_t start = get_current_btime();
+
    if (!locked) {
       Lock();
       m_count++;
@@ -259,6 +265,8 @@ void DEVICE::rLock(bool locked)
       }
       num_waiting--;             /* no longer waiting */
    }
+   last_lock_wait = get_current_btime() - start;
+   lock_wait.add(last_lock_wait);
 }
 
 #endif  /* DEV_DEBUG_LOCK */
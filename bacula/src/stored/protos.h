@@ -277,6 +277,19 @@ void    _dbg_list_one_device(DEVICE *dev, const char *f, int l);
 #define dbg_list_one_device(x, dev) if (chk_dbglvl(x))     \
         _dbg_list_one_device(dev, __FILE__, __LINE__)
 
+/* From vbackup.c */
+int      get_read_queue_status(JCR *jcr, POOLMEM *&buf);
+
+/* From vol_index.c */
+void    add_vol_index_record(DCR *dcr, DEV_BLOCK *block, DEV_RECORD *rec);
+void    write_vol_index(DCR *dcr, DEV_BLOCK *block, uint64_t StartAddr, uint64_t Addr);
+void    close_vol_index(DEVICE *dev);
+VOL_INDEX *open_vol_index(JCR *jcr, const char *fname);
+void    free_vol_index(VOL_INDEX *vi);
+bool    read_vol_index_record(JCR *jcr, VOL_INDEX *vi, DEV_RECORD *rec);
+bool    read_vol_index_records(DCR *dcr, const char *fname,
+           bool record_cb(DCR *dcr, DEV_RECORD *rec));
+
 /* From vol_mgr.c */
 void    init_vol_list_lock();
 void    term_vol_list_lock();
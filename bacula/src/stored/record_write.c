@@ -81,6 +81,9 @@ static bool write_header_to_block(DCR *dcr, DEV_BLOCK *block, DEV_RECORD *rec)
    /* See if we create a FileMedia record for this record */
    create_filemedia(dcr, block, rec);
 
+   /* Keep the record for the Volume index */
+   add_vol_index_record(dcr, block, rec);
+
    block->RecNum++;
    rec->remlen -= WRITE_RECHDR_LENGTH;
    rec->remainder = rec->data_len;
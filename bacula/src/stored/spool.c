@@ -37,6 +37,7 @@ static bool close_attr_spool_file(JCR *jcr, BSOCK *bs);
 static ssize_t write_spool_header(DCR *dcr, ssize_t *expected);
 static ssize_t write_spool_data(DCR *dcr, ssize_t *expected);
 static ssize_t write_spool_filemedia(DCR *dcr, ssize_t *expected);
+static ssize_t write_spool_vol_index(DCR *dcr, ssize_t *expected);
 static bool write_spool_block(DCR *dcr);
 
 struct spool_stats_t {
@@ -60,6 +61,7 @@ struct spool_hdr {
    int32_t  LastIndex;                /* LastIndex for buffer */
    uint32_t len;                      /* length of next buffer */
    uint32_t nbFileMedia;              /* Number of File Media after the block */
+   uint32_t vol_index_len;            /* Volume index records after the File Media */
 };
 
 enum {
@@ -250,6 +252,7 @@ static bool despool_data(DCR *dcr, bool commit)
 
    /* Add run time, to get current wait time */
    int32_t despool_start = time(NULL) - jcr->run_time;
+   btime_t despool_begin = get_current_btime();
 
    set_new_file_parameters(dcr);
 
@@ -302,6 +305,11 @@ static bool despool_data(DCR *dcr, bool commit)
          despool_elapsed / 3600, despool_elapsed % 3600 / 60, despool_elapsed % 60,
          edit_uint64_with_suffix(jcr->dcr->job_spool_size / despool_elapsed, ec1));
 
+   /* The device is still blocked by us */
+   btime_t despool_usec = get_current_btime() - despool_begin;
+   dcr->despool_time.add(despool_usec);
+   dcr->dev->despool_time.add(despool_usec);
+
    dcr->block = block;                /* reset block */
 
 #if defined(HAVE_POSIX_FADVISE) && defined(POSIX_FADV_DONTNEED)
@@ -414,6 +422,22 @@ static int read_block_from_spool_file(DCR *dcr)
       }
       block->filemedia->append(fm);
    }
+
+   /* And the records of the Volume index */
+   if (hdr.vol_index_len > 0) {
+      if (!block->vol_index) {
+         block->vol_index = get_pool_memory(PM_MESSAGE);
+      }
+      block->vol_index = check_pool_memory_size(block->vol_index, hdr.vol_index_len);
+      stat = read(dcr->spool_fd, block->vol_index, hdr.vol_index_len);
+      if (stat != (ssize_t)hdr.vol_index_len) {
+         Pmsg2(000, _("Spool data read error. Wanted %u bytes, got %d\n"), hdr.vol_index_len, stat);
+         Jmsg2(dcr->jcr, M_FATAL, 0, _("Spool data read error. Wanted %u bytes, got %d\n"), hdr.vol_index_len, stat);
+         jcr->forceJobStatus(JS_FatalError);  /* override any Incomplete */
+         return RB_ERROR;
+      }
+   }
+   block->vol_index_len = hdr.vol_index_len;
    Dmsg2(800, "Read block FI=%d LI=%d\n", block->FirstIndex, block->LastIndex);
    return RB_OK;
 }
@@ -561,6 +585,18 @@ static bool write_spool_block(DCR *dcr)
          size += ret;
       }
 
+      if (ret != expected) {
+         continue;
+      }
+
+      ret = write_spool_vol_index(dcr, &expected);
+      if (ret == -1) {
+         goto bail_out;
+
+      } else {
+         size += ret;
+      }
+
       if (ret != expected) {
          continue;
       }
@@ -584,6 +620,7 @@ static ssize_t write_spool_header(DCR *dcr, ssize_t *expected)
    hdr.LastIndex = block->LastIndex;
    hdr.len = block->binbuf;
    hdr.nbFileMedia = block->filemedia->size();
+   hdr.vol_index_len = block->vol_index_len;
    *expected = sizeof(hdr);
 
    /* Write header */
@@ -611,6 +648,16 @@ static ssize_t write_spool_filemedia(DCR *dcr, ssize_t *expected)
    return sum;
 }
 
+static ssize_t write_spool_vol_index(DCR *dcr, ssize_t *expected)
+{
+   DEV_BLOCK *block = dcr->block;
+   *expected = block->vol_index_len;
+   if (block->vol_index_len == 0) {
+      return 0;
+   }
+   return write(dcr->spool_fd, block->vol_index, (size_t)block->vol_index_len);
+}
+
 static ssize_t write_spool_data(DCR *dcr, ssize_t *expected)
 {
    DEV_BLOCK *block = dcr->block;
@@ -197,6 +197,61 @@ void list_shstore(DEVICE *dev, OutputWriter *ow) {}
 bool list_shstore(DEVICE *dev, POOLMEM **msg, int *len) { return false;}
 #endif
 
+/* Upper bound of the buckets of a LATENCY histogram */
+static const char *latency_text[LATENCY_BUCKETS] = {
+   "<100us", "<1ms", "<10ms", "<100ms", "<1s", "<10s", ">=10s"
+};
+static const char *latency_keys[LATENCY_BUCKETS] = {
+   "100us", "1ms", "10ms", "100ms", "1s", "10s", "more"
+};
+
+/*
+ * Send one line for a latency histogram when something was measured
+ */
+static void send_latency(STATUS_PKT *sp, const char *name, LATENCY *lat)
+{
+   POOL_MEM msg(PM_MESSAGE);
+   char b1[50], b2[50], b3[50];
+   uint64_t count = lat->count;
+   int len;
+
+   if (count == 0) {
+      return;
+   }
+   Mmsg(msg, _("    %s: count=%s avg=%sus max=%sus"), name,
+              edit_uint64_with_commas(count, b1),
+              edit_uint64_with_commas(lat->total / count, b2),
+              edit_uint64_with_commas(lat->max, b3));
+   for (int i = 0; i < LATENCY_BUCKETS; i++) {
+      pm_strcat(msg, " ");
+      pm_strcat(msg, latency_text[i]);
+      pm_strcat(msg, "=");
+      pm_strcat(msg, edit_uint64(lat->hist[i], b1));
+   }
+   pm_strcat(msg, "\n");
+   len = strlen(msg.c_str());
+   sendit(msg, len, sp);
+}
+
+/*
+ * Add the fields of a latency histogram to the current object
+ */
+static void api_latency(OutputWriter *ow, const char *name, LATENCY *lat)
+{
+   char key[64];
+
+   bsnprintf(key, sizeof(key), "%s_count", name);
+   ow->get_output(OT_PINT64, key, lat->count, OT_END);
+   bsnprintf(key, sizeof(key), "%s_total", name);
+   ow->get_output(OT_INT64, key, (int64_t)lat->total, OT_END);
+   bsnprintf(key, sizeof(key), "%s_max", name);
+   ow->get_output(OT_INT64, key, (int64_t)lat->max, OT_END);
+   for (int i = 0; i < LATENCY_BUCKETS; i++) {
+      bsnprintf(key, sizeof(key), "%s_%s", name, latency_keys[i]);
+      ow->get_output(OT_PINT64, key, lat->hist[i], OT_END);
+   }
+}
+
 static void api_list_one_device(char *name, DEVICE *dev, STATUS_PKT *sp)
 {
    OutputWriter ow(sp->api_opts);
@@ -305,6 +360,11 @@ static void api_list_one_device(char *name, DEVICE *dev, STATUS_PKT *sp)
                     OT_END);
    }
 
+   api_latency(&ow, "write_latency", &dev->write_latency);
+   api_latency(&ow, "lock_wait", &dev->lock_wait);
+   api_latency(&ow, "despool_time", &dev->despool_time);
+   api_latency(&ow, "upload_wait", &dev->upload_wait);
+
    list_shstore(dev, &ow);
 
    p = ow.get_output(OT_END_OBJ, OT_END);
@@ -403,6 +463,11 @@ static void list_one_device(char *name, DEVICE *dev, STATUS_PKT *sp)
       }
    }
 
+   send_latency(sp, _("Write latency"), &dev->write_latency);
+   send_latency(sp, _("Lock wait"), &dev->lock_wait);
+   send_latency(sp, _("Despool time"), &dev->despool_time);
+   send_latency(sp, _("Upload wait"), &dev->upload_wait);
+
    if (list_shstore(dev, msg.handle(), &len)) {
       sendit(msg, len, sp);
    }
@@ -792,6 +857,7 @@ static void api_list_running_jobs(STATUS_PKT *sp)
 {
    char *p1, *p2, *p3;
    int i1, i2, i3;
+   LATENCY lat;
    OutputWriter ow(sp->api_opts);
 
    uint64_t inst_bps, total_bps;
@@ -860,6 +926,14 @@ static void api_list_running_jobs(STATUS_PKT *sp)
                     OT_INT,     "despool_wait",  i3,
                     OT_END);
 
+      /* Same keys for all the jobs, zero when a device is not used */
+      memset(&lat, 0, sizeof(lat));
+      api_latency(&ow, "write_latency", (dcr && dcr->device) ? &dcr->write_latency : &lat);
+      api_latency(&ow, "lock_wait", (dcr && dcr->device) ? &dcr->lock_wait : &lat);
+      api_latency(&ow, "despool_time", (dcr && dcr->device) ? &dcr->despool_time : &lat);
+      api_latency(&ow, "upload_wait", (dcr && dcr->device) ? &dcr->upload_wait : &lat);
+      api_latency(&ow, "read_lock_wait", (rdcr && rdcr->device) ? &rdcr->lock_wait : &lat);
+
       if (jcr->last_time == 0) {
          jcr->last_time = jcr->run_time;
       }
@@ -1003,6 +1077,23 @@ static void list_running_jobs(STATUS_PKT *sp)
             jcr->LastJobBytes = jcr->JobBytes;
             jcr->last_time = now;
          }
+         if (dcr && dcr->device) {
+            send_latency(sp, _("Write latency"), &dcr->write_latency);
+            send_latency(sp, _("Lock wait"), &dcr->lock_wait);
+            send_latency(sp, _("Despool time"), &dcr->despool_time);
+            send_latency(sp, _("Upload wait"), &dcr->upload_wait);
+         }
+         if (rdcr && rdcr->device) {
+            send_latency(sp, _("Read lock wait"), &rdcr->lock_wait);
+         }
+         jcr->lock();
+         if (jcr->qfd && (len = jcr->qfd->get_status(msg.addr())) > 0) {
+            sendit(msg, len, sp);
+         }
+         if (jcr->read_queue && (len = get_read_queue_status(jcr, msg.addr())) > 0) {
+            sendit(msg, len, sp);
+         }
+         jcr->unlock();
          found = true;
 #ifdef DEBUG
          if (jcr->file_bsock) {
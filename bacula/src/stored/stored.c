@@ -455,6 +455,14 @@ static int check_resources()
          }
       }
       store->psk_ctx = new_psk_context(NULL); /* shared key generated by DIR */
+      /* Only the data connections with the FD and the SD use these contexts */
+      if (store->tls_kernel_offload) {
+         if (!set_tls_kernel_offload(store->tls_ctx, true) ||
+             !set_tls_kernel_offload(store->psk_ctx, true)) {
+            Jmsg(NULL, M_WARNING, 0, _("TLS Kernel Offload is not supported by this TLS library for Storage \"%s\" in %s.\n"),
+                 store->hdr.name, configfile);
+         }
+      }
       /* In this case, we have TLS Require=Yes and TLS not setup and no PSK */
       if (OK && tls_needed == false && store->tls_require) {
          if (!store->psk_ctx) {
@@ -71,6 +71,7 @@ const int sd_dbglvl = 300;
 #include "bsr.h"
 #include "jcr.h"
 #include "vol_mgr.h"
+#include "vol_index.h"
 #include "reserve.h"
 #include "protos.h"
 #include "dedupstored.h"
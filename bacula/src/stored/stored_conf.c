@@ -82,6 +82,7 @@ static RES_ITEM store_items[] = {
    {"TlsEnable",             store_bool,    ITEM(res_store.tls_enable), 0, 0, 0},
    {"TlsPskEnable",          store_bool,    ITEM(res_store.tls_psk_enable), 0, ITEM_DEFAULT, tls_psk_default},
    {"TlsRequire",            store_bool,    ITEM(res_store.tls_require), 0, 0, 0},
+   {"TlsKernelOffload",      store_bool,    ITEM(res_store.tls_kernel_offload), 0, ITEM_DEFAULT, 0},
    {"TlsVerifyPeer",         store_bool,    ITEM(res_store.tls_verify_peer), 1, ITEM_DEFAULT, 1},
    {"TlsCaCertificateFile",  store_dir,       ITEM(res_store.tls_ca_certfile), 0, 0, 0},
    {"TlsCaCertificateDir",   store_dir,       ITEM(res_store.tls_ca_certdir), 0, 0, 0},
@@ -165,6 +166,8 @@ static RES_ITEM dev_items[] = {
    {"MaximumChangerWait",    store_time,   ITEM(res_dev.max_changer_wait), 0, ITEM_DEFAULT, 5 * 60},
    {"MaximumOpenWait",       store_time,   ITEM(res_dev.max_open_wait), 0, ITEM_DEFAULT, 5 * 60},
    {"MaximumNetworkBufferSize", store_pint32, ITEM(res_dev.max_network_buffer_size), 0, 0, 0},
+   {"MaximumReceiveQueueSize", store_size32, ITEM(res_dev.max_recv_queue_size), 0, 0, 0},
+   {"MaximumReadQueueSize",  store_size32, ITEM(res_dev.max_read_queue_size), 0, 0, 0},
    {"VolumePollInterval",    store_time,   ITEM(res_dev.vol_poll_interval), 0, ITEM_DEFAULT, 5 * 60},
    {"MaximumRewindWait",     store_time,   ITEM(res_dev.max_rewind_wait), 0, ITEM_DEFAULT, 5 * 60},
    {"MinimumBlockSize",      store_size32, ITEM(res_dev.min_block_size), 0, 0, 0},
@@ -179,6 +182,7 @@ static RES_ITEM dev_items[] = {
    {"MinimumFeeSpace",       store_size64, ITEM(res_dev.min_free_space), 0, ITEM_DEFAULT, 5000000},
    {"MaximumConcurrentJobs", store_pint32, ITEM(res_dev.max_concurrent_jobs), 0, 0, 0},
    {"SpoolDirectory",        store_dir,    ITEM(res_dev.spool_directory), 0, 0, 0},
+   {"VolumeIndexDirectory",  store_dir,    ITEM(res_dev.vol_index_directory), 0, 0, 0},
    {"MaximumSpoolSize",      store_size64, ITEM(res_dev.max_spool_size), 0, 0, 0},
    {"MaximumJobSpoolSize",   store_size64, ITEM(res_dev.max_job_spool_size), 0, 0, 0},
    {"DriveIndex",            store_pint32, ITEM(res_dev.drive_index), 0, 0, 0},
@@ -619,6 +623,7 @@ void dump_resource(int type, RES *rres, void sendit(void *sock, const char *fmt,
       sendit(sock, "        max_file_size=%lld capacity=%lld\n",
          res->res_dev.max_file_size, res->res_dev.volume_capacity);
       sendit(sock, "        spool_directory=%s\n", NPRT(res->res_dev.spool_directory));
+      sendit(sock, "        vol_index_directory=%s\n", NPRT(res->res_dev.vol_index_directory));
       sendit(sock, "        max_spool_size=%lld max_job_spool_size=%lld\n",
          res->res_dev.max_spool_size, res->res_dev.max_job_spool_size);
       if (res->res_dev.worm_command) {
@@ -934,6 +939,9 @@ void free_resource(RES *sres, int type)
       if (res->res_dev.spool_directory) {
          free(res->res_dev.spool_directory);
       }
+      if (res->res_dev.vol_index_directory) {
+         free(res->res_dev.vol_index_directory);
+      }
       if (res->res_dev.mount_point) {
          free(res->res_dev.mount_point);
       }
@@ -173,6 +173,7 @@ public:
    bool tls_enable;                   /* Enable TLS */
    bool tls_psk_enable;               /* Enable TLS-PSK */
    bool tls_require;                  /* Require TLS */
+   bool tls_kernel_offload;           /* Use kernel TLS with the FD/SD if possible */
    bool tls_verify_peer;              /* TLS Verify Client Certificate */
    char *tls_ca_certfile;             /* TLS CA Certificate File */
    char *tls_ca_certdir;              /* TLS CA Certificate Directory */
@@ -217,6 +218,7 @@ public:
    char *lock_command;                /* Share storage lock command -- external program */
    char *worm_command;                /* Worm detection command -- external program */
    char *spool_directory;             /* Spool file directory */
+   char *vol_index_directory;         /* Volume index directory */
    uint32_t dev_type;                 /* device type */
    uint32_t label_type;               /* label type */
    bool enabled;                      /* Set when enabled (default) */
@@ -234,6 +236,8 @@ public:
    uint32_t max_block_size;           /* max block size */
    uint32_t max_volume_jobs;          /* max jobs to put on one volume */
    uint32_t max_network_buffer_size;  /* max network buf size */
+   uint32_t max_recv_queue_size;      /* memory for the data read ahead from the FD */
+   uint32_t max_read_queue_size;      /* memory for the records read ahead by a Virtual Full */
    uint32_t max_concurrent_jobs;      /* maximum concurrent jobs this drive */
    utime_t  vol_poll_interval;        /* interval between polling volume during mount */
    int64_t max_volume_files;          /* max files to put on one volume */
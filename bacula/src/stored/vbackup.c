@@ -29,8 +29,39 @@
 /* Import functions */
 extern char Job_end[];
 
+/*
+ * Records read ahead of the writes. A thread runs read_records()
+ *  on the read device and queues the records selected by the BSR,
+ *  in the order of the Volumes, while the job thread writes them.
+ *  Only one of the two threads talks to the Director at a time, the
+ *  reader takes dir_mutex only around its requests (see askdir.c),
+ *  so the writes continue while it changes Volumes.
+ */
+struct RECORD_QUEUE {
+   JCR *jcr;
+   DCR *dcr;                          /* read device */
+   pthread_t thread;
+   pthread_mutex_t mutex;             /* protects the fields below */
+   pthread_cond_t cond;
+   dlist *recs;                       /* records read, not yet written */
+   int64_t bytes;                     /* memory used by the records */
+   int64_t max_bytes;                 /* memory limit of the queue */
+   int64_t max_used;                  /* highest memory used */
+   uint32_t full_waits;               /* reader waited for the writer */
+   uint32_t empty_waits;              /* writer waited for the reader */
+   bool done;                         /* read_records() returned */
+   bool read_ok;                      /* what it returned */
+   bool quit;                         /* set to stop the reader */
+   pthread_mutex_t dir_mutex;         /* held to talk to the Director (jcr->dir_mutex) */
+};
+
 /* Forward referenced subroutines */
 static bool record_cb(DCR *dcr, DEV_RECORD *rec);
+static bool select_record(JCR *jcr, DEV_RECORD *rec);
+static bool write_vbackup_record(DCR *dcr, DEV_RECORD *rec);
+static RECORD_QUEUE *start_read_queue(JCR *jcr);
+static bool write_queued_records(JCR *jcr, RECORD_QUEUE *q);
+static bool stop_read_queue(JCR *jcr, RECORD_QUEUE *q);
 
 /*
  *  Read Data and send to File Daemon
@@ -44,6 +75,7 @@ bool do_vbackup(JCR *jcr)
    const char *Type;
    char ec1[50];
    DEVICE *dev;
+   RECORD_QUEUE *q;
 
    switch(jcr->getJobType()) {
    case JT_MIGRATE:
@@ -109,7 +141,12 @@ bool do_vbackup(JCR *jcr)
    jcr->JobFiles = 0;
    jcr->dcr->set_ameta();
    jcr->read_dcr->set_ameta();
-   ok = read_records(jcr->read_dcr, record_cb, mount_next_read_volume);
+   if ((q = start_read_queue(jcr)) != NULL) {
+      ok = write_queued_records(jcr, q);
+      ok = stop_read_queue(jcr, q) && ok;
+   } else {
+      ok = read_records(jcr->read_dcr, record_cb, mount_next_read_volume);
+   }
    goto ok_out;
 
 bail_out:
@@ -208,18 +245,23 @@ ok_out:
  */
 static bool record_cb(DCR *dcr, DEV_RECORD *rec)
 {
-   JCR *jcr = dcr->jcr;
-   DEVICE *dev = jcr->dcr->dev;
-   char buf1[100], buf2[100];
-   bool     restoredatap = false;
-   POOLMEM *orgdata = NULL;
-   uint32_t orgdata_len = 0;
-   bool ret = false;
+   if (!select_record(dcr->jcr, rec)) {
+      return true;
+   }
+   return write_vbackup_record(dcr, rec);
+}
 
+/*
+ * Discard the records that are not copied, and give the
+ *  others their output FileIndex.
+ *  Returns: true if the record must be written
+ *           false if it is discarded
+ */
+static bool select_record(JCR *jcr, DEV_RECORD *rec)
+{
    /* If label and not for us, discard it */
    if (rec->FileIndex < 0 && rec->match_stat <= 0) {
-      ret = true;
-      goto bail_out;
+      return false;
    }
    /* We want to write SOS_LABEL and EOS_LABEL discard all others */
    switch (rec->FileIndex) {
@@ -227,8 +269,7 @@ static bool record_cb(DCR *dcr, DEV_RECORD *rec)
    case VOL_LABEL:
    case EOT_LABEL:
    case EOM_LABEL:
-      ret = true;                    /* don't write vol labels */
-      goto bail_out;
+      return false;                  /* don't write vol labels */
    }
 
    /*
@@ -251,6 +292,24 @@ static bool record_cb(DCR *dcr, DEV_RECORD *rec)
       }
       rec->FileIndex = jcr->JobFiles;     /* set sequential output FileIndex */
    }
+   return true;
+}
+
+/*
+ * Write a selected record to the output device and send its
+ *  attributes to the Director
+ *  Returns: true if OK
+ *           false if error
+ */
+static bool write_vbackup_record(DCR *dcr, DEV_RECORD *rec)
+{
+   JCR *jcr = dcr->jcr;
+   DEVICE *dev = jcr->dcr->dev;
+   char buf1[100], buf2[100];
+   bool     restoredatap = false;
+   POOLMEM *orgdata = NULL;
+   uint32_t orgdata_len = 0;
+   bool ret = false;
 
    /* TODO: If user really wants to do rehydrate the data, we should propose
     * this option.
@@ -323,3 +382,225 @@ bail_out:
    }
    return ret;
 }
+
+/*
+ * Read thread callback, queue a copy of the selected records
+ */
+static bool queue_record_cb(DCR *dcr, DEV_RECORD *rec)
+{
+   RECORD_QUEUE *q = dcr->jcr->read_queue;
+   DEV_RECORD *item;
+   POOLMEM *data;
+   int32_t size;
+   bool ok;
+
+   if (!select_record(dcr->jcr, rec)) {
+      return true;
+   }
+   item = new_record();
+   data = item->data;
+   memcpy(item, rec, sizeof(DEV_RECORD));
+   item->data = check_pool_memory_size(data, rec->data_len);
+   memcpy(item->data, rec->data, rec->data_len);
+   size = sizeof(DEV_RECORD) + sizeof_pool_memory(item->data);
+
+   P(q->mutex);
+   while (!q->quit && q->bytes > 0 && q->bytes + size > q->max_bytes) {
+      q->full_waits++;
+      pthread_cond_wait(&q->cond, &q->mutex);
+   }
+   ok = !q->quit;
+   if (ok) {
+      q->recs->append(item);
+      q->bytes += size;
+      if (q->bytes > q->max_used) {
+         q->max_used = q->bytes;
+      }
+      pthread_cond_broadcast(&q->cond);
+   }
+   V(q->mutex);
+   if (!ok) {
+      free_record(item);
+   }
+   return ok;
+}
+
+extern "C" void *vbackup_read_thread(void *arg)
+{
+   RECORD_QUEUE *q = (RECORD_QUEUE *)arg;
+   bool ok;
+
+   set_jcr_in_tsd(q->jcr);
+   ok = read_records(q->dcr, queue_record_cb, mount_next_read_volume);
+   P(q->mutex);
+   q->read_ok = ok;
+   q->done = true;
+   pthread_cond_broadcast(&q->cond);
+   V(q->mutex);
+   return NULL;
+}
+
+static void free_read_queue(JCR *jcr, RECORD_QUEUE *q)
+{
+   DEV_RECORD *rec;
+
+   jcr->queue_helper_msgs = false;
+   jcr->dir_mutex = NULL;
+   jcr->lock();
+   jcr->read_queue = NULL;
+   jcr->unlock();
+   while ((rec = (DEV_RECORD *)q->recs->first()) != NULL) {
+      q->recs->remove(rec);
+      free_record(rec);
+   }
+   delete q->recs;
+   pthread_cond_destroy(&q->cond);
+   pthread_mutex_destroy(&q->mutex);
+   pthread_mutex_destroy(&q->dir_mutex);
+   free(q);
+}
+
+/*
+ * Start the read thread when a read queue size is configured
+ *  for the read device.
+ *  Returns: the queue of the records
+ *           NULL if the job thread must read the records itself
+ */
+static RECORD_QUEUE *start_read_queue(JCR *jcr)
+{
+   DEV_RECORD *rec = NULL;
+   RECORD_QUEUE *q;
+   int stat;
+
+   /* The rehydration of the dedup records uses the read device */
+   if (jcr->read_dcr->device->max_read_queue_size == 0 ||
+       jcr->read_dcr->device->dev_type == B_DEDUP_DEV) {
+      return NULL;
+   }
+   q = (RECORD_QUEUE *)malloc(sizeof(RECORD_QUEUE));
+   memset(q, 0, sizeof(RECORD_QUEUE));
+   q->jcr = jcr;
+   q->dcr = jcr->read_dcr;
+   q->max_bytes = jcr->read_dcr->device->max_read_queue_size;
+   q->recs = New(dlist(rec, &rec->link));
+   pthread_mutex_init(&q->mutex, NULL);
+   pthread_mutex_init(&q->dir_mutex, NULL);
+   pthread_cond_init(&q->cond, NULL);
+
+   jcr->lock();
+   jcr->read_queue = q;
+   jcr->unlock();
+   jcr->queue_helper_msgs = true;
+   jcr->dir_mutex = &q->dir_mutex;
+   if ((stat = pthread_create(&q->thread, NULL, vbackup_read_thread, (void *)q)) != 0) {
+      berrno be;
+      free_read_queue(jcr, q);
+      Jmsg1(jcr, M_WARNING, 0, _("Cannot start the read ahead thread. ERR=%s\n"),
+            be.bstrerror(stat));
+      return NULL;
+   }
+   return q;
+}
+
+/*
+ * Write the records queued by the read thread, in the order they
+ *  were read.
+ *  Returns: true if OK
+ *           false if error
+ */
+static bool write_queued_records(JCR *jcr, RECORD_QUEUE *q)
+{
+   DEV_RECORD *rec;
+   struct timespec to;
+   time_t now, last_dequeue = 0;
+   bool waited = false;
+   bool ok = true;
+
+   for ( ;; ) {
+      /* Send the messages of the read thread at least every second */
+      now = time(NULL);
+      if (now != last_dequeue) {
+         last_dequeue = now;
+         P(q->dir_mutex);
+         dequeue_messages(jcr);
+         V(q->dir_mutex);
+      }
+      /* A fatal error of the read thread sets JS_FatalError */
+      if (job_canceled(jcr)) {
+         ok = false;
+         break;
+      }
+      P(q->mutex);
+      rec = (DEV_RECORD *)q->recs->first();
+      if (!rec && !q->done) {
+         if (!waited) {
+            q->empty_waits++;
+            waited = true;
+         }
+         to.tv_sec = now + 1;
+         to.tv_nsec = 0;
+         pthread_cond_timedwait(&q->cond, &q->mutex, &to);
+         V(q->mutex);
+         continue;
+      }
+      if (rec) {
+         q->recs->remove(rec);
+         q->bytes -= sizeof(DEV_RECORD) + sizeof_pool_memory(rec->data);
+         pthread_cond_broadcast(&q->cond);
+      }
+      V(q->mutex);
+      if (!rec) {
+         break;                       /* all the records are written */
+      }
+      waited = false;
+
+      P(q->dir_mutex);
+      ok = write_vbackup_record(jcr->read_dcr, rec);
+      V(q->dir_mutex);
+      free_record(rec);
+      if (!ok) {
+         break;
+      }
+   }
+   return ok;
+}
+
+/*
+ * Stop the read thread and release the queue
+ *  Returns: what read_records() returned
+ */
+static bool stop_read_queue(JCR *jcr, RECORD_QUEUE *q)
+{
+   bool ok;
+
+   P(q->mutex);
+   q->quit = true;
+   pthread_cond_broadcast(&q->cond);
+   V(q->mutex);
+   pthread_join(q->thread, NULL);
+   ok = q->read_ok;
+   Dmsg3(100, "Read queue: max_used=%lld full_waits=%u empty_waits=%u\n",
+         q->max_used, q->full_waits, q->empty_waits);
+   free_read_queue(jcr, q);
+   dequeue_messages(jcr);
+   return ok;
+}
+
+/*
+ * Used by the status command, called with the jcr locked
+ */
+int get_read_queue_status(JCR *jcr, POOLMEM *&buf)
+{
+   RECORD_QUEUE *q = jcr->read_queue;
+   char b1[50], b2[50], b3[50];
+   int len;
+
+   P(q->mutex);
+   len = Mmsg(buf, _("    ReadQueue: Bytes=%s MaxUsed=%s Limit=%s FullWaits=%u EmptyWaits=%u\n"),
+              edit_uint64_with_commas(q->bytes, b1),
+              edit_uint64_with_commas(q->max_used, b2),
+              edit_uint64_with_commas(q->max_bytes, b3),
+              q->full_waits, q->empty_waits);
+   V(q->mutex);
+   return len;
+}
@@ -0,0 +1,344 @@
+/*
+   Bacula(R) - The Network Backup Solution
+
+   Copyright (C) 2000-2020 Kern Sibbald
+
+   The original author of Bacula is Kern Sibbald, with contributions
+   from many others, a complete list can be found in the file AUTHORS.
+
+   You may use this file and others of this release according to the
+   license defined in the LICENSE file, which includes the Affero General
+   Public License, v3.0 ("AGPLv3") and some additional permissions and
+   terms pursuant to its AGPLv3 Section 7.
+
+   This notice must be preserved when any source code is
+   conveyed and/or propagated.
+
+   Bacula(R) is a registered trademark of Kern Sibbald.
+*/
+/*
+ *   Volume index, the list of the files of a Volume with their
+ *    position, kept next to the Volume when the Device has a
+ *    VolumeIndexDirectory. See vol_index.h for the format.
+ *
+ *   The records are collected in the block when they are written
+ *    (write_header_to_block()), and appended to the index once the
+ *    block is on the Volume (write_block_to_dev()), so the index
+ *    never references data that is not written.
+ */
+
+#include "bacula.h"
+#include "stored.h"
+
+static const int dbglvl = 150;
+
+/*
+ * The records of the index, the ones sent to the Director
+ *  (see send_attrs_to_dir()) and the labels.
+ */
+static bool is_vol_index_record(DEV_RECORD *rec)
+{
+   int32_t stream;
+
+   switch (rec->FileIndex) {
+   case PRE_LABEL:
+   case VOL_LABEL:
+   case SOS_LABEL:
+   case EOS_LABEL:
+      return true;
+   }
+   if (rec->FileIndex < 0) {
+      return false;
+   }
+   stream = rec->Stream & STREAMMASK_TYPE;
+   return stream == STREAM_UNIX_ATTRIBUTES ||
+          stream == STREAM_UNIX_ATTRIBUTES_EX ||
+          stream == STREAM_RESTORE_OBJECT ||
+          crypto_digest_stream_type(stream) != CRYPTO_DIGEST_NONE;
+}
+
+/*
+ * Keep a copy of the record in the block if it belongs to the
+ *  index. Called when the record header is written to the block.
+ */
+void add_vol_index_record(DCR *dcr, DEV_BLOCK *block, DEV_RECORD *rec)
+{
+   DEVRES *device = dcr->dev->device;
+   uint8_t *buf;
+   uint32_t len;
+   ser_declare;
+
+   if (!device || !device->vol_index_directory || block->adata ||
+       !is_vol_index_record(rec)) {
+      return;
+   }
+   len = VOL_INDEX_REC_LENGTH + rec->data_len;
+   if (!block->vol_index) {
+      block->vol_index = get_pool_memory(PM_MESSAGE);
+   }
+   block->vol_index = check_pool_memory_size(block->vol_index,
+                                             block->vol_index_len + len);
+   buf = (uint8_t *)block->vol_index + block->vol_index_len;
+   ser_begin(buf, len);
+   ser_uint32(rec->VolSessionId);
+   ser_uint32(rec->VolSessionTime);
+   ser_int32(rec->FileIndex);
+   ser_int32(rec->Stream);
+   ser_uint32(rec->data_len);
+   ser_bytes(rec->data, rec->data_len);
+   ser_end(buf, len);
+   block->vol_index_len += len;
+   if (rec->FileIndex == VOL_LABEL || rec->FileIndex == PRE_LABEL) {
+      block->vol_index_label = true;
+   }
+}
+
+static bool write_all(int fd, void *buf, uint32_t len)
+{
+   return write(fd, buf, len) == (ssize_t)len;
+}
+
+/*
+ * Append the index records of a block to the index of the Volume,
+ *  the block was just written at StartAddr. Addr is the address given
+ *  to its records when the block is read back (the last byte of the
+ *  block on disk). Called with the device locked. The index of a
+ *  Volume that is labeled is started again.
+ */
+void write_vol_index(DCR *dcr, DEV_BLOCK *block, uint64_t StartAddr, uint64_t Addr)
+{
+   DEVICE *dev = dcr->dev;
+   DEVRES *device = dev->device;
+   char *VolumeName = dev->VolHdr.VolumeName;
+   uint8_t hdr[VOL_INDEX_HDR_LENGTH];
+   uint8_t chunk[VOL_INDEX_CHUNK_LENGTH];
+   POOL_MEM fname(PM_FNAME);
+   struct stat statp;
+   ser_declare;
+
+   if (block->vol_index_len == 0 || !device || !device->vol_index_directory) {
+      return;
+   }
+   if (block->vol_index_label || strcmp(dev->vol_index_name, VolumeName) != 0) {
+      close_vol_index(dev);
+      bstrncpy(dev->vol_index_name, VolumeName, sizeof(dev->vol_index_name));
+      dev->vol_index_error = false;
+   }
+   if (dev->vol_index_error) {
+      return;                         /* already reported for this Volume */
+   }
+   Mmsg(fname, "%s/%s.idx", device->vol_index_directory, VolumeName);
+   if (dev->vol_index_fd < 0) {
+      dev->vol_index_fd = open(fname.c_str(), O_CREAT|O_WRONLY|O_APPEND|O_BINARY|O_CLOEXEC|
+                                  (block->vol_index_label ? O_TRUNC : 0), 0640);
+      if (dev->vol_index_fd < 0 || fstat(dev->vol_index_fd, &statp) < 0) {
+         goto bail_out;
+      }
+      if (statp.st_size == 0) {
+         ser_begin(hdr, sizeof(hdr));
+         ser_uint32(VOL_INDEX_MAGIC);
+         ser_uint32(VOL_INDEX_VERSION);
+         ser_uint32(block->vol_index_label ? VOL_INDEX_COMPLETE : 0);
+         ser_bytes(VolumeName, MAX_NAME_LENGTH);
+         ser_end(hdr, sizeof(hdr));
+         if (!write_all(dev->vol_index_fd, hdr, sizeof(hdr))) {
+            goto bail_out;
+         }
+      }
+      Dmsg2(dbglvl, "Opened Volume index %s size=%lld\n", fname.c_str(),
+            (long long)statp.st_size);
+   }
+   ser_begin(chunk, sizeof(chunk));
+   ser_uint64(StartAddr);
+   ser_uint64(Addr);
+   ser_uint32(block->vol_index_len);
+   ser_end(chunk, sizeof(chunk));
+   if (!write_all(dev->vol_index_fd, chunk, sizeof(chunk)) ||
+       !write_all(dev->vol_index_fd, block->vol_index, block->vol_index_len)) {
+      goto bail_out;
+   }
+   return;
+
+bail_out:
+   /* An index with a hole would hide files, do not keep it */
+   berrno be;
+   Jmsg(dcr->jcr, M_WARNING, 0, _("Cannot write Volume index %s, it is removed. ERR=%s\n"),
+        fname.c_str(), be.bstrerror());
+   close_vol_index(dev);
+   unlink(fname.c_str());
+   dev->vol_index_error = true;
+}
+
+void close_vol_index(DEVICE *dev)
+{
+   if (dev->vol_index_fd >= 0) {
+      close(dev->vol_index_fd);
+      dev->vol_index_fd = -1;
+   }
+}
+
+/*
+ * Open an index file for reading, NULL on error
+ */
+VOL_INDEX *open_vol_index(JCR *jcr, const char *fname)
+{
+   VOL_INDEX *vi;
+   uint8_t hdr[VOL_INDEX_HDR_LENGTH];
+   uint32_t magic, version;
+   ser_declare;
+
+   vi = (VOL_INDEX *)malloc(sizeof(VOL_INDEX));
+   bmemset(vi, 0, sizeof(VOL_INDEX));
+   vi->fname = get_pool_memory(PM_FNAME);
+   pm_strcpy(vi->fname, fname);
+   if ((vi->fp = bfopen(fname, "rb")) == NULL) {
+      berrno be;
+      Jmsg(jcr, M_ERROR, 0, _("Cannot open Volume index %s. ERR=%s\n"),
+           fname, be.bstrerror());
+      goto bail_out;
+   }
+   if (fread(hdr, 1, sizeof(hdr), vi->fp) != sizeof(hdr)) {
+      Jmsg(jcr, M_ERROR, 0, _("Volume index %s is too short.\n"), fname);
+      goto bail_out;
+   }
+   unser_begin(hdr, sizeof(hdr));
+   unser_uint32(magic);
+   unser_uint32(version);
+   unser_uint32(vi->flags);
+   unser_bytes(vi->VolumeName, MAX_NAME_LENGTH);
+   unser_end(hdr, sizeof(hdr));
+   vi->VolumeName[MAX_NAME_LENGTH-1] = 0;
+   if (magic != VOL_INDEX_MAGIC || version != VOL_INDEX_VERSION) {
+      Jmsg(jcr, M_ERROR, 0, _("%s is not a Volume index, or has an unknown version %u.\n"),
+           fname, version);
+      goto bail_out;
+   }
+   return vi;
+
+bail_out:
+   free_vol_index(vi);
+   return NULL;
+}
+
+void free_vol_index(VOL_INDEX *vi)
+{
+   if (vi->fp) {
+      fclose(vi->fp);
+   }
+   free_pool_memory(vi->fname);
+   free(vi);
+}
+
+/*
+ * Read the next record of the index. The addresses of the record
+ *  are the ones of its block, like the records returned by
+ *  read_records(). Returns false at the end of the index or on
+ *  error (vi->error set).
+ */
+bool read_vol_index_record(JCR *jcr, VOL_INDEX *vi, DEV_RECORD *rec)
+{
+   uint8_t buf[VOL_INDEX_REC_LENGTH];
+   uint32_t data_len;
+   size_t len;
+   ser_declare;
+
+   while (vi->remainder == 0) {
+      len = fread(buf, 1, VOL_INDEX_CHUNK_LENGTH, vi->fp);
+      if (len == 0 && feof(vi->fp)) {
+         return false;                /* end of the index */
+      }
+      if (len != VOL_INDEX_CHUNK_LENGTH) {
+         goto bail_out;
+      }
+      unser_begin(buf, VOL_INDEX_CHUNK_LENGTH);
+      unser_uint64(vi->StartAddr);
+      unser_uint64(vi->Addr);
+      unser_uint32(vi->remainder);
+      unser_end(buf, VOL_INDEX_CHUNK_LENGTH);
+   }
+   if (vi->remainder < VOL_INDEX_REC_LENGTH ||
+       fread(buf, 1, VOL_INDEX_REC_LENGTH, vi->fp) != VOL_INDEX_REC_LENGTH) {
+      goto bail_out;
+   }
+   unser_begin(buf, VOL_INDEX_REC_LENGTH);
+   unser_uint32(rec->VolSessionId);
+   unser_uint32(rec->VolSessionTime);
+   unser_int32(rec->FileIndex);
+   unser_int32(rec->Stream);
+   unser_uint32(data_len);
+   unser_end(buf, VOL_INDEX_REC_LENGTH);
+   if (data_len > vi->remainder - VOL_INDEX_REC_LENGTH) {
+      goto bail_out;
+   }
+   rec->data = check_pool_memory_size(rec->data, data_len + 1);
+   if (fread(rec->data, 1, data_len, vi->fp) != data_len) {
+      goto bail_out;
+   }
+   rec->data[data_len] = 0;
+   rec->data_len = data_len;
+   rec->remainder = 0;
+   rec->maskedStream = rec->Stream & STREAMMASK_TYPE;
+   rec->StartAddr = vi->StartAddr;
+   rec->Addr = vi->Addr;
+   vi->remainder -= VOL_INDEX_REC_LENGTH + data_len;
+   return true;
+
+bail_out:
+   Jmsg(jcr, M_ERROR, 0, _("Volume index %s is truncated or corrupted near address %llu.\n"),
+        vi->fname, (unsigned long long)vi->StartAddr);
+   vi->error = true;
+   return false;
+}
+
+/*
+ * Pass the records of a Volume index to record_cb() as read_records()
+ *  does with the records of the Volume. The Volume must be mounted on
+ *  the device of the dcr, only its label is read. dev->EndAddr follows
+ *  the records, as when the Volume is read.
+ */
+bool read_vol_index_records(DCR *dcr, const char *fname,
+                            bool record_cb(DCR *dcr, DEV_RECORD *rec))
+{
+   JCR *jcr = dcr->jcr;
+   DEVICE *dev = dcr->dev;
+   DEV_RECORD *rec;
+   VOL_INDEX *vi;
+   uint64_t StartAddr = 0, Addr = 0;
+   bool ok = true;
+
+   if ((vi = open_vol_index(jcr, fname)) == NULL) {
+      return false;
+   }
+   if (strcmp(vi->VolumeName, dev->VolHdr.VolumeName) != 0) {
+      Jmsg(jcr, M_ERROR, 0, _("Volume index %s is for Volume \"%s\", not \"%s\".\n"),
+           fname, vi->VolumeName, dev->VolHdr.VolumeName);
+      free_vol_index(vi);
+      return false;
+   }
+   rec = new_record();
+   while (ok && read_vol_index_record(jcr, vi, rec)) {
+      if (job_canceled(jcr)) {
+         ok = false;
+         break;
+      }
+      StartAddr = rec->StartAddr;
+      Addr = rec->Addr;
+      dev->EndAddr = Addr;
+      ok = record_cb(dcr, rec);
+   }
+   if (vi->error) {
+      ok = false;
+   }
+   if (ok) {
+      /* End of the Volume, see read_records() */
+      rec->FileIndex = EOT_LABEL;
+      rec->Stream = rec->maskedStream = 0;
+      rec->data_len = 0;
+      rec->StartAddr = StartAddr;
+      rec->Addr = Addr;
+      ok = record_cb(dcr, rec);
+   }
+   free_record(rec);
+   free_vol_index(vi);
+   return ok;
+}
@@ -0,0 +1,59 @@
+/*
+   Bacula(R) - The Network Backup Solution
+
+   Copyright (C) 2000-2020 Kern Sibbald
+
+   The original author of Bacula is Kern Sibbald, with contributions
+   from many others, a complete list can be found in the file AUTHORS.
+
+   You may use this file and others of this release according to the
+   license defined in the LICENSE file, which includes the Affero General
+   Public License, v3.0 ("AGPLv3") and some additional permissions and
+   terms pursuant to its AGPLv3 Section 7.
+
+   This notice must be preserved when any source code is
+   conveyed and/or propagated.
+
+   Bacula(R) is a registered trademark of Kern Sibbald.
+*/
+/*
+ * Volume index definitions -- see vol_index.c
+ *
+ * The index of a Volume is a file <VolumeIndexDirectory>/<VolumeName>.idx
+ *  with a header followed by one chunk per block written to the Volume:
+ *
+ *   header: magic, version, flags, VolumeName[MAX_NAME_LENGTH]
+ *   chunk:  block start and end address (uint64), length of the records (uint32)
+ *   record: VolSessionId, VolSessionTime, FileIndex, Stream, data_len, data
+ *
+ * Only the records sent to the Director are kept (labels, attributes,
+ *  restore objects and digests), so bls, bscan and bextract can find
+ *  the files of a Volume without reading its data.
+ */
+
+#ifndef __VOL_INDEX_H
+#define __VOL_INDEX_H 1
+
+#define VOL_INDEX_MAGIC     0x56494458     /* "VIDX" */
+#define VOL_INDEX_VERSION   1
+
+/* Header flags */
+#define VOL_INDEX_COMPLETE  (1<<0)         /* started with the Volume label */
+
+#define VOL_INDEX_HDR_LENGTH   (3*sizeof(uint32_t) + MAX_NAME_LENGTH)
+#define VOL_INDEX_CHUNK_LENGTH (2*sizeof(uint64_t) + sizeof(uint32_t))
+#define VOL_INDEX_REC_LENGTH   (5*sizeof(uint32_t))
+
+/* Used to read an index file */
+struct VOL_INDEX {
+   FILE *fp;                          /* index file */
+   POOLMEM *fname;                    /* its name, for messages */
+   uint32_t flags;                    /* header flags */
+   char VolumeName[MAX_NAME_LENGTH];  /* Volume of the index */
+   uint64_t StartAddr;                /* start of the current block */
+   uint64_t Addr;                     /* its address as seen by the reader */
+   uint32_t remainder;                /* bytes left in the current chunk */
+   bool error;                        /* set if the index is corrupted */
+};
+
+#endif /* __VOL_INDEX_H */
@@ -160,9 +160,10 @@ PROG_COPYRIGHT
 "       -j <dir>      sets the location of the journal file to <dir>\n"
 "       -s <dir>      sets spool directory to <dir>\n"
 "       -f <dir>      watches the directory <dir> for changes.\n"
+"       -k <nn>       keeps <nn> versions of each file in the journal (default %d, 0 keeps all)\n"
 "       -d <nn>       set debug level to <nn>\n"
 "       -?            print this message.\n"
-"\n"), 2004, BDEMO, VERSION, BDATE, HOST_OS, DISTNAME, DISTVER);
+"\n"), 2004, BDEMO, VERSION, BDATE, HOST_OS, DISTNAME, DISTVER, JOURNAL_MAX_VERSIONS);
 }
 
 /**
@@ -180,7 +181,7 @@ int main(int argc, char *argv[])
     Journal journal;
     lmgr_init_thread();
 
-    while ((ch = getopt(argc, argv, "f:s:j:d:h?")) != -1) {
+    while ((ch = getopt(argc, argv, "f:s:j:k:d:h?")) != -1) {
        switch (ch) {
        case 's':
           free_and_null_pool_memory(spool_dir);
@@ -201,6 +202,13 @@ int main(int argc, char *argv[])
           fpath = bstrdup(optarg);
           folders.append((void *) fpath);
           break;
+       case 'k':
+          if (!is_an_integer(optarg)) {
+             printHelp();
+             exit(1);
+          }
+          journal.maxVersions = atoi(optarg);
+          break;
        case 'd':
           debug_level = atoi(optarg);
           if (debug_level <= 0) {
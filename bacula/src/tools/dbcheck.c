@@ -48,6 +48,39 @@ typedef struct s_name_ctx {
    int tot_ids;                       /* total to process */
 } NAME_LIST;
 
+/* Parameters to open the catalog connections */
+typedef struct s_db_params {
+   const char *db_name;
+   const char *user;
+   const char *password;
+   const char *dbhost;
+   int dbport;
+   const char *dbsslmode;
+   const char *dbsslkey;
+   const char *dbsslcert;
+   const char *dbsslca;
+   const char *dbsslcapath;
+   const char *dbsslcipher;
+} DB_PARAMS;
+
+/*
+ * Check of a table by ranges of its primary key (-j and -i options).
+ *  The ranges are given to the workers, each one with its own
+ *  catalog connection.
+ */
+typedef struct s_range_check {
+   const char *table;                 /* table to check */
+   const char *key;                   /* primary key of the table */
+   const char *query;                 /* orphaned records between two keys */
+   bool incremental;                  /* start after the watermark with -i */
+   /* Updated by the workers, protected by range_mutex */
+   int64_t next;                      /* next key to check */
+   int64_t last;                      /* last key to check */
+   int64_t found;                     /* orphaned records found */
+   int64_t deleted;                   /* orphaned records deleted */
+   bool error;
+} RANGE_CHECK;
+
 /* Global variables */ 
 
 static bool fix = false;
@@ -60,6 +93,10 @@ static bool quit = false;
 static CONFIG *config;
 static const char *idx_tmp_name;
 static uint64_t nb_changes = 300000;
+static DB_PARAMS db_params;
+static int nb_workers = 0;              /* catalog connections used by the range checks */
+static bool incremental = false;
+static pthread_mutex_t range_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 #define MAX_ID_LIST_LEN 10000000
 
@@ -81,6 +118,8 @@ static void eliminate_admin_records();
 static void eliminate_restore_records();
 static void eliminate_verify_records();
 static void repair_bad_paths();
+static void check_orphaned_records_by_range();
+static bool bvfs_cache_in_use();
 static void do_interactive_mode();
 static bool yes_no(const char *prompt);
 static bool check_idx(const char *col_name);
@@ -101,6 +140,8 @@ PROG_COPYRIGHT
 "       -B              print catalog configuration and exit\n"
 "       -d <nn>         set debug level to <nn>\n"
 "       -n <nn>         custom number of records selected at a time for large pruning operations done in a loop (orphan paths/files, ...)\n"
+"       -j <nn>         check the orphaned JobMedia/File/Path records by key ranges with <nn> connections (batch mode)\n"
+"       -i              check only the JobMedia/File records added since the last run of -i (batch mode)\n"
 "       -dt             print a timestamp in debug output\n"
 "       -f              fix inconsistencies\n"
 "       -v              verbose\n"
@@ -133,11 +174,20 @@ int main (int argc, char *argv[])
    memset(&id_list, 0, sizeof(id_list));
    memset(&name_list, 0, sizeof(name_list));
 
-   while ((ch = getopt(argc, argv, "bc:C:d:fvB?n:")) != -1) { 
+   while ((ch = getopt(argc, argv, "bc:C:d:fvB?n:ij:")) != -1) { 
       switch (ch) {
       case 'n':                    /* Number of changes we can make in one run */
          nb_changes = str_to_uint64(optarg);
          break;
+      case 'i':                    /* Incremental range checks */
+         incremental = true;
+         break;
+      case 'j':                    /* Connections used by the range checks */
+         nb_workers = atoi(optarg);
+         if (nb_workers <= 0) {
+            nb_workers = 1;
+         }
+         break;
       case 'B':
          print_catalog = true;     /* get catalog information from config */
          break;
@@ -303,6 +353,21 @@ int main (int argc, char *argv[])
       } /* if (argc >= 2) */
    }
 
+   if (nb_changes == 0) {
+      nb_changes = 1;
+   }
+   db_params.db_name = db_name;
+   db_params.user = user;
+   db_params.password = password;
+   db_params.dbhost = dbhost;
+   db_params.dbport = dbport;
+   db_params.dbsslmode = dbsslmode;
+   db_params.dbsslkey = dbsslkey;
+   db_params.dbsslcert = dbsslcert;
+   db_params.dbsslca = dbsslca;
+   db_params.dbsslcapath = dbsslcapath;
+   db_params.dbsslcipher = dbsslcipher;
+
    /* Open database */
    db = db_init_database(NULL, NULL, db_name, user, password, dbhost,
                          dbport, NULL, dbsslmode, dbsslkey, dbsslcert, dbsslca,
@@ -319,9 +384,13 @@ int main (int argc, char *argv[])
    if (batch) {
       repair_bad_paths();
       eliminate_duplicate_paths();
-      eliminate_orphaned_jobmedia_records();
-      eliminate_orphaned_file_records();
-      eliminate_orphaned_path_records();
+      if (nb_workers > 0 || incremental) {
+         check_orphaned_records_by_range();
+      } else {
+         eliminate_orphaned_jobmedia_records();
+         eliminate_orphaned_file_records();
+         eliminate_orphaned_path_records();
+      }
       eliminate_orphaned_fileset_records();
       eliminate_orphaned_client_records();
       eliminate_orphaned_job_records();
@@ -779,19 +848,28 @@ static void eliminate_orphaned_file_records()
    }
 }
 
-static void eliminate_orphaned_path_records()
+/*
+ * The BVFS code uses Path records that are not in the File table, for
+ *  example if a Job has /home/test/ BVFS will need to create a Path record /
+ *  and /home/ to work correctly
+ */
+static bool bvfs_cache_in_use()
 {
    db_int64_ctx lctx;
    lctx.count=0;
    db_sql_query(db, "SELECT 1 FROM Job WHERE HasCache=1 LIMIT 1", 
                 db_int64_handler, &lctx);
 
-   /* The BVFS code uses Path records that are not in the File table, for
-    * example if a Job has /home/test/ BVFS will need to create a Path record /
-    * and /home/ to work correctly
-    */
    if (lctx.count == 1) {
       printf(_("To prune orphaned Path entries, it is necessary to clear the BVFS Cache first with the bconsole \".bvfs_clear_cache yes\" command.\n"));
+      return true;
+   }
+   return false;
+}
+
+static void eliminate_orphaned_path_records()
+{
+   if (bvfs_cache_in_use()) {
       return;
    }
 
@@ -1122,6 +1200,318 @@ static void repair_bad_paths()
    }
 }
 
+/*
+ * Open a new connection to the catalog for a worker
+ */
+static BDB *open_worker_db()
+{
+   BDB *wdb;
+
+   wdb = db_init_database(NULL, NULL, db_params.db_name, db_params.user,
+                          db_params.password, db_params.dbhost,
+                          db_params.dbport, NULL, db_params.dbsslmode,
+                          db_params.dbsslkey, db_params.dbsslcert,
+                          db_params.dbsslca, db_params.dbsslcapath,
+                          db_params.dbsslcipher, true /* private */, false);
+   if (!wdb || !db_open_database(NULL, wdb)) {
+      printf("%s\n", db_strerror(wdb));
+      if (wdb) {
+         db_close_database(NULL, wdb);
+      }
+      return NULL;
+   }
+   return wdb;
+}
+
+/*
+ * The watermarks of the incremental checks are kept in
+ *  <working-directory>/dbcheck.<bacula-database>.state
+ *  with one "<table> <last key checked>" line per table.
+ */
+static void make_watermark_file_name(POOLMEM **fname)
+{
+   Mmsg(fname, "%s/dbcheck.%s.state", working_directory, db_params.db_name);
+}
+
+static int64_t get_watermark(const char *table)
+{
+   POOL_MEM fname(PM_FNAME);
+   char line[MAXSTRING], name[MAX_NAME_LENGTH];
+   int64_t value = 0;
+   long long val;
+   FILE *fp;
+
+   make_watermark_file_name(fname.handle());
+   if ((fp = bfopen(fname.c_str(), "r")) == NULL) {
+      return 0;
+   }
+   while (bfgets(line, sizeof(line), fp)) {
+      if (sscanf(line, "%127s %lld", name, &val) == 2 && strcmp(name, table) == 0) {
+         value = val;
+      }
+   }
+   fclose(fp);
+   return value;
+}
+
+static void set_watermark(const char *table, int64_t value)
+{
+   POOL_MEM fname(PM_FNAME), tmp(PM_FNAME);
+   char line[MAXSTRING], name[MAX_NAME_LENGTH];
+   FILE *fp, *fpout;
+
+   make_watermark_file_name(fname.handle());
+   Mmsg(tmp, "%s.tmp", fname.c_str());
+   if ((fpout = bfopen(tmp.c_str(), "w")) == NULL) {
+      berrno be;
+      printf(_("Could not create %s. ERR=%s\n"), tmp.c_str(), be.bstrerror());
+      return;
+   }
+   /* Keep the lines of the other tables */
+   if ((fp = bfopen(fname.c_str(), "r")) != NULL) {
+      while (bfgets(line, sizeof(line), fp)) {
+         if (sscanf(line, "%127s", name) == 1 && strcmp(name, table) != 0) {
+            fputs(line, fpout);
+         }
+      }
+      fclose(fp);
+   }
+   fprintf(fpout, "%s %lld\n", table, (long long)value);
+   if (fclose(fpout) != 0 || rename(tmp.c_str(), fname.c_str()) != 0) {
+      berrno be;
+      printf(_("Could not write %s. ERR=%s\n"), fname.c_str(), be.bstrerror());
+      unlink(tmp.c_str());
+   }
+}
+
+/*
+ * Delete the ids of a chunk with a few large queries
+ */
+static bool delete_range_ids(BDB *wdb, RANGE_CHECK *rc, ID_LIST *lst)
+{
+   POOL_MEM query(PM_MESSAGE);
+   char ed1[50];
+   bool ok = true;
+   int i, j;
+
+   db_start_transaction(NULL, wdb);
+   for (i=0; ok && i < lst->num_ids; ) {
+      Mmsg(query, "DELETE FROM %s WHERE %s IN (", rc->table, rc->key);
+      for (j=0; j < 1000 && i < lst->num_ids; j++, i++) {
+         if (j > 0) {
+            pm_strcat(query, ",");
+         }
+         pm_strcat(query, edit_int64(lst->Id[i], ed1));
+      }
+      pm_strcat(query, ")");
+      if (verbose > 2) {
+         printf("%s\n", query.c_str());
+      }
+      if (!db_sql_query(wdb, query.c_str(), NULL, NULL)) {
+         printf("%s\n", db_strerror(wdb));
+         ok = false;
+      }
+   }
+   db_end_transaction(NULL, wdb);
+   return ok;
+}
+
+/*
+ * Worker of the range checks, it takes the next range of keys
+ *  until the end of the table. Only the orphaned records of the
+ *  current range are kept in memory.
+ */
+extern "C" void *range_check_thread(void *arg)
+{
+   RANGE_CHECK *rc = (RANGE_CHECK *)arg;
+   POOL_MEM query(PM_MESSAGE);
+   ID_LIST lst;
+   int64_t first, end;
+   char ed1[50], ed2[50];
+   BDB *wdb;
+
+   memset(&lst, 0, sizeof(lst));
+   if ((wdb = open_worker_db()) == NULL) {
+      P(range_mutex);
+      rc->error = true;
+      V(range_mutex);
+      return NULL;
+   }
+   for ( ;; ) {
+      P(range_mutex);
+      if (rc->error || rc->next > rc->last) {
+         V(range_mutex);
+         break;
+      }
+      first = rc->next;
+      end = first + (int64_t)nb_changes - 1;
+      rc->next = end + 1;
+      V(range_mutex);
+
+      Mmsg(query, rc->query, edit_int64(first, ed1), edit_int64(end, ed2));
+      if (verbose > 1) {
+         printf("%s\n", query.c_str());
+      }
+      lst.num_ids = 0;
+      if (!db_sql_query(wdb, query.c_str(), id_list_handler, (void *)&lst)) {
+         printf("%s\n", db_strerror(wdb));
+         goto bail_out;
+      }
+      if (lst.num_ids == 0) {
+         continue;
+      }
+      if (verbose) {
+         P(range_mutex);
+         printf(_("Found %d orphaned %s records between %s=%s and %s:\n"),
+                lst.num_ids, rc->table, rc->key, ed1, ed2);
+         for (int i=0; i < lst.num_ids; i++) {
+            printf("%s\n", edit_int64(lst.Id[i], ed1));
+         }
+         V(range_mutex);
+      }
+      if (fix && !delete_range_ids(wdb, rc, &lst)) {
+         goto bail_out;
+      }
+      P(range_mutex);
+      rc->found += lst.num_ids;
+      if (fix) {
+         rc->deleted += lst.num_ids;
+      }
+      V(range_mutex);
+   }
+   goto get_out;
+
+bail_out:
+   P(range_mutex);
+   rc->error = true;
+   V(range_mutex);
+
+get_out:
+   if (lst.Id) {
+      free(lst.Id);
+   }
+   db_close_database(NULL, wdb);
+   return NULL;
+}
+
+/*
+ * Check one table by ranges of keys with nb_workers connections
+ */
+static void check_range(RANGE_CHECK *rc)
+{
+   pthread_t *tids;
+   db_int64_ctx lctx;
+   char ed1[50], ed2[50];
+   int64_t watermark = 0;
+   int nb = MAX(nb_workers, 1);
+   int created = 0, status;
+
+   rc->found = rc->deleted = 0;
+   rc->error = false;
+
+   bsnprintf(buf, sizeof(buf), "SELECT MIN(%s) FROM %s", rc->key, rc->table);
+   lctx.value = lctx.count = 0;
+   db_sql_query(db, buf, db_int64_handler, &lctx);
+   rc->next = lctx.value;
+
+   bsnprintf(buf, sizeof(buf), "SELECT MAX(%s) FROM %s", rc->key, rc->table);
+   lctx.value = lctx.count = 0;
+   if (!db_sql_query(db, buf, db_int64_handler, &lctx)) {
+      printf("%s\n", db_strerror(db));
+      return;
+   }
+   rc->last = lctx.value;
+
+   if (incremental && rc->incremental) {
+      watermark = get_watermark(rc->table);
+      rc->next = MAX(rc->next, watermark + 1);
+   }
+   if (rc->next > rc->last) {
+      printf(_("No new %s records to check.\n"), rc->table);
+      return;
+   }
+   printf(_("Checking for orphaned %s entries between %s=%s and %s.\n"), rc->table,
+          rc->key, edit_int64(rc->next, ed1), edit_int64(rc->last, ed2));
+
+   tids = (pthread_t *)malloc(sizeof(pthread_t) * nb);
+   for (int i=0; i < nb; i++) {
+      if ((status = pthread_create(&tids[created], NULL, range_check_thread, rc)) != 0) {
+         berrno be;
+         printf(_("Cannot create worker thread: %s\n"), be.bstrerror(status));
+         break;
+      }
+      created++;
+   }
+   if (created == 0) {
+      rc->error = true;
+   }
+   for (int i=0; i < created; i++) {
+      pthread_join(tids[i], NULL);
+   }
+   free(tids);
+
+   printf(_("Found %s orphaned %s records.\n"), edit_int64(rc->found, ed1), rc->table);
+   if (fix && rc->deleted > 0) {
+      printf(_("Deleted %s orphaned %s records.\n"), edit_int64(rc->deleted, ed1), rc->table);
+   }
+   /* Orphaned records not deleted are reported again by the next run */
+   if (rc->incremental && !rc->error && (fix || rc->found == 0)) {
+      set_watermark(rc->table, rc->last);
+   }
+}
+
+/*
+ * Check the orphaned JobMedia, File and Path records by ranges of
+ *  their primary key. The ranges are done in parallel, and with -i
+ *  only the JobMedia and File records created after the previous
+ *  run are checked. Any record can become an orphaned Path record,
+ *  so the Path table is always checked in full.
+ */
+static void check_orphaned_records_by_range()
+{
+   RANGE_CHECK rc;
+
+   memset(&rc, 0, sizeof(rc));
+   rc.table = "JobMedia";
+   rc.key = "JobMediaId";
+   rc.query = "SELECT JobMedia.JobMediaId FROM JobMedia "
+                "LEFT OUTER JOIN Job ON (JobMedia.JobId=Job.JobId) "
+               "WHERE JobMedia.JobMediaId >= %s AND JobMedia.JobMediaId <= %s "
+                 "AND Job.JobId IS NULL";
+   rc.incremental = true;
+   check_range(&rc);
+
+   memset(&rc, 0, sizeof(rc));
+   rc.table = "File";
+   rc.key = "FileId";
+   rc.query = "SELECT File.FileId FROM File "
+                "LEFT OUTER JOIN Job ON (File.JobId=Job.JobId) "
+               "WHERE File.FileId >= %s AND File.FileId <= %s "
+                 "AND Job.JobId IS NULL";
+   rc.incremental = true;
+   check_range(&rc);
+
+   if (bvfs_cache_in_use()) {
+      return;
+   }
+   idx_tmp_name = NULL;
+   /* The lookup of each PathId in the File table needs an index */
+   if (!check_idx("PathId"))  {
+      if (yes_no(_("Create temporary index? (yes/no): "))) {
+         create_tmp_idx("idxPIchk", "File", "PathId");
+      }
+   }
+   memset(&rc, 0, sizeof(rc));
+   rc.table = "Path";
+   rc.key = "PathId";
+   rc.query = "SELECT Path.PathId FROM Path "
+               "WHERE Path.PathId >= %s AND Path.PathId <= %s "
+                 "AND NOT EXISTS (SELECT 1 FROM File WHERE File.PathId=Path.PathId)";
+   rc.incremental = false;
+   check_range(&rc);
+   drop_tmp_idx("idxPIchk", "File");
+}
+
 /*
  * Gen next input command from the terminal
  */
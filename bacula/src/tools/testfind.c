@@ -579,6 +579,10 @@ static void set_options(findFOPTS *fo, const char *opts)
             p++;
             break;
 #endif
+         case '4':
+            fo->flags |= FO_XXH128;
+            p++;
+            break;
          default:
             /* Automatically downgrade to SHA-1 if an unsupported
              * SHA variant is specified */